@@ -158,6 +158,7 @@ public:
 
     static const HashMethod HashMethodDefault = DEF_HASH_DEFAULT;
     static const HashMethod HashMethodCaseInsensitive = DEF_HASH_CASE_INSENSITIVE;
+    static const HashMethod HashMethodStrong = DEF_HASH_STRONG;
 
     static bool IsValidPoolIndex(Atom::Index index) { return (index > 0) && (index <= DEF_ATOM_MAX_INDEX); }
 
@@ -492,6 +493,56 @@ private:
     Atom::PoolIndex m_nPools;
 };
 
+/*!
+     * An in-memory open-addressing table mapping strings to atom indexes,
+     * built from an existing pool.  Pools whose serialized form has no
+     * usable hash table build one of these lazily so that lookups don't
+     * have to scan every atom.  The table only narrows the search to
+     * candidates with a matching hash; callers still compare the strings.
+     */
+class AtomHashIndex : public DefObject
+{
+public:
+    // Pools with this many atoms or fewer are cheaper to scan directly
+    static const Atom::Index MinAtomsToIndex = 8;
+
+    static HRESULT CreateInstance(_In_ const IAtomPool* pPool, _Outptr_ AtomHashIndex** result);
+
+    virtual ~AtomHashIndex();
+
+    Atom::Hash HashString(_In_ PCWSTR str) const { return Atom::HashString(str, m_hashMethod); }
+
+    UINT32 GetFirstSlot(_In_ Atom::Hash hash) const { return (hash & m_mask); }
+
+    /*!
+         * Advances *slot to the next entry whose hash matches and returns
+         * its atom index.  Returns false once the probe sequence ends.
+         */
+    _Success_(return == true)
+    bool TryGetNextCandidate(_In_ Atom::Hash hash, _Inout_ UINT32* slot, _Out_ Atom::Index* resultIndex) const;
+
+    /*!
+         * Publishes a lazily built index into *ppIndex, building it from
+         * pPool on first use.  Returns nullptr if the pool is too small to
+         * be worth indexing or the index could not be built; callers fall
+         * back to their own search in that case.
+         */
+    static const AtomHashIndex* GetOrCreate(_In_ const IAtomPool* pPool, _Inout_ AtomHashIndex* volatile* ppIndex);
+
+protected:
+    struct Entry
+    {
+        Atom::Hash hash;
+        UINT32 indexPlusOne; // zero marks an empty slot
+    };
+
+    AtomHashIndex() : m_hashMethod(Atom::HashMethodStrong), m_mask(0), m_pEntries(nullptr) {}
+
+    Atom::HashMethod m_hashMethod;
+    UINT32 m_mask;
+    _Field_size_(m_mask + 1) Entry* m_pEntries;
+};
+
 /*!
      * An atom pool initialized directly from an array of static strings.
      * Uses the supplied strings directly, so they must remain valid for
@@ -506,6 +557,7 @@ protected:
     _Field_size_(m_numStrings) const PCWSTR* m_ppStrings;
     int m_numStrings;
     DEFCOMPAREOPTIONS m_compareOptions;
+    mutable AtomHashIndex* volatile m_pLookupIndex;
 
     StaticAtomPool(
         _In_reads_opt_(numStrings) const PCWSTR* stringsArray,
@@ -517,7 +569,8 @@ protected:
         m_pDescription(description),
         m_ppStrings(stringsArray),
         m_numStrings(numStrings),
-        m_compareOptions(compareOptions)
+        m_compareOptions(compareOptions),
+        m_pLookupIndex(nullptr)
     {}
 
 public:
@@ -555,6 +608,8 @@ public:
         return CreateInstance(stringsArray, numStrings, description, flags, pool);
     }
 
+    virtual ~StaticAtomPool();
+
     //IAtomPool implementation
     bool Contains(_In_ PCWSTR str) const;
 
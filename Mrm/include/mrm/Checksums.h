@@ -145,6 +145,35 @@ public:
         _In_ UINT32 numAtoms,
         _Out_ Checksum* checksum);
 
+    /*!
+     * The atom strings of an atom pool checksum, checksummed on their own (starting from 0)
+     * so that they can be extended as atoms are appended to the pool and then combined with
+     * whatever precedes them.
+     */
+    typedef struct _AtomPoolStringsChecksum
+    {
+        const IAtomPool* pool;
+        UINT32 numAtoms; // atoms included so far
+        UINT64 cbData;   // bytes the checksum covers
+        Checksum checksum;
+    } AtomPoolStringsChecksum;
+
+    /*!
+     * Same as ComputeAtomPoolChecksum above, but keeps the checksum of the atom strings in
+     * state, so that later calls for the same pool only add the atoms appended since.
+     * state must be zero-initialized before first use; it is reset automatically if the pool
+     * changes or fewer atoms are requested.
+     *
+     * \return HRESULT
+     * - as for ComputeAtomPoolChecksum
+     */
+    static HRESULT ComputeAtomPoolChecksum(
+        _In_ Checksum partialChecksum,
+        _In_opt_ const IAtomPool* pool,
+        _In_ UINT32 numAtoms,
+        _Inout_ AtomPoolStringsChecksum* state,
+        _Out_ Checksum* checksum);
+
     /*! 
      * Adds an atom to a DEF checksum.  An atom is added as:
      * 1) The fully-qualified name of the pool that contains it, as a 
@@ -155,6 +155,9 @@ public:
 
     void Reset() { m_nData = 0; }
 
+    // Grows geometrically like Add, so callers that reserve batch by batch don't realloc every time.
+    HRESULT Reserve(_In_ UINT capacity) { return Extend(capacity, false); }
+
     HRESULT SetExtent(_In_ UINT extent)
     {
         RETURN_HR_IF_EXPECTED(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_FILE_TYPE), extent < m_nData);
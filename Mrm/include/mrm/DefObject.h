@@ -69,4 +69,58 @@ public:
     ~DefObject() {}
 };
 
+// Monotonic allocator for large numbers of small, long-lived builder objects.
+// Memory is handed out from large zeroed blocks and only released, all at once,
+// when the arena is deleted.  Allocation is serialized so an arena can be shared
+// by builders that finalize concurrently.
+class DefArena : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_Outptr_ DefArena** result);
+
+    ~DefArena();
+
+    _Ret_maybenull_ void* AllocZeroed(_In_ size_t size);
+
+    // Allocation helpers for DefArenaObject.  Each object is prefixed with the
+    // arena it came from (nullptr for the process heap) so that delete can
+    // tell the two apart.
+    static _Ret_maybenull_ void* AllocObject(_In_opt_ DefArena* pArena, _In_ size_t size);
+    static void FreeObject(_In_opt_ void* p);
+
+    static const size_t BlockSize = 64 * 1024;
+
+private:
+    struct Block
+    {
+        Block* pNext;
+        size_t cbSize;
+        size_t cbUsed;
+    };
+
+    DefArena();
+
+    Block* m_pBlocks;
+    _DEF_SRWLOCK m_lock;
+};
+
+// Base for objects that can optionally be placed in a DefArena with
+// "new (pArena) T(...)".  Plain "new T(...)" still uses the process heap.
+template <class TBase = DefObject>
+class DefArenaObject : public TBase
+{
+public:
+    static void* operator new(size_t size) { return DefArena::AllocObject(nullptr, size); }
+
+    static void* operator new(size_t size, const nothrow_t&) { return DefArena::AllocObject(nullptr, size); }
+
+    static void* operator new(size_t size, _In_opt_ DefArena* pArena) { return DefArena::AllocObject(pArena, size); }
+
+    static void __cdecl operator delete(_In_opt_ void* p) { DefArena::FreeObject(p); }
+
+    static void operator delete(_In_opt_ void* p, const nothrow_t&) { DefArena::FreeObject(p); }
+
+    static void operator delete(_In_opt_ void* p, _In_opt_ DefArena*) { DefArena::FreeObject(p); }
+};
+
 } // namespace Microsoft::Resources
\ No newline at end of file
@@ -8,6 +8,53 @@ namespace Microsoft::Resources
 
 class IDecisionInfo;
 
+/*!
+     * A ParsedQualifierOperand is the literal operand of a qualifier, parsed
+     * once when the decision info that holds it is loaded so that qualifier
+     * types can evaluate it without re-parsing the string.
+     */
+struct ParsedQualifierOperand
+{
+    // Literal values used by the core qualifier types, matched case-insensitively.
+    enum KnownValue : UINT16
+    {
+        UnknownValue = 0,
+        ContrastStandard,
+        ContrastHigh,
+        ContrastBlack,
+        ContrastWhite,
+        DXFeatureLevel9,
+        DXFeatureLevel10,
+        DXFeatureLevel11,
+        DXFeatureLevel12,
+        DeviceFamilyUniversal,
+        DeviceFamilyDesktop,
+        DeviceFamilyCore,
+        NumKnownValues
+    };
+
+    enum Flags : UINT16
+    {
+        NoFlags = 0x0000,
+        ParsedValue = 0x0001, // operand was parsed
+        EmptyValue = 0x0002, // literal is empty
+        DecimalValue = 0x0004, // literal is all digits, integerValue holds its value
+        ListValue = 0x0008 // literal contains a ';' separated list
+    };
+
+    int integerValue;
+    UINT16 knownValue;
+    UINT16 flags;
+
+    bool IsParsed() const { return (flags & ParsedValue) != 0; }
+    bool IsKnownValueInRange(_In_ KnownValue first, _In_ KnownValue last) const { return (knownValue >= first) && (knownValue <= last); }
+
+    static void Parse(_In_opt_ PCWSTR pValue, _Out_ ParsedQualifierOperand* pOperandOut);
+
+    // Returns the known value in [first, last] that matches pValue, or UnknownValue.
+    static KnownValue GetKnownValue(_In_opt_ PCWSTR pValue, _In_ KnownValue first, _In_ KnownValue last);
+};
+
 /*!
      * An ICondition represents a single comparison operation, typically used
      * to evaluate the relevance of some item for a specific context.  It consists
@@ -67,6 +114,14 @@ public:
 
     virtual HRESULT GetOperand2Attribute(_Inout_ Atom* pAttrOut) const = 0;
 
+    // Returns false if operand 2 was not pre-parsed, in which case callers
+    // must fall back to GetOperand2Literal.
+    virtual bool TryGetParsedOperand2(_Out_ ParsedQualifierOperand* pOperandOut) const
+    {
+        *pOperandOut = {};
+        return false;
+    }
+
     static bool Equal(_In_ const ICondition* pCondition1, _In_ const ICondition* pCondition2);
 
     static DEFCOMPARISON Compare(_In_ const ICondition* pCondition1, _In_ const ICondition* pCondition2);
@@ -195,6 +250,8 @@ public:
 
     HRESULT GetOperand2Attribute(_Inout_ Atom* pAttrOut) const;
 
+    bool TryGetParsedOperand2(_Out_ ParsedQualifierOperand* pOperandOut) const;
+
     int GetPriority() const;
 
     HRESULT GetFallbackScore(_Out_ double* score) const;
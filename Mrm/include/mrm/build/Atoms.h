@@ -19,6 +19,7 @@ private:
         fDefault = 0x0000,
         fIsCaseInsensitive = 0x0001,
         fIsNotSorted = 0x0004,
+        fUseStrongHash = 0x0010,
         fStringPoolIsOwned = 0x0100
     };
 
@@ -72,6 +73,12 @@ public:
     }
 
     bool GetIsCaseInsensitive() const { return ((m_flags & fIsCaseInsensitive) != 0); }
+    bool GetUsesStrongHash() const { return ((m_flags & fUseStrongHash) != 0); }
+
+    // Opts the pool into DEF_HASH_STRONG.  Pools built this way can't be
+    // searched by readers that predate DEFFILE_ATOMPOOL_HASH_STRONG.
+    HRESULT SetUseStrongHash(bool useStrongHash);
+
     HRESULT GetString(Atom, _Out_ PCWSTR* result) const;
     HRESULT GetString(Atom::Index, _Out_ PCWSTR* result) const;
     bool TryGetString(Atom, __inout_opt StringResult*) const;
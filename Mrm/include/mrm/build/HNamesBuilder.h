@@ -24,6 +24,8 @@ public:
     virtual HRESULT AddItem(__in ItemInfo* pItem, __out int* pIndexOut) = 0;
 
     virtual const HierarchicalNamesConfig* GetConfig() const = 0;
+
+    virtual DefArena* GetArena() const = 0;
 };
 
 class HierarchicalNameSegment
@@ -255,7 +257,7 @@ protected:
     HierarchicalNameSegment m_current;
 };
 
-class HNamesNode : public DefObject
+class HNamesNode : public DefArenaObject<>
 {
 public:
     virtual ~HNamesNode() {}
@@ -662,6 +664,27 @@ public:
 
     HRESULT GetOrAddItem(_In_ PCWSTR pPath, _Out_ ItemInfo** result);
 
+    /*!
+         * Gets or adds a batch of items.  Each path that has the
+         * same parent path as the one before it is added directly
+         * to the scope resolved for that previous path, without
+         * walking the tree from the root again, so callers should
+         * group or sort their paths by parent.
+         *
+         * \param pPaths
+         * Names of the items to get or add.
+         *
+         * \param numPaths
+         * Number of entries in pPaths.
+         *
+         * \param results
+         * Returns a pointer to an ItemInfo for each requested path,
+         * in the same order as pPaths.
+         *
+         * \return HRESULT
+         */
+    HRESULT GetOrAddItems(_In_reads_(numPaths) const PCWSTR* pPaths, _In_ int numPaths, _Out_writes_(numPaths) ItemInfo** results);
+
     /*!
          * Gets a scope by index.
          *
@@ -720,6 +743,17 @@ public:
 
     const HierarchicalNamesConfig* GetConfig() const { return this; }
 
+    /*!
+         * Sets an arena from which new scopes and items are
+         * allocated.  The arena must outlive this builder.
+         *
+         * \param pArena
+         * The arena to use, or NULL to use the process heap.
+         */
+    void SetArena(_In_opt_ DefArena* pArena) { m_pArena = pArena; }
+
+    DefArena* GetArena() const { return m_pArena; }
+
     bool IsFinalized() const { return (m_numFinalizedNames == (int)GetNumNames()); }
     bool IsValid() const { return true; }
     HRESULT Finalize();
@@ -750,6 +784,8 @@ private:
     IAtomPool* m_pScopeNames;
     IAtomPool* m_pItemNames;
 
+    DefArena* m_pArena{ nullptr }; // do not delete this here
+
     int m_numFinalizedNames{ 0 };
     int m_cchFinalizedAsciiNames{ 0 };
     int m_cchFinalizedUtf16Names{ 0 };
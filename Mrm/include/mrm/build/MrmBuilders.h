@@ -127,11 +127,28 @@ public:
     int GetNumScopes() const { return m_pSchema->GetNumScopes(); }
     int GetNumItems() const { return m_pSchema->GetNumItems(); }
 
+    void SetMinorVersion(_In_ UINT16 minorVersion)
+    {
+        m_minor = minorVersion;
+        m_bChecksumValid = false;
+    }
+
 protected:
     UINT16 m_major;
     UINT16 m_minor;
     const IHierarchicalSchema* m_pSchema;
 
+    // Names are only ever appended to a schema, so the checksum is cached for the counts it was
+    // computed at, and the checksums of the names themselves are extended as more are added.
+    mutable DEF_CHECKSUM m_checksum{ 0 };
+    mutable bool m_bChecksumValid{ false };
+    mutable int m_checksumNumScopes{ 0 };
+    mutable int m_checksumNumItems{ 0 };
+    mutable DefChecksum::AtomPoolStringsChecksum m_scopeNamesChecksum{};
+    mutable DefChecksum::AtomPoolStringsChecksum m_itemNamesChecksum{};
+
+    HRESULT ComputeVersionChecksum(_Out_ DEF_CHECKSUM* pChecksumOut) const;
+
     HierarchicalSchemaVersionInfoBuilder(_In_ const IHierarchicalSchema* pSchema, _In_ UINT16 majorVersion, _In_ UINT16 minorVersion);
 };
 
@@ -193,6 +210,9 @@ public:
     HRESULT GetOrAddScope(_In_ PCWSTR pItemName, _Out_ int* index);
     HRESULT GetOrAddItem(_In_ PCWSTR pItemName, _Out_ int* index);
 
+    // Gets or adds many items at once; names that share a parent scope should be adjacent.
+    HRESULT GetOrAddItems(_In_reads_(numItems) const PCWSTR* pItemNames, _In_ int numItems, _Out_writes_(numItems) int* indexes);
+
     _Success_(return == true)
     bool TryGetScopeInfo(_In_ int scopeIndex, _Out_ StringResult* pNameOut, _Out_opt_ int* pNumChildrenOut = nullptr) const;
 
@@ -526,6 +546,18 @@ typedef struct _BUILDER_CANDIDATE
     MRMFILE_MAP_VALUE_LARGE value;
 } BUILDER_CANDIDATE;
 
+// One record for ResourceMapSectionBuilder::AddCandidates.  If pBuildInstanceReference
+// is null the candidate is stored as an internal string using pValue, exactly as
+// AddCandidateWithInternalString would do.
+typedef struct _BUILDER_CANDIDATE_INPUT
+{
+    PCWSTR pItemName;
+    MrmEnvironment::ResourceValueType valueType;
+    PCWSTR pValue;
+    IBuildInstanceReference* pBuildInstanceReference;
+    int qualifierSetIndex;
+} BUILDER_CANDIDATE_INPUT;
+
 class BuilderCandidateResult : public DefObject
 {
 public:
@@ -601,6 +633,13 @@ public:
         _In_ IBuildInstanceReference* pBuildInstanceReference,
         _In_ int qualifierSetIndex);
 
+    // Adds many candidates in one call.  Records are grouped by name so that each name
+    // and its parent scope are resolved once, and per-item storage is sized up front.
+    // The map takes ownership of each build instance reference it accepts and clears
+    // pBuildInstanceReference in that record; on failure, references still present in
+    // the array remain owned by the caller.
+    HRESULT AddCandidates(_Inout_updates_(numCandidates) BUILDER_CANDIDATE_INPUT* pCandidates, _In_ int numCandidates);
+
     ResourceLinkSectionBuilder* GetLinks() const { return m_links; }
 
     HRESULT AddResourceLink(_In_ PCWSTR linkFromResourceName, _In_ PCWSTR linkToResourceName);
@@ -648,6 +687,14 @@ public:
 
     HRESULT Finalize();
 
+    // Finalize in two phases.  FinalizeDecisions updates the shared decision info
+    // and must be called serially for all maps; FinalizeLayout only touches this
+    // map and may run concurrently with other maps when CanFinalizeLayoutConcurrently
+    // returns true.
+    HRESULT FinalizeDecisions();
+    HRESULT FinalizeLayout();
+    bool CanFinalizeLayoutConcurrently() const { return (m_links == nullptr); }
+
     UINT32 GetMaxSizeInBytes() const;
 
     virtual HRESULT Build(_Out_writes_bytes_(cbBuffer) VOID* pBuffer, _In_ UINT32 cbBuffer, _Out_opt_ UINT32* pcbWrittenOut) const;
@@ -1194,13 +1241,14 @@ private:
     DynamicArray<UINT>* m_metadata{ nullptr };
 };
 
-class OrchestratorHashNode : public DefObject
+class OrchestratorHashNode : public DefArenaObject<>
 {
 public:
     static HRESULT CreateInstance(
         _In_ DEF_CHECKSUM valueHash,
         _In_ OrchestratorDataReference* dataReference,
-        _Outptr_ OrchestratorHashNode** result);
+        _Outptr_ OrchestratorHashNode** result,
+        _In_opt_ DefArena* pArena = nullptr);
 
     bool SetNext(_In_ OrchestratorHashNode* inputNode);
 
@@ -1223,7 +1271,11 @@ class OrchestratorHashMap : public DefObject
 public:
     virtual ~OrchestratorHashMap();
 
-    static HRESULT CreateInstance(_In_ int initCapacity, _In_ float loadFactor, _Outptr_ OrchestratorHashMap** result);
+    static HRESULT CreateInstance(
+        _In_ int initCapacity,
+        _In_ float loadFactor,
+        _Outptr_ OrchestratorHashMap** result,
+        _In_opt_ DefArena* pArena = nullptr);
 
     int Count() const { return m_nodeCount; }
 
@@ -1238,7 +1290,7 @@ public:
 private:
     HRESULT ResizeMap();
 
-    OrchestratorHashMap(_In_ int initCapacity, _In_ float loadFactor);
+    OrchestratorHashMap(_In_ int initCapacity, _In_ float loadFactor, _In_opt_ DefArena* pArena);
 
     HRESULT Init(int initCapacity);
 
@@ -1246,6 +1298,7 @@ private:
     int m_currentSize{ 0 };
     float m_loadFactor{ 0.0 };
     DynamicArray<OrchestratorHashNode*>* m_entries{ nullptr };
+    DefArena* m_pArena{ nullptr }; // do not delete this here
 };
 
 class DataItemOrchestrator : public DefObject
@@ -1255,7 +1308,8 @@ public:
         _In_ FileBuilder* fileBuilder,
         _In_ CoreProfile* profile,
         _In_ DecisionInfoSectionBuilder* decisionInfo,
-        _Outptr_ DataItemOrchestrator** result);
+        _Outptr_ DataItemOrchestrator** result,
+        _In_opt_ DefArena* arena = nullptr);
 
     virtual ~DataItemOrchestrator();
     virtual HRESULT Finalize();
@@ -1291,11 +1345,12 @@ public:
         _Outptr_ IBuildInstanceReference** result);
 
     HRESULT OptimizeString(
-        _Out_writes_bytes_to_(convertedStringSize, *writtenBytesIncludingNull) char* convertedString,
+        _In_ MrmEnvironment::ResourceValueType originalType,
         _In_ PCWSTR value,
-        _Inout_ size_t* writtenBytesIncludingNull,
-        _In_ size_t convertedStringSize,
-        _In_ MrmEnvironment::ResourceValueType* optimalType);
+        _Inout_ BlobResult* convertedStringResult,
+        _Outptr_result_maybenull_ char** convertedString,
+        _Out_ size_t* writtenBytesIncludingNull,
+        _Out_ MrmEnvironment::ResourceValueType* optimalType);
 
     virtual HRESULT AddOptimizedStringAndCreateInstanceReference(
         _In_ MrmEnvironment::ResourceValueType originalType,
@@ -1314,8 +1369,13 @@ public:
 
 protected:
     HRESULT GetOrAddDataItemSectionBuilder(_In_ int qualifierSetIndex, _Out_ DataItemsSectionBuilder** result);
+    HRESULT GetOrAddDataItemSectionBuilder(_In_ int qualifierSetIndex, _In_ UINT valueSizeInBytes, _Out_ DataItemsSectionBuilder** result);
 
-    DataItemOrchestrator(_In_ FileBuilder* fileBuilder, _In_ CoreProfile* profile, _In_ DecisionInfoSectionBuilder* decisionInfo);
+    DataItemOrchestrator(
+        _In_ FileBuilder* fileBuilder,
+        _In_ CoreProfile* profile,
+        _In_ DecisionInfoSectionBuilder* decisionInfo,
+        _In_opt_ DefArena* arena);
 
     HRESULT Init();
 
@@ -1325,8 +1385,10 @@ protected:
     DecisionInfoSectionBuilder* m_decisionInfo;
     DynamicArray<DataItemsSectionBuilder*>* m_allBuilders;
     DynamicArray<DataItemsSectionBuilder*>* m_buildersByQualifierSet;
+    DataItemsSectionBuilder* m_chunkedBuilder; // owned by m_allBuilders
     MrmBuildConfiguration* m_buildConfiguration; // do not delete this here
     OrchestratorHashMap* m_OrchestratorHashMap;
+    DefArena* m_arena; // do not delete this here
 };
 
 class PriSectionBuilder : public ISectionBuilder, public IResourceLinkBuilder
@@ -1472,6 +1534,10 @@ public:
 
     DataItemOrchestrator* GetDataItemOrchestrator() const { return m_dataItems; }
 
+    // Arena shared by the builders owned by this section for their per-item
+    // objects; released when this builder is deleted.
+    DefArena* GetArena() const { return m_pArena; }
+
     HRESULT AddResourceMapBuilder(_In_ ResourceMapSectionBuilder* pMap, _In_ bool isDefault, _Out_ int* index);
 
     HRESULT
@@ -1536,9 +1602,12 @@ private:
 
     HRESULT GetMapBuilderForAddCandidate(_In_opt_ PCWSTR schemaName, _Out_ ResourceMapSectionBuilder** result);
 
+    HRESULT FinalizeMapsAndSchemasInParallel();
+
 private:
     FileBuilder* m_pFileBuilder{ nullptr };
     AtomPoolGroup* m_pAtoms{ nullptr };
+    DefArena* m_pArena{ nullptr };
 
     UnifiedEnvironment* m_pUnifiedEnvironment{ nullptr };
     DecisionInfoSectionBuilder* m_pDecisionInfo{ nullptr };
@@ -180,24 +180,64 @@ private:
     __ecount(m_sizeLargeItems) struct ItemRef* m_pLargeItems;
     __bcount(m_cbLargeItemDataCapacity) BYTE* m_pLargeItemData;
 
+    UINT32 m_flags;
+
+    // When large items are chunked, m_pLargeItems[i].offset is the index of the item's
+    // first entry in m_pChunkRefs, and each chunk ref is an index into m_pChunks.
+    struct ChunkInfo
+    {
+        int offset;
+        int cbData;
+        DEF_CHECKSUM checksum;
+    };
+
+    int m_numChunks;
+    int m_sizeChunks;
+    __ecount(m_sizeChunks) struct ChunkInfo* m_pChunks;
+
+    int m_numChunkRefs;
+    int m_sizeChunkRefs;
+    __ecount(m_sizeChunkRefs) int* m_pChunkRefs;
+
+    // Open-addressed index of m_pChunks by checksum; entries are chunk index + 1, 0 is empty.
+    int m_sizeChunkIndex;
+    __ecount(m_sizeChunkIndex) int* m_pChunkIndex;
+
     static const unsigned int InitialSmallItemSize = 32;
     static const unsigned int InitialSmallItemDataCapacity = 1024;
 
     static const unsigned int InitialLargeItemSize = 32;
     static const unsigned int InitialLargeItemDataCapacity = 1024;
 
-    DataItemsSectionBuilder();
+    static const unsigned int InitialChunkSize = 64;
+    static const unsigned int InitialChunkIndexSize = 128;
+
+    DataItemsSectionBuilder(_In_ UINT32 flags);
 
     HRESULT EnsureLargeItemCapacity(__in int cbTotal);
     HRESULT EnsureSmallItemCapacity(__in int cbTotal);
+    HRESULT EnsureChunkRefCapacity(__in int numTotal);
+
+    HRESULT AddChunkedItem(__in_bcount(cbData) const BYTE* pData, __in UINT32 cbData, __in int align, __out PrebuildItemReference* pRefOut);
+    HRESULT GetOrAddChunk(__in_bcount(cbData) const BYTE* pData, __in UINT32 cbData, __in int align, __out int* pChunkIndexOut);
+    HRESULT GrowChunkIndex();
+
+    bool IsChunked() const { return ((m_flags & ChunkLargeItemsFlag) != 0); }
 
 public:
+    /*!
+        * Stores large items as content-defined chunks, sharing identical chunks
+        * between items.  Produces a gDataItemsChunkedSectionType section.
+        */
+    static const UINT32 ChunkLargeItemsFlag = 0x1;
+
     /*!
         * \name Constructors & Destructors
         * @{
         */
 
     static HRESULT CreateInstance(_Outptr_ DataItemsSectionBuilder** result);
+    static HRESULT CreateInstance(_In_ UINT32 flags, _Outptr_ DataItemsSectionBuilder** result);
 
     virtual ~DataItemsSectionBuilder();
 
@@ -283,7 +323,7 @@ public:
 
     HRESULT Build(__out_bcount(cbBuffer) VOID* pBuffer, __in UINT32 cbBuffer, __out_opt UINT32* pcbWrittenOut) const;
 
-    DEFFILE_SECTION_TYPEID GetSectionType() const { return gDataItemsSectionType; }
+    DEFFILE_SECTION_TYPEID GetSectionType() const { return (IsChunked() ? gDataItemsChunkedSectionType : gDataItemsSectionType); }
 
     UINT16 GetFlags() const { return 0; }
     UINT16 GetSectionFlags() const { return 0; }
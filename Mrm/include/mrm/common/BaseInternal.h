@@ -107,6 +107,17 @@ extern "C"
 
     DEFSTRING_ENCODING DefString_ChooseBestEncoding(_In_ PCWSTR utf16String);
 
+    // Chooses the best encoding exactly as DefString_ChooseBestEncoding does and, in the same pass, writes the
+    // ASCII or UTF-8 form of the string (including the nul terminator) to narrowString. narrowString must be at
+    // least (stringLengthInUtf16Chars + 1) * sizeof(WCHAR) bytes; its contents are undefined if UTF-16 is chosen.
+    HRESULT DefString_ChooseBestEncodingAndNarrow(
+        _In_reads_(stringLengthInUtf16Chars) PCWSTR utf16String,
+        _In_ size_t stringLengthInUtf16Chars,
+        _Out_writes_bytes_to_(narrowStringSizeInBytes, *writtenBytesIncludingNull) char* narrowString,
+        _In_ size_t narrowStringSizeInBytes,
+        _Out_ DEFSTRING_ENCODING* bestEncoding,
+        _Out_ size_t* writtenBytesIncludingNull);
+
     // Convert to UTF-16 from ASCII and UTF-8.
     // We don't need the other direction here, because the tools that write these strings can call existing system helpers.
     // These functions operate on string sizes that include the nul terminator since that is what our pipeline deals with.
@@ -64,6 +64,11 @@ extern "C"
 
     UINT32 _DefComputeCrc32(__in UINT32 partialCrc, __in_bcount(cbBuf) const BYTE* pBuf, __in UINT32 cbBuf);
 
+    // Returns the CRC of the concatenation of two buffers given the CRC of each (the second
+    // computed with a partialCrc of 0) and the length of the second, so that large buffers
+    // can be checksummed in independent chunks.
+    UINT32 _DefCombineCrc32(__in UINT32 crc1, __in UINT32 crc2, __in UINT64 cbBuf2);
+
     UINT32
     _DefComputeStringCrc32(__in UINT32 partialCrc, __in BOOLEAN isCaseInsensitive, __in_ecount(cchStr) PCWSTR pStr, __in UINT32 cchStr);
 
@@ -79,10 +84,53 @@ extern "C"
         _In_ wchar_t listDelimiter,
         _Out_ double* closestDistance);
 
+    // Portable BCP-47 tag validation and matching, used when the platform doesn't
+    // provide them.  _DefGetLanguageListMatchScore returns a score from 0.0 (no match)
+    // to 1.0 (exact match on the first language in the list), or -1.0 if language
+    // is not a well-formed tag.
+    BOOLEAN _DefIsWellFormedLanguageTag(_In_ PCWSTR tag);
+
+    HRESULT _DefGetLanguageListMatchScore(
+        _In_ PCWSTR language,
+        _In_ PCWSTR languagesList,
+        _In_ wchar_t listDelimiter,
+        _Out_ double* score);
+
+    // Processor features used to select vectorized code paths at runtime.
+    // _DefGetCpuFeatures returns a combination of the DEF_CPU_FEATURE_* flags
+    // and caches the result after the first call.
+    typedef UINT32 DEF_CPU_FEATURES;
+
+    static const DEF_CPU_FEATURES DEF_CPU_FEATURE_NONE = 0x0000;
+    static const DEF_CPU_FEATURES DEF_CPU_FEATURE_SSE2 = 0x0001;
+    static const DEF_CPU_FEATURES DEF_CPU_FEATURE_SSE41 = 0x0002;
+    static const DEF_CPU_FEATURES DEF_CPU_FEATURE_AVX2 = 0x0004;
+    static const DEF_CPU_FEATURES DEF_CPU_FEATURE_PCLMULQDQ = 0x0008;
+
+    DEF_CPU_FEATURES _DefGetCpuFeatures();
+
 #ifdef __cplusplus
 }
 #endif
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define DEF_CPU_X86 1
+#endif
+
+// Code paths using intrinsics above the baseline instruction set must be marked so that
+// GCC and Clang will emit them; MSVC emits any intrinsic without per-function opt-in.
+#if defined(DEF_CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DEF_TARGET_SSE2 __attribute__((target("sse2")))
+#define DEF_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define DEF_TARGET_AVX2 __attribute__((target("avx2")))
+#define DEF_TARGET_PCLMULQDQ __attribute__((target("pclmul,sse4.1")))
+#else
+#define DEF_TARGET_SSE2
+#define DEF_TARGET_SSE41
+#define DEF_TARGET_AVX2
+#define DEF_TARGET_PCLMULQDQ
+#endif
+
 #if DBG
 #define DEF_ASSERT(a) \
     _Analysis_assume_(a); \
@@ -61,7 +61,8 @@ extern "C"
         DEFFILE_ATOMPOOL_HASH_CASE_INSENSITIVE = 0x0001, //!< Uses case-insensitive hash method
         DEFFILE_ATOMPOOL_HASH_NONE = 0x0002, //!< No hash table present
         DEFFILE_ATOMPOOL_HASH_UNSORTED = 0x0004, //!< Hash table is unsorted
-        DEFFILE_ATOMPOOL_HASH_SMALL = 0x0008 //!< Hash table uses small atom index for hash table
+        DEFFILE_ATOMPOOL_HASH_SMALL = 0x0008, //!< Hash table uses small atom index for hash table
+        DEFFILE_ATOMPOOL_HASH_STRONG = 0x0010 //!< Uses the collision-resistant hash method (DEF_HASH_STRONG)
     } DefFileAtomPoolHashFlags;
 
 #define DEFFILE_ATOMPOOL_DESC_LENGTH 32
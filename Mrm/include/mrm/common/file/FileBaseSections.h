@@ -46,6 +46,24 @@ extern "C"
         ' ',
     };
 
+    __declspec(selectany) extern const DEFFILE_SECTION_TYPEID gDataItemsChunkedSectionType = {
+        '[',
+        'm',
+        'r',
+        'm',
+        '_',
+        'd',
+        'a',
+        't',
+        'a',
+        'i',
+        't',
+        'e',
+        'm',
+        'c',
+        ']',
+    };
+
     /*
       * NOTE:   These structures are all intended to be mapped directly into memory.  Always
       * use types with fixed sizes (e.g. INT32 instead of INT) and be careful to maintain natural
@@ -80,10 +98,33 @@ extern "C"
         UINT32 cbData;
     } DEFFILE_DATA_ITEM_LARGE;
 
+    /*!
+      * A chunked data items section (gDataItemsChunkedSectionType) stores large
+      * items as a sequence of chunks that can be shared between items.  Layout
+      * in memory is:
+     *      DATAITEMS_HEADER            hdr
+     *      DATA_ITEM_SMALL             smallItems[hdr.numSmallItems]
+     *      DATA_ITEM_LARGE             largeItems[hdr.numLargItems]
+     *      DATAITEMS_CHUNK_TABLE       chunkTable
+     *      DATA_ITEM_LARGE             chunkRefs[chunkTable.numChunkRefs]
+     *      BYTE*                       itemData[cbData]
+     *      PAD
+     *
+     * For each large item, offset is the index of its first entry in chunkRefs
+     * and cbData is the total item size.  The item is the concatenation of
+     * consecutive chunkRefs entries, each of which locates a chunk in itemData.
+     */
+    typedef struct _DEFFILE_DATAITEMS_CHUNK_TABLE
+    {
+        UINT32 numChunkRefs; //!< Total number of chunk references in the section
+        UINT32 reserved;
+    } DEFFILE_DATAITEMS_CHUNK_TABLE;
+
     __declspec(selectany) extern const int DEFFILE_SMALL_DATA_ITEM_MAX_SIZE = 0x7fff;
 
 // Flags for DEFFILE_DATAITEMS_HEADER
 #define DEFFILE_DATAITEMS_EXTENDED_LARGE_ITEMS 0x1
+#define DEFFILE_DATAITEMS_CHUNKED_LARGE_ITEMS 0x2
 
     inline UINT32 GetNumberOfLargeItems(_In_ const DEFFILE_DATAITEMS_HEADER* header)
     {
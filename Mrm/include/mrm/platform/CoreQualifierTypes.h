@@ -16,6 +16,8 @@ public:
     HRESULT Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pValue, _Out_ double* score) const;
 
 protected:
+    HRESULT ValidateParsedQualifierValue(_In_ const ParsedQualifierOperand* pOperand) const;
+
     ContrastQualifierType() :
         EnumerationQualifierType(CoreEnvironment::Qualifier_Contrast_AllowedValues, CoreEnvironment::Qualifier_Contrast_NumAllowedValues)
     {}
@@ -68,6 +70,8 @@ public:
     }
 
 protected:
+    static int GetFeatureLevel(_In_ ParsedQualifierOperand::KnownValue value);
+
     DXFeatureLevelQualifierType() :
         EnumerationQualifierType(
             CoreEnvironment::Qualifier_DXFeatureLevel_AllowedValues,
@@ -764,6 +764,8 @@ public:
     static const UINT32 UseDeduplicationFlag = 0x80;
     static const UINT32 UseGranularResourceSplittingFlag = 0x100;
     static const UINT32 SplitLanguageVariantsFlag = 0x200;
+    static const UINT32 UseParallelFinalizeFlag = 0x400;
+    static const UINT32 UseChunkDeduplicationFlag = 0x800;
 
     static const UINT32 Windows8ConfigurationFlags = 0;
 
@@ -790,6 +792,8 @@ public:
     bool UseDeduplication() const { return ((m_flags & UseDeduplicationFlag) != 0); }
     bool UseGranularResourceSplitting() const { return ((m_flags & UseGranularResourceSplittingFlag) != 0); }
     bool SplitLanguageVariants() const { return ((m_flags & SplitLanguageVariantsFlag) != 0); }
+    bool UseParallelFinalize() const { return ((m_flags & UseParallelFinalizeFlag) != 0); }
+    bool UseChunkDeduplication() const { return ((m_flags & UseChunkDeduplicationFlag) != 0); }
 
 protected:
     MrmBuildConfiguration(_In_ DEFFILE_MAGIC fileMagicNumber, _In_ UINT32 flags) : m_magic(fileMagicNumber), m_flags(flags) {}
@@ -947,6 +951,15 @@ protected:
 
     virtual HRESULT ValidateSingleQualifierValue(_In_ PCWSTR pValue) const = 0;
 
+    // Validates an operand that was parsed at load.  Returns S_FALSE if the parsed
+    // form is not enough to decide and the literal must be validated instead.
+    virtual HRESULT ValidateParsedQualifierValue(_In_ const ParsedQualifierOperand* /* pOperand */) const { return S_FALSE; }
+
+    // Like ValidateQualifier, but uses the operand parsed at load when the type can
+    // validate it.  Returns S_OK and the parsed operand in that case, otherwise
+    // validates the literal and returns S_FALSE.
+    HRESULT ValidateParsedQualifier(_In_ const IQualifier* pQualifier, _Out_ ParsedQualifierOperand* pOperandOut) const;
+
     virtual HRESULT ValidateOrMakeCompatibleSingleQualifierValue(_In_ PCWSTR value, _Inout_ StringResult* compatibleValue) const;
 
     virtual double EvaluateSingleQualifierValue(_In_ PCWSTR valueOnAsset, _In_ PCWSTR valueFromProvider) const;
@@ -1056,6 +1069,8 @@ protected:
 
     HRESULT ValidateSingleQualifierValue(_In_ PCWSTR pValue) const;
 
+    HRESULT ValidateParsedQualifierValue(_In_ const ParsedQualifierOperand* pOperand) const;
+
     HRESULT InnerCompare(_In_ const IQualifier* pQualifier1, _In_ const IQualifier* pQualifier2, _Out_ DEFCOMPARISON* result) const;
 };
 
@@ -31,6 +31,9 @@ protected:
     const WCHAR* m_pPool{ nullptr };
     const WCHAR* m_pPoolGroup{ nullptr };
 
+    // Built on first lookup for pools serialized without a sorted hash table
+    mutable AtomHashIndex* volatile m_pLookupIndex{ nullptr };
+
     static const DEFFILE_SECTION_TYPEID gAtomPoolSectionType;
 
     FileAtomPool();
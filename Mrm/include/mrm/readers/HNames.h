@@ -105,6 +105,21 @@ public:
     virtual bool TryGetItemInfo(__in int itemIndex, __inout StringResult* pNameOut) const = 0;
 };
 
+/*!
+     * Receives names from a bulk enumeration.  pName is only valid for the
+     * duration of the call; copy it if it needs to outlive the callback.
+     * Returning S_FALSE stops the enumeration; failures are propagated.
+     */
+class IHierarchicalNamesVisitor
+{
+public:
+    virtual ~IHierarchicalNamesVisitor() {}
+
+    virtual HRESULT VisitItem(_In_ int itemIndex, _In_reads_(cchName) PCWSTR pName, _In_ int cchName) = 0;
+
+    virtual HRESULT VisitScope(_In_ int /*scopeIndex*/, _In_reads_(cchName) PCWSTR /*pName*/, _In_ int /*cchName*/) { return S_OK; }
+};
+
 class HierarchicalNames : public IHierarchicalNames, public FileSectionBase, public HierarchicalNamesConfig
 {
 public:
@@ -191,7 +206,48 @@ public:
         _Out_writes_to_opt_(sizeItems, *pNumItemsWritten) int* pItemsOut,
         _Out_opt_ int* pNumItemsWritten) const;
 
+    /*!
+         * Enables a bounded cache of full path lookups made through Contains,
+         * along with a probabilistic filter over every name in the section
+         * that rejects most absolute-path misses without walking the tree.
+         * Safe to call while other threads are doing lookups.  Only the first
+         * successful call has any effect.
+         */
+    HRESULT EnableLookupCache(_In_ UINT32 maxEntries) const;
+
+    /*!
+         * Builds a hash index over the root-relative path of every scope and
+         * item in the section.  Once it is built, Contains resolves absolute
+         * paths with a single probe and an in-place check of the matching
+         * node's ancestors instead of walking the tree.  Safe to call while
+         * other threads are doing lookups.  Only the first successful call
+         * has any effect.
+         */
+    HRESULT EnablePathIndex() const;
+
+    /*!
+         * Visits every scope and item below relativeToScope depth-first, in
+         * stored order, with names relative to that scope.  Names are built
+         * in a single path buffer as the walk descends, so no per-name
+         * allocation is made.  Returns S_FALSE if the visitor stopped early.
+         */
+    HRESULT EnumerateNames(_In_ int relativeToScope, _In_ IHierarchicalNamesVisitor* pVisitor) const;
+
+    /*!
+         * Visits the scopes and items below relativeToScope whose relative
+         * names match pPattern, pruning the walk segment by segment.  Within
+         * a segment '*' matches any run of characters and '?' any single
+         * character; a "**" segment matches any number of segments, and a
+         * trailing separator matches everything below the named scope.
+         * Segments without wildcards are found by binary search.  Matching
+         * is case-insensitive.  Returns S_FALSE if the visitor stopped early.
+         */
+    HRESULT FindNames(_In_ int relativeToScope, _In_ PCWSTR pPattern, _In_ IHierarchicalNamesVisitor* pVisitor) const;
+
 private:
+    struct LookupCache;
+    struct NamePattern;
+    struct PathIndex;
     bool m_largeNode;
     DEFFILE_HNAMES_HEADER_EX m_header{};
     const DEFFILE_HNAMES_HEADER_EX* m_pHeader;
@@ -208,8 +264,57 @@ private:
     IAtomPool* m_pScopeNames;
     IAtomPool* m_pItemNames;
 
+    mutable LookupCache* volatile m_pLookupCache;
+    mutable PathIndex* volatile m_pPathIndex;
+
     HierarchicalNames();
 
+    _Success_(return == true)
+    bool LookupName(
+        __in PCWSTR path,
+        __in int relativeToScope,
+        __out_opt int* pScopeIndexOut,
+        __out_opt int* pItemIndexOut,
+        __out_opt int* pNameIndexOut) const;
+
+    bool TryGetNodePayload(_In_ int nameIndex, _Out_ int* pScopeIndexOut, _Out_ int* pItemIndexOut) const;
+
+    HRESULT AllocatePathBuffer(_Outptr_result_buffer_(*pcchPath) PWSTR* ppPath, _Out_ int* pcchPath) const;
+
+    HRESULT EnumerateScopeNames(
+        _In_ int scopeIndex,
+        _Inout_updates_(cchPath) PWSTR pPath,
+        _In_ int cchPath,
+        _In_ int cchPrefix,
+        _In_ UINT32 currentDepth,
+        _In_ IHierarchicalNamesVisitor* pVisitor) const;
+
+    HRESULT FindScopeNames(
+        _In_ const NamePattern* pPattern,
+        _In_ int scopeIndex,
+        _In_ UINT64 states,
+        _Inout_updates_(cchPath) PWSTR pPath,
+        _In_ int cchPath,
+        _In_ int cchPrefix,
+        _In_ UINT32 currentDepth,
+        _In_ IHierarchicalNamesVisitor* pVisitor) const;
+
+    HRESULT AddScopeToLookupFilter(_Inout_ LookupCache* pCache, _In_ int scopeIndex, _In_ UINT64 pathHash, _In_ UINT32 currentDepth) const;
+
+    HRESULT AddScopeToPathIndex(_Inout_ PathIndex* pIndex, _In_ int scopeIndex, _In_ UINT64 pathHash, _In_ UINT32 currentDepth) const;
+
+    HRESULT HashNodeName(_In_ const DEFFILE_HNAMES_NODE_LARGE* pNode, _In_ UINT64 pathHash, _Out_ UINT64* pHashOut) const;
+
+    _Success_(return == true)
+    bool TryFindIndexedPath(
+        _In_ const PathIndex* pIndex,
+        _In_ UINT64 hash,
+        _In_reads_(cchPath) PCWSTR pPath,
+        _In_ int cchPath,
+        _Out_ int* pNameIndexOut) const;
+
+    bool NodeMatchesPath(_In_ int nameIndex, _In_reads_(cchPath) PCWSTR pPath, _In_ int cchPath) const;
+
     HRESULT Init(
         _In_ const DEFFILE_SECTION_TYPEID& type,
         _In_opt_ const IFileSection* pSection,
@@ -245,6 +350,10 @@ private:
         return S_OK;
     }
 
+    // Names of 256 characters or more don't record their length in the
+    // node, so those are measured in the names pool.
+    HRESULT GetNodeNameLength(_In_ const DEFFILE_HNAMES_NODE_LARGE* pNode, _Out_ int* pcchName) const;
+
     template<typename T>
     UINT32 GetNodeNameOffset(_In_ const T* node) const
     {
@@ -285,6 +394,23 @@ private:
     template<typename T>
     HRESULT CompareNameSegment(_In_ const T* pNode, _In_ PCWSTR pRequestedSegment, _Out_ int* result) const;
 
+    // Three-way comparison in the order children are sorted in: upper-cased
+    // initial character first, then an ordinal case-insensitive compare.
+    template<typename T>
+    HRESULT CompareChildSegment(
+        _In_ const T* pNode,
+        _In_reads_(cchSegment) PCWSTR pSegment,
+        _In_ int cchSegment,
+        _Out_ int* result) const;
+
+    // Binary search of a scope's sorted children.  Returns -1 if not found.
+    template<typename T>
+    int FindChildNode(
+        _In_reads_(numChildren) const T* pChildren,
+        _In_ int numChildren,
+        _In_reads_(cchSegment) PCWSTR pSegment,
+        _In_ int cchSegment) const;
+
     HRESULT CopyNameSegment(_In_ UINT32 flags, _In_ int firstCharOffset, _In_ int cchName, _Out_writes_(cchName) WCHAR* pNameOut) const
     {
         if ((flags & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
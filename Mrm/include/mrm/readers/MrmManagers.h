@@ -656,6 +656,13 @@ public:
             scopeIndex, sizeScopes, pScopesOut, pNumScopesWritten, sizeItems, pItemsOut, pNumItemsWritten);
     }
 
+    HRESULT EnumerateNames(_In_ IHierarchicalNamesVisitor* pVisitor) const { return m_pCurrentSchema->EnumerateNames(pVisitor); }
+
+    HRESULT FindNames(_In_ int relativeToScope, _In_ PCWSTR pPattern, _In_ IHierarchicalNamesVisitor* pVisitor) const
+    {
+        return m_pCurrentSchema->FindNames(relativeToScope, pPattern, pVisitor);
+    }
+
     HRESULT Clone(_Outptr_ IHierarchicalSchema**) const;
 
     HRESULT GetSchemaBlobFromFileSection(
@@ -997,6 +1004,38 @@ public:
     virtual HRESULT GetQualifierProvider(_In_ PCWSTR qualifierName, _Out_ const IQualifierValueProvider** provider) const = 0;
 };
 
+class ResolutionSnapshot;
+
+// Result for one resource in a batch resolve.  hr is per resource: a missing name or a resource
+// with no match or default candidate doesn't fail the rest of the batch.
+typedef struct _ResourceResolution
+{
+    int resourceIndex; // index in the map's schema, or -1 if the name wasn't found
+    int candidateIndex; // best candidate, or -1 if resolution failed
+    HRESULT hr;
+} ResourceResolution;
+
+// Cache statistics of a single resolver, as returned by ResolverBase::GetStatistics.  An
+// OverrideResolver that shares its parent's cache counts its lookups on the parent.
+typedef struct _ResolverStatistics
+{
+    // Bucket i of the latency histogram counts calls that took less than 2^i microseconds
+    // (and at least 2^(i-1)); the last bucket also counts everything slower.
+    static const int NumLatencyBuckets = 16;
+
+    LONG64 qualifierHits;
+    LONG64 qualifierMisses;
+    LONG64 qualifierSetHits;
+    LONG64 qualifierSetMisses;
+    LONG64 decisionHits;
+    LONG64 decisionMisses;
+    LONG64 resets; // full resets
+    LONG64 partialResets; // resets of only some qualifiers
+    LONG64 lockAcquisitions; // exclusive acquisitions of the resolver lock
+    LONG64 lockWaitNanoseconds; // total time spent waiting for those acquisitions
+    LONG64 evaluateDecisionLatency[NumLatencyBuckets];
+} ResolverStatistics;
+
 class ResolverBase : public IResolver
 {
 public:
@@ -1011,7 +1050,7 @@ public:
 
     virtual HRESULT Reset(_In_reads_(numQualifierNames) Atom* pQualifierNames, _In_ int numQualifierNames);
 
-    UINT64 GetGeneration() const { return m_generation; }
+    UINT64 GetGeneration() const { return static_cast<UINT64>(ReadAcquire64(&m_generation)); }
 
     virtual HRESULT GetQualifierValue(_In_ PCWSTR pQualifier, _Inout_ StringResult* pValue) const = 0;
 
@@ -1036,23 +1075,112 @@ public:
 
     virtual HRESULT GetQualifierProvider(_In_ PCWSTR qualifierName, _Out_ const IQualifierValueProvider** provider) const override = 0;
 
+    HRESULT CreateResolutionSnapshot(_In_ const IResourceMapBase* pMap, _Outptr_ ResolutionSnapshot** result) const;
+
+    // Statistics are off by default, and cost a single pointer test per counter while off.
+    // Counters are updated without ordering, so a snapshot is consistent per counter only.
+    HRESULT EnableStatistics(_In_ bool bEnable);
+
+    bool IsStatisticsEnabled() const { return m_bStatisticsEnabled; }
+
+    HRESULT GetStatistics(_Out_ ResolverStatistics* pStatisticsOut) const;
+
+    void ResetStatistics();
+
+    // Resolves many resources at once.  Each distinct decision is evaluated once, and all cache
+    // misses are filled under a single acquisition of the resolver lock.
+    HRESULT ResolveResources(
+        _In_ const IResourceMapBase* pMap,
+        _In_ int numResources,
+        _In_reads_(numResources) const int* pResourceIndexes,
+        _Out_writes_(numResources) ResourceResolution* pResultsOut,
+        _Inout_updates_opt_(numResources) ResourceCandidateResult* pCandidatesOut = nullptr) const;
+
+    HRESULT ResolveResources(
+        _In_ const IResourceMapBase* pMap,
+        _In_ int numResources,
+        _In_reads_(numResources) const PCWSTR* pResourceNames,
+        _Out_writes_(numResources) ResourceResolution* pResultsOut,
+        _Inout_updates_opt_(numResources) ResourceCandidateResult* pCandidatesOut = nullptr) const;
+
 protected:
+    typedef struct _DecisionEvaluation
+    {
+        int decisionIndex; // in m_pDecisions
+        int resultIndex;
+        int setIndexInPool;
+        HRESULT hr;
+    } DecisionEvaluation;
     ResolverBase(_In_ const UnifiedEnvironment* pEnvironment, _In_ const IDecisionInfo* pDecisions);
 
     HRESULT Init();
 
     HRESULT EvaluateQualifier(_In_ const IQualifier* pQualifier, _Out_ UINT16* pScoreOut, _Out_ UINT16* pFallbackScoreOut) const;
 
+    void InvalidateCachedResults(_In_reads_(numQualifierNames) const Atom* pQualifierNames, _In_ int numQualifierNames);
+
+    // Caller must hold m_srwLock exclusively.
+    HRESULT FillDecisionResults(_In_ const IDecision* pDecision) const;
+
+    virtual void EvaluateDecisions(_In_ int numDecisions, _Inout_updates_(numDecisions) DecisionEvaluation* pDecisions) const;
+
+    // Returns a resolver whose score for pQualifier is known to equal ours, or nullptr to evaluate it here.
+    virtual const ResolverBase* GetQualifierScoreSource(_In_ const IQualifier* /*pQualifier*/) const { return nullptr; }
+
+    // Returns nullptr unless statistics are enabled.
+    ResolverStatistics* GetActiveStatistics() const { return m_bStatisticsEnabled ? m_pStatistics : nullptr; }
+
     class DecisionInfoCache;
+    class StatisticsTimer;
+    friend class MultiContextResolver;
 
     const UnifiedEnvironment* m_pEnvironment{ nullptr };
     const IDecisionInfo* m_pDecisions{ nullptr };
-    UINT64 m_generation = 0;
+    volatile LONG64 m_generation = 0; // bumped by every Reset and SetQualifier
 
     mutable DecisionInfoCache* m_pCache{ nullptr };
     mutable SRWLOCK m_srwLock{ nullptr };
     mutable SRWLOCK m_srwQualifierSetLock{ nullptr };
     mutable SRWLOCK m_srwQualifierLock{ nullptr };
+
+    // Allocated the first time statistics are enabled, and kept until the resolver goes away
+    // so that concurrent counters never see it freed.
+    ResolverStatistics* volatile m_pStatistics{ nullptr };
+    volatile bool m_bStatisticsEnabled{ false };
+};
+
+// The best candidate for every resource in a map, as chosen by a resolver for its qualifier
+// values at the time the snapshot was taken.  Lookups are a single array read.  The snapshot
+// goes stale as soon as the resolver or any of its parents is reset (including by SetQualifier).
+class ResolutionSnapshot : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_In_ const IResolver* pResolver, _In_ const IResourceMapBase* pMap, _Outptr_ ResolutionSnapshot** result);
+
+    virtual ~ResolutionSnapshot();
+
+    const IResolver* GetResolver() const { return m_pResolver; }
+    const IResourceMapBase* GetResourceMap() const { return m_pMap; }
+    int GetNumResources() const { return m_numResources; }
+
+    bool IsCurrent() const { return (GetContextGeneration(m_pResolver) == m_generation); }
+
+    HRESULT GetCandidateIndex(_In_ int resourceIndex, _Out_ int* pCandidateIndexOut) const;
+
+    static UINT64 GetContextGeneration(_In_ const IResolver* pResolver);
+
+protected:
+    static const int NoCandidate = -1;
+
+    const IResolver* m_pResolver{ nullptr };
+    const IResourceMapBase* m_pMap{ nullptr };
+    UINT64 m_generation{ 0 };
+    int m_numResources{ 0 };
+    _Field_size_(m_numResources) int* m_pCandidates{ nullptr };
+
+    ResolutionSnapshot(_In_ const IResolver* pResolver, _In_ const IResourceMapBase* pMap);
+
+    HRESULT Init();
 };
 
 class ProviderResolver : public ResolverBase
@@ -1112,6 +1240,11 @@ public:
         _In_ bool bCloned,
         _Outptr_ OverrideResolver** result);
 
+    // Creates a copy-on-write override.  Until SetQualifier is called it shares all results with
+    // pParent; afterwards it shares the parent's cached scores for every qualifier it doesn't
+    // override and only evaluates the overridden ones itself.
+    static HRESULT CreateCopyOnWriteInstance(_In_ const ResolverBase* pParent, _Outptr_ OverrideResolver** result);
+
     virtual ~OverrideResolver();
 
     HRESULT SetQualifier(_In_ Atom qualifier, _In_ PCWSTR pNewValue);
@@ -1163,9 +1296,14 @@ public:
     virtual HRESULT GetQualifierProvider(_In_ PCWSTR qualifierName, _Out_ const IQualifierValueProvider** provider) const override;
 
 protected:
+    void EvaluateDecisions(_In_ int numDecisions, _Inout_updates_(numDecisions) DecisionEvaluation* pDecisions) const override;
+
+    const ResolverBase* GetQualifierScoreSource(_In_ const IQualifier* pQualifier) const override;
+
     class PerQualifierPoolInfo;
 
     const IResolver* m_pParent{ nullptr };
+    const ResolverBase* m_pScoreSource{ nullptr }; // set for copy-on-write overrides
     mutable PerQualifierPoolInfo* m_pQualifiers{ nullptr };
     bool m_bHasScoreCache{ false };
     bool m_bIsDifferentQualifierValueFromParent{ false };
@@ -1181,4 +1319,67 @@ protected:
     HRESULT Init(_In_ CoreProfile* pProfile, _In_ const UnifiedEnvironment* pEnvironment);
 };
 
+// Resolves against several qualifier contexts at once, e.g. every scale, theme and language an
+// asset pipeline produces.  Each context is an OverrideResolver over a common parent.  Contexts
+// that agree on a qualifier's value share its score, and contexts that agree on every qualifier a
+// decision looks at share its ranking, so the cost grows with the number of distinct values rather
+// than the number of contexts.
+class MultiContextResolver : public DefObject
+{
+public:
+    static HRESULT CreateInstance(_In_ const IResolver* pParent, _In_ int numContexts, _Outptr_ MultiContextResolver** result);
+
+    virtual ~MultiContextResolver();
+
+    int GetNumContexts() const { return m_numContexts; }
+
+    const IResolver* GetContext(_In_ int contextIndex) const;
+
+    HRESULT SetQualifier(_In_ int contextIndex, _In_ PCWSTR pQualifierName, _In_ PCWSTR pNewValue);
+
+    // Gets the best candidate of the decision for every context.
+    HRESULT EvaluateDecision(
+        _In_ const IDecision* pDecision,
+        _Out_writes_(m_numContexts) int* pResultIndexesOut,
+        _Out_writes_(m_numContexts) int* pResultSetIndexesOut) const;
+
+    // Gets the best candidate of every listed resource for every context; results for resource i
+    // are at [i * GetNumContexts()].  Resources that can't be resolved in a context get -1.
+    HRESULT ResolveResources(
+        _In_ const IResourceMapBase* pMap,
+        _In_ int numResources,
+        _In_reads_(numResources) const int* pResourceIndexes,
+        _Out_writes_(numResources* m_numContexts) int* pCandidateIndexesOut) const;
+
+protected:
+    // Groups contexts by their value for one qualifier.  values[0..numContexts) is the class of
+    // each context, followed by the first context in each class.
+    typedef struct _ValueClasses
+    {
+        int numClasses;
+        int values[ANYSIZE_ARRAY];
+    } ValueClasses;
+
+    const IResolver* m_pParent{ nullptr };
+    int m_numContexts{ 0 };
+    OverrideResolver** m_ppContexts{ nullptr };
+    mutable UINT64 m_parentGeneration{ 0 };
+
+    mutable DynamicArray<ValueClasses*> m_valueClasses;   // by qualifier name index
+    mutable DynamicArray<UINT8> m_qualifierScoresShared;  // by qualifier index in pool
+    mutable StringResult* m_pScratchValues{ nullptr };
+    mutable int* m_pScratchOrder{ nullptr };
+    mutable SRWLOCK m_srwLock{ nullptr };
+
+    MultiContextResolver(_In_ const IResolver* pParent, _In_ int numContexts);
+
+    HRESULT Init();
+
+    void ResetSharedResults() const;
+
+    HRESULT GetValueClasses(_In_ Atom qualifierName, _Outptr_ const ValueClasses** result) const;
+
+    HRESULT ShareQualifierScores(_In_ const IQualifier* pQualifier, _In_ int qualifierIndexInPool) const;
+};
+
 } // namespace Microsoft::Resources
\ No newline at end of file
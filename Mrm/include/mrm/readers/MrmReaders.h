@@ -175,6 +175,15 @@ HRESULT ComputeHierarchicalSchemaVersionChecksum(
     _In_ const IHierarchicalSchemaVersionInfo* pVersion,
     _Out_ DefChecksum::Checksum* pChecksumOut);
 
+// Same as above, but keeps the checksums of the scope and item names in the supplied state so that
+// a caller computing it repeatedly for a growing schema only pays for the names added since.
+HRESULT ComputeHierarchicalSchemaVersionChecksum(
+    _In_ const IHierarchicalSchema* pSchema,
+    _In_ const IHierarchicalSchemaVersionInfo* pVersion,
+    _Inout_opt_ DefChecksum::AtomPoolStringsChecksum* pScopeNamesState,
+    _Inout_opt_ DefChecksum::AtomPoolStringsChecksum* pItemNamesState,
+    _Out_ DefChecksum::Checksum* pChecksumOut);
+
 bool CheckHierarchicalSchemaVersionIsIdentical(
     _In_opt_ const IHierarchicalSchemaVersionInfo* pVersion1,
     _In_opt_ const IHierarchicalSchemaVersionInfo* pVersion2);
@@ -258,6 +267,18 @@ public:
     virtual HRESULT GetSchemaBlobFromFileSection(
         _Inout_opt_ DEFFILE_SECTION_TYPEID* pSectionTypeResult,
         _Inout_opt_ BlobResult* pBlobResult) const = 0;
+
+    // Visits the full name of every scope and item in the schema.  The
+    // default looks each name up individually; schemas backed by a names
+    // section override it with a single depth-first walk.
+    virtual HRESULT EnumerateNames(_In_ IHierarchicalNamesVisitor* pVisitor) const;
+
+    // Visits names below relativeToScope that match a prefix or glob pattern;
+    // see HierarchicalNames::FindNames.  Not supported by every schema.
+    virtual HRESULT FindNames(_In_ int /*relativeToScope*/, _In_ PCWSTR /*pPattern*/, _In_ IHierarchicalNamesVisitor* /*pVisitor*/) const
+    {
+        return E_NOTIMPL;
+    }
 };
 
 class StaticHierarchicalSchemaDescription : public IHierarchicalSchemaDescription
@@ -460,6 +481,16 @@ public:
         return m_pNames->GetDescendents(scopeIndex, sizeScopes, pScopesOut, pNumScopesWritten, sizeItems, pItemsOut, pNumItemsWritten);
     }
 
+    HRESULT EnumerateNames(_In_ IHierarchicalNamesVisitor* pVisitor) const { return m_pNames->EnumerateNames(0, pVisitor); }
+
+    HRESULT FindNames(_In_ int relativeToScope, _In_ PCWSTR pPattern, _In_ IHierarchicalNamesVisitor* pVisitor) const
+    {
+        return m_pNames->FindNames(relativeToScope, pPattern, pVisitor);
+    }
+
+    // Caches whole-path name lookups; see HierarchicalNames::EnableLookupCache.
+    HRESULT EnableNameLookupCache(_In_ UINT32 maxEntries) const { return m_pNames->EnableLookupCache(maxEntries); }
+
     HRESULT Clone(_Outptr_ IHierarchicalSchema** result) const;
 
     virtual HRESULT GetSchemaBlobFromFileSection(
@@ -504,6 +535,16 @@ public:
 
     bool TryGetReverseMapCandidateIndex(_In_ PCWSTR pCandidateValue, _Out_ int* pReverseMapIndexOut) const;
 
+    /*!
+         * Resolves a batch of candidate paths, writing the reverse map index
+         * of each path or -1 if it isn't in the map.  Returns S_FALSE if any
+         * path was not found.
+         */
+    HRESULT GetReverseMapCandidateIndexes(
+        _In_ int numCandidates,
+        _In_reads_(numCandidates) const PCWSTR* ppCandidateValues,
+        _Out_writes_(numCandidates) int* pReverseMapIndexesOut) const;
+
     _Success_(return ) _Check_return_ HRESULT
         GetCandidateInfo(_In_ int reverseMapIndex, _Out_ int* pQualifierSetIndexOut, _Out_ int* pNamedResourceIndexOut) const;
 
@@ -516,9 +557,15 @@ private:
     const MRMFILE_REVERSEFILEMAP_ENTRY* m_pEntries{ nullptr };
     const HierarchicalNames* m_pNames{ nullptr };
     int m_cbSection{ 0 };
+    mutable volatile LONG m_pathIndexRequested{ 0 };
+
+    // Maps with fewer names than this are cheap enough to search directly
+    static const int MinNamesToIndex = 32;
 
     ReverseFileMap();
 
+    void EnsurePathIndex() const;
+
     HRESULT Init(_In_opt_ const IFileSection* pSection, _In_reads_bytes_(cbData) const void* pData, _In_ int cbData);
 };
 
@@ -749,6 +796,11 @@ public:
 
     HRESULT GetResourceNameBySchemaIndex(_In_ int indexInSchema, _Inout_ StringResult* pNameOut) const;
 
+    // Visits the resources and scopes below this one whose names, relative
+    // to this scope, match a prefix or glob pattern such as "Icons/" or
+    // "*Title*".  Nothing is materialized for names that don't match.
+    HRESULT FindDescendents(_In_ PCWSTR pPattern, _In_ IHierarchicalNamesVisitor* pVisitor) const;
+
     // Gets the name of the resource relative to this scope
     HRESULT GetDescendentResourceName(_In_ int index, _Inout_ StringResult* pNameOut) const;
 
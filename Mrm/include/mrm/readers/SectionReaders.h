@@ -38,16 +38,28 @@ protected:
 
     _Field_size_(m_pHeader->numSmallItems) const DEFFILE_DATA_ITEM_SMALL* m_pSmallItems;
     _Field_size_(m_pHeader->numLargeItems) const DEFFILE_DATA_ITEM_LARGE* m_pLargeItems;
+    _Field_size_(m_numChunkRefs) const DEFFILE_DATA_ITEM_LARGE* m_pChunkRefs;
+    UINT32 m_numChunkRefs;
     _Field_size_bytes_(m_pHeader->cbData) const BYTE* m_pData;
 
     FileDataItemsSection& operator=(const FileDataSection&) {}
 
-    FileDataItemsSection() : m_pHeader(nullptr), m_pSmallItems(nullptr), m_pLargeItems(nullptr), m_pData(nullptr) {}
+    FileDataItemsSection() :
+        m_pHeader(nullptr), m_pSmallItems(nullptr), m_pLargeItems(nullptr), m_pChunkRefs(nullptr), m_numChunkRefs(0), m_pData(nullptr)
+    {}
 
     HRESULT Init(_In_opt_ const IFileSection* pSection, _In_reads_bytes_(cbData) const void* pData, _In_ int cbData);
 
     HRESULT ValidateHeader(_In_reads_bytes_(cbData) const void* pData, _In_ UINT32 cbData);
 
+    bool IsChunked() const { return ((m_pHeader->flags & DEFFILE_DATAITEMS_CHUNKED_LARGE_ITEMS) != 0); }
+
+    HRESULT GetChunkedItemInfo(
+        _In_ UINT32 largeItemIndex,
+        _Out_ UINT32* pFirstChunkRef,
+        _Out_ UINT32* pNumChunkRefs,
+        _Out_ bool* pIsContiguous) const;
+
 public:
     static HRESULT CreateInstance(_In_reads_bytes_(cbData) const void* pData, _In_ int cbData, _Outptr_ FileDataItemsSection** result);
     static HRESULT CreateInstance(_In_ IFileSection* pSection, _Outptr_ FileDataItemsSection** result);
@@ -10,11 +10,12 @@ HRESULT DataItemOrchestrator::CreateInstance(
     _In_ FileBuilder* fileBuilder,
     _In_ CoreProfile* profile,
     _In_ DecisionInfoSectionBuilder* decisionInfo,
-    _Outptr_ DataItemOrchestrator** result)
+    _Outptr_ DataItemOrchestrator** result,
+    _In_opt_ DefArena* arena)
 {
     *result = nullptr;
 
-    AutoDeletePtr<DataItemOrchestrator> rtrn = new DataItemOrchestrator(fileBuilder, profile, decisionInfo);
+    AutoDeletePtr<DataItemOrchestrator> rtrn = new DataItemOrchestrator(fileBuilder, profile, decisionInfo, arena);
     RETURN_IF_NULL_ALLOC(rtrn);
     RETURN_IF_FAILED(rtrn->Init());
 
@@ -25,22 +26,25 @@ HRESULT DataItemOrchestrator::CreateInstance(
 DataItemOrchestrator::DataItemOrchestrator(
     _In_ FileBuilder* fileBuilder,
     _In_ CoreProfile* profile,
-    _In_ DecisionInfoSectionBuilder* decisionInfo) :
+    _In_ DecisionInfoSectionBuilder* decisionInfo,
+    _In_opt_ DefArena* arena) :
     m_finalized(false),
     m_profile(profile),
     m_fileBuilder(fileBuilder),
     m_decisionInfo(decisionInfo),
     m_allBuilders(nullptr),
     m_buildersByQualifierSet(nullptr),
+    m_chunkedBuilder(nullptr),
     m_buildConfiguration(profile->GetBuildConfiguration()),
-    m_OrchestratorHashMap(nullptr)
+    m_OrchestratorHashMap(nullptr),
+    m_arena(arena)
 {}
 
 HRESULT DataItemOrchestrator::Init()
 {
     RETURN_IF_FAILED(DynamicArray<DataItemsSectionBuilder*>::CreateInstance(10, &m_allBuilders));
     RETURN_IF_FAILED(DynamicArray<DataItemsSectionBuilder*>::CreateInstance(10, &m_buildersByQualifierSet));
-    RETURN_IF_FAILED(OrchestratorHashMap::CreateInstance(1019, 0.75, &m_OrchestratorHashMap));
+    RETURN_IF_FAILED(OrchestratorHashMap::CreateInstance(1019, 0.75, &m_OrchestratorHashMap, m_arena));
 
     return S_OK;
 }
@@ -122,6 +126,35 @@ HRESULT DataItemOrchestrator::GetOrAddDataItemSectionBuilder(_In_ int qualifierS
     return S_OK;
 }
 
+HRESULT DataItemOrchestrator::GetOrAddDataItemSectionBuilder(
+    _In_ int qualifierSetIndex,
+    _In_ UINT valueSizeInBytes,
+    _Out_ DataItemsSectionBuilder** result)
+{
+    *result = nullptr;
+    RETURN_HR_IF(E_DEF_ALREADY_INITIALIZED, m_finalized);
+
+    // With chunk deduplication, large blobs from every qualifier set share one chunked section so that
+    // similar assets (e.g. scale variants) can share chunks.  Everything else keeps per-qualifier sections.
+    if (!m_buildConfiguration->UseChunkDeduplication() || (valueSizeInBytes <= DEFFILE_SMALL_DATA_ITEM_MAX_SIZE))
+    {
+        return GetOrAddDataItemSectionBuilder(qualifierSetIndex, result);
+    }
+
+    if (m_chunkedBuilder == nullptr)
+    {
+        AutoDeletePtr<DataItemsSectionBuilder> autoBuilder;
+        RETURN_IF_FAILED(DataItemsSectionBuilder::CreateInstance(DataItemsSectionBuilder::ChunkLargeItemsFlag, &autoBuilder));
+        RETURN_IF_FAILED(m_fileBuilder->AddSection(autoBuilder));
+        RETURN_IF_FAILED(m_allBuilders->Add(autoBuilder));
+
+        m_chunkedBuilder = autoBuilder.Detach();
+    }
+
+    *result = m_chunkedBuilder;
+    return S_OK;
+}
+
 HRESULT DataItemOrchestrator::AddDataAndCreateInstanceReference(
     _In_reads_bytes_(valueSizeInBytes) const void* value,
     _In_ UINT valueSizeInBytes,
@@ -143,7 +176,7 @@ HRESULT DataItemOrchestrator::AddDataAndCreateInstanceReference(
         if (dataRefereceFromMap == nullptr)
         {
             DataItemsSectionBuilder* dataItemSectionBuilder;
-            RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
+            RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, valueSizeInBytes, &dataItemSectionBuilder));
 
             RETURN_IF_FAILED(dataItemSectionBuilder->AddDataItem(value, valueSizeInBytes, &preBuildReference));
 
@@ -164,7 +197,7 @@ HRESULT DataItemOrchestrator::AddDataAndCreateInstanceReference(
     else
     {
         DataItemsSectionBuilder* dataItemSectionBuilder;
-        RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
+        RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, valueSizeInBytes, &dataItemSectionBuilder));
 
         RETURN_IF_FAILED(dataItemSectionBuilder->AddDataItem(value, valueSizeInBytes, &preBuildReference));
 
@@ -265,42 +298,40 @@ HRESULT DataItemOrchestrator::AddStringAndCreateInstanceReference(
 }
 
 HRESULT DataItemOrchestrator::OptimizeString(
-    _Out_writes_bytes_to_(convertedStringSize, *writtenBytesIncludingNull) char* convertedString,
+    _In_ MrmEnvironment::ResourceValueType originalType,
     _In_ PCWSTR value,
-    _Inout_ size_t* writtenBytesIncludingNull,
-    _In_ size_t convertedStringSize,
-    _In_ MrmEnvironment::ResourceValueType* optimalType)
+    _Inout_ BlobResult* convertedStringResult,
+    _Outptr_result_maybenull_ char** convertedString,
+    _Out_ size_t* writtenBytesIncludingNull,
+    _Out_ MrmEnvironment::ResourceValueType* optimalType)
 {
-    _Analysis_assume_(*writtenBytesIncludingNull < convertedStringSize);
-    DEF_ASSERT(*writtenBytesIncludingNull < convertedStringSize);
+    *convertedString = nullptr;
+    *writtenBytesIncludingNull = 0;
+    *optimalType = originalType;
 
-    if (MrmEnvironment::IsAsciiResourceValueType(*optimalType))
-    {
-        // WideCharToMultiByte supports only ANSI, not pure ASCII. So hand-roll an implementation here.
-        for (size_t i = 0; i < *writtenBytesIncludingNull; i++)
-        {
-            DEF_ASSERT(value[i] <= 127); // Established by the encoding chooser.
-            convertedString[i] = static_cast<char>(value[i]);
-        }
+    // We know that the narrowed string is never larger than the UTF-16 one, else we wouldn't bother converting it,
+    // so a buffer the size of the original is always enough.  Classification and conversion happen in one pass;
+    // if the string turns out to need UTF-16 the buffer is simply left unused.
+    size_t valueLength = wcslen(value);
+    size_t valueLengthAfterAdd;
+    size_t convertedStringSize;
+    RETURN_IF_FAILED(SizeTAdd(valueLength, 1, &valueLengthAfterAdd));
+    RETURN_IF_FAILED(SizeTMult(valueLengthAfterAdd, sizeof(WCHAR), &convertedStringSize));
 
-        convertedString[*writtenBytesIncludingNull] = '\0';
-        *writtenBytesIncludingNull =
-            *writtenBytesIncludingNull + 1; // Count the null terminator here since WideCharToMultiByte returns the size with it included.
-    }
-    else
+    char* buffer;
+    RETURN_IF_FAILED(convertedStringResult->SetEmptyContents(convertedStringSize, (void**)&buffer));
+
+    DEFSTRING_ENCODING bestEncoding;
+    size_t written;
+    RETURN_IF_FAILED(DefString_ChooseBestEncodingAndNarrow(value, valueLength, buffer, convertedStringSize, &bestEncoding, &written));
+
+    // Override the provided resource value type with the optimal one.
+    *optimalType = MrmEnvironment::ConvertToBestValueType(originalType, bestEncoding);
+
+    if (!MrmEnvironment::IsUtf16ResourceValueType(*optimalType))
     {
-        int convertedSize = WideCharToMultiByte(
-            CP_UTF8,
-            0,
-            value,
-            static_cast<int>(*writtenBytesIncludingNull + 1),
-            convertedString,
-            static_cast<int>(convertedStringSize),
-            nullptr,
-            nullptr);
-        RETURN_LAST_ERROR_IF(convertedSize == 0);
-
-        *writtenBytesIncludingNull = static_cast<size_t>(convertedSize);
+        *convertedString = buffer;
+        *writtenBytesIncludingNull = written;
     }
     return S_OK;
 }
@@ -323,8 +354,11 @@ HRESULT DataItemOrchestrator::AddOptimizedStringAndCreateInstanceReference(
         DEF_CHECKSUM defCheckSum = 0;
         OrchestratorDataReference* buildInstanceReference = nullptr;
 
-        // Override the provided resource value type with the optimal one.
-        *optimalType = MrmEnvironment::ConvertToBestValueType(originalType, DefString_ChooseBestEncoding(value));
+        BlobResult convertedStringResult;
+        char* convertedString;
+        size_t writtenBytesIncludingNull;
+        RETURN_IF_FAILED(
+            OptimizeString(originalType, value, &convertedStringResult, &convertedString, &writtenBytesIncludingNull, optimalType));
 
         if (!MrmEnvironment::IsUtf16ResourceValueType(*optimalType))
         {
@@ -333,15 +367,6 @@ HRESULT DataItemOrchestrator::AddOptimizedStringAndCreateInstanceReference(
             // Therefore we convert the stirng at first so we can check its check sum and serach for a duplicaiton,
             // then create OrchestratorDataReference instance to store the converted string.
 
-            // We know that the new string is less than the size of the existing one, else we wouldn't bother converting it.
-            size_t writtenBytesIncludingNull = wcslen(value);
-            size_t convertedStringSize = (writtenBytesIncludingNull + 1) * sizeof(wchar_t);
-            BlobResult convertedStringResult;
-            char* convertedString;
-            RETURN_IF_FAILED(convertedStringResult.SetEmptyContents(convertedStringSize, (void**)&convertedString));
-
-            RETURN_IF_FAILED(OptimizeString(convertedString, value, &writtenBytesIncludingNull, convertedStringSize, optimalType));
-
             // Converting finished. Check duplication.
             defCheckSum = DefChecksum::ComputeChecksum(
                 0, reinterpret_cast<const BYTE*>(convertedString), static_cast<UINT32>(writtenBytesIncludingNull));
@@ -410,20 +435,14 @@ HRESULT DataItemOrchestrator::AddOptimizedStringAndCreateInstanceReference(
         DataItemsSectionBuilder* dataItemSectionBuilder;
         RETURN_IF_FAILED(GetOrAddDataItemSectionBuilder(qualifierSetIndex, &dataItemSectionBuilder));
 
-        // Override the provided resource value type with the optimal one.
-        *optimalType = MrmEnvironment::ConvertToBestValueType(originalType, DefString_ChooseBestEncoding(value));
+        BlobResult convertedStringResult;
+        char* convertedString;
+        size_t writtenBytesIncludingNull;
+        RETURN_IF_FAILED(
+            OptimizeString(originalType, value, &convertedStringResult, &convertedString, &writtenBytesIncludingNull, optimalType));
 
         if (!MrmEnvironment::IsUtf16ResourceValueType(*optimalType))
         {
-            // We know that the new string is less than the size of the existing one, else we wouldn't bother converting it.
-            size_t writtenBytesIncludingNull = wcslen(value);
-            size_t convertedStringSize = (writtenBytesIncludingNull + 1) * sizeof(wchar_t);
-            BlobResult convertedStringResult;
-            char* convertedString;
-            RETURN_IF_FAILED(convertedStringResult.SetEmptyContents(convertedStringSize, (void**)&convertedString));
-
-            RETURN_IF_FAILED(OptimizeString(convertedString, value, &writtenBytesIncludingNull, convertedStringSize, optimalType));
-
             RETURN_IF_FAILED(
                 dataItemSectionBuilder->AddDataItem(convertedString, static_cast<UINT32>(writtenBytesIncludingNull), &preBuildReference));
         }
@@ -490,6 +509,8 @@ HRESULT OrchestratorDataReference::CreateInstance(
 
     RETURN_HR_IF(E_INVALIDARG, (builder == nullptr) || (preBuildItemReference == nullptr));
 
+    // References are handed back to callers that can outlive the builder and
+    // its arena, so they always come from the process heap.
     AutoDeletePtr<OrchestratorDataReference> orchestratorDataRef = new OrchestratorDataReference(valueHash, builder, preBuildItemReference);
     RETURN_IF_NULL_ALLOC(orchestratorDataRef);
     RETURN_IF_FAILED(orchestratorDataRef->Init(actualValue, valueSizeInBytes));
@@ -596,12 +617,13 @@ size_t OrchestratorDataReference::GetActualValueSize() const { return m_actualDa
 HRESULT OrchestratorHashNode::CreateInstance(
     _In_ DEF_CHECKSUM valueHash,
     _In_ OrchestratorDataReference* dataReference,
-    _Outptr_ OrchestratorHashNode** result)
+    _Outptr_ OrchestratorHashNode** result,
+    _In_opt_ DefArena* pArena)
 {
     *result = nullptr;
     RETURN_HR_IF_NULL(E_INVALIDARG, dataReference);
 
-    OrchestratorHashNode* hashNode = new OrchestratorHashNode(valueHash, dataReference);
+    OrchestratorHashNode* hashNode = new (pArena) OrchestratorHashNode(valueHash, dataReference);
     RETURN_IF_NULL_ALLOC(hashNode);
 
     *result = hashNode;
@@ -639,8 +661,8 @@ OrchestratorHashMap::~OrchestratorHashMap()
     }
 }
 
-OrchestratorHashMap::OrchestratorHashMap(_In_ int initCapacity, _In_ float loadFactor) :
-    m_currentSize(initCapacity), m_nodeCount(0), m_loadFactor(loadFactor)
+OrchestratorHashMap::OrchestratorHashMap(_In_ int initCapacity, _In_ float loadFactor, _In_opt_ DefArena* pArena) :
+    m_currentSize(initCapacity), m_nodeCount(0), m_loadFactor(loadFactor), m_pArena(pArena)
 {}
 
 HRESULT OrchestratorHashMap::Init(int initCapacity)
@@ -649,11 +671,15 @@ HRESULT OrchestratorHashMap::Init(int initCapacity)
     return S_OK;
 }
 
-HRESULT OrchestratorHashMap::CreateInstance(_In_ int initCapacity, _In_ float loadFactor, _Outptr_ OrchestratorHashMap** result)
+HRESULT OrchestratorHashMap::CreateInstance(
+    _In_ int initCapacity,
+    _In_ float loadFactor,
+    _Outptr_ OrchestratorHashMap** result,
+    _In_opt_ DefArena* pArena)
 {
     *result = nullptr;
 
-    AutoDeletePtr<OrchestratorHashMap> orchsHashMap = new OrchestratorHashMap(initCapacity, loadFactor);
+    AutoDeletePtr<OrchestratorHashMap> orchsHashMap = new OrchestratorHashMap(initCapacity, loadFactor, pArena);
     RETURN_IF_NULL_ALLOC(orchsHashMap);
     RETURN_IF_FAILED(orchsHashMap->Init(initCapacity));
 
@@ -682,7 +708,7 @@ HRESULT OrchestratorHashMap::AddtoMap(_In_ DEF_CHECKSUM key, _In_ OrchestratorDa
     m_entries->TryGet(valueIndex, &existingNode);
 
     AutoDeletePtr<OrchestratorHashNode> newHashNode;
-    RETURN_IF_FAILED(OrchestratorHashNode::CreateInstance(key, dataReference, &newHashNode));
+    RETURN_IF_FAILED(OrchestratorHashNode::CreateInstance(key, dataReference, &newHashNode, m_pArena));
 
     RETURN_IF_FAILED(m_entries->ExtendAndSet(valueIndex, newHashNode, &existingNode));
     OrchestratorHashNode* newLocalHasNode = newHashNode.Detach();
@@ -283,7 +283,56 @@ DataSectionBuilder::~DataSectionBuilder() {}
      * DataItemsSectionBuilder
      */
 
-DataItemsSectionBuilder::DataItemsSectionBuilder() :
+// Content-defined chunking parameters for chunked large items.  Boundaries are chosen by a
+// gear rolling hash over the last 64 bytes, so an insertion or deletion only disturbs the
+// chunks around it.  Fourteen mask bits give chunks of about 16KB past the minimum size.
+static const UINT32 MinChunkSize = 2 * 1024;
+static const UINT32 MaxChunkSize = 64 * 1024;
+static const UINT32 ChunkHashWindow = 64;
+static const UINT64 ChunkBoundaryMask = 0xFFFC000000000000ull;
+
+struct ChunkGearTable
+{
+    UINT64 values[256];
+
+    constexpr ChunkGearTable() : values()
+    {
+        // splitmix64 finalizer; must never change since it determines chunk boundaries
+        for (int i = 0; i < 256; i++)
+        {
+            UINT64 z = (static_cast<UINT64>(i) + 1) * 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            values[i] = z ^ (z >> 31);
+        }
+    }
+};
+
+static constexpr ChunkGearTable s_chunkGearTable;
+
+static UINT32 FindChunkBoundary(_In_reads_bytes_(cbData) const BYTE* pData, _In_ UINT32 cbData)
+{
+    if (cbData <= MinChunkSize)
+    {
+        return cbData;
+    }
+
+    UINT32 cbMax = ((cbData < MaxChunkSize) ? cbData : MaxChunkSize);
+    UINT64 hash = 0;
+
+    // Prime the hash with the window preceding the minimum chunk size
+    for (UINT32 i = MinChunkSize - ChunkHashWindow; i < cbMax; i++)
+    {
+        hash = (hash << 1) + s_chunkGearTable.values[pData[i]];
+        if ((i >= MinChunkSize) && ((hash & ChunkBoundaryMask) == 0))
+        {
+            return i + 1;
+        }
+    }
+    return cbMax;
+}
+
+DataItemsSectionBuilder::DataItemsSectionBuilder(_In_ UINT32 flags) :
     m_finalized(false),
     m_sectionIndex(BaseFile::SectionIndexNone),
     m_numSmallItems(0),
@@ -297,14 +346,26 @@ DataItemsSectionBuilder::DataItemsSectionBuilder() :
     m_cbLargeItemDataUsed(0),
     m_cbLargeItemDataCapacity(0),
     m_pLargeItemData(NULL),
-    m_pLargeItems(NULL)
+    m_pLargeItems(NULL),
+    m_flags(flags),
+    m_numChunks(0),
+    m_sizeChunks(0),
+    m_pChunks(NULL),
+    m_numChunkRefs(0),
+    m_sizeChunkRefs(0),
+    m_pChunkRefs(NULL),
+    m_sizeChunkIndex(0),
+    m_pChunkIndex(NULL)
 {}
 
-HRESULT DataItemsSectionBuilder::CreateInstance(_Outptr_ DataItemsSectionBuilder** result)
+HRESULT DataItemsSectionBuilder::CreateInstance(_Outptr_ DataItemsSectionBuilder** result) { return CreateInstance(0, result); }
+
+HRESULT DataItemsSectionBuilder::CreateInstance(_In_ UINT32 flags, _Outptr_ DataItemsSectionBuilder** result)
 {
     *result = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, (flags & ~ChunkLargeItemsFlag) != 0);
 
-    DataItemsSectionBuilder* pRtrn = new DataItemsSectionBuilder();
+    DataItemsSectionBuilder* pRtrn = new DataItemsSectionBuilder(flags);
     RETURN_IF_NULL_ALLOC(pRtrn);
 
     *result = pRtrn;
@@ -340,6 +401,25 @@ DataItemsSectionBuilder::~DataItemsSectionBuilder()
         Def_Free(m_pLargeItemData);
         m_pLargeItemData = NULL;
     }
+
+    m_numChunks = m_sizeChunks = 0;
+    m_numChunkRefs = m_sizeChunkRefs = 0;
+    m_sizeChunkIndex = 0;
+    if (m_pChunks != NULL)
+    {
+        Def_Free(m_pChunks);
+        m_pChunks = NULL;
+    }
+    if (m_pChunkRefs != NULL)
+    {
+        Def_Free(m_pChunkRefs);
+        m_pChunkRefs = NULL;
+    }
+    if (m_pChunkIndex != NULL)
+    {
+        Def_Free(m_pChunkIndex);
+        m_pChunkIndex = NULL;
+    }
 }
 
 HRESULT DataItemsSectionBuilder::AddDataItem(
@@ -387,6 +467,10 @@ HRESULT DataItemsSectionBuilder::AddDataItem(
         m_cbSmallItemDataUsed = startOffset + cbData;
         m_numSmallItems++;
     }
+    else if (IsChunked())
+    {
+        RETURN_IF_FAILED(AddChunkedItem(static_cast<const BYTE*>(pData), cbData, align, pRefOut));
+    }
     else
     {
         startOffset = _DEFFILE_PAD(m_cbLargeItemDataUsed, align);
@@ -423,6 +507,167 @@ HRESULT DataItemsSectionBuilder::AddDataItem(
     return S_OK;
 }
 
+HRESULT DataItemsSectionBuilder::AddChunkedItem(
+    __in_bcount(cbData) const BYTE* pData,
+    __in UINT32 cbData,
+    __in int align,
+    __out PrebuildItemReference* pRefOut)
+{
+    RETURN_IF_FAILED(EnsureLargeItemCapacity(m_cbLargeItemDataUsed));
+
+    __analysis_assume((m_numLargeItems < m_sizeLargeItems));
+
+    int firstChunkRef = m_numChunkRefs;
+    HRESULT hr = S_OK;
+    for (UINT32 offset = 0; offset < cbData;)
+    {
+        UINT32 cbChunk = FindChunkBoundary(&pData[offset], cbData - offset);
+
+        // Only the item's first chunk needs aligning; if it and its successors are all
+        // new they are appended back to back, so the item stays contiguous and aligned
+        // just like an unchunked one.
+        int chunkIndex;
+        int numChunkRefs = 0;
+        UINT32 nextOffset = 0;
+        hr = GetOrAddChunk(&pData[offset], cbChunk, ((offset == 0) ? align : 1), &chunkIndex);
+        if (SUCCEEDED(hr))
+        {
+            hr = IntAdd(m_numChunkRefs, 1, &numChunkRefs);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = EnsureChunkRefCapacity(numChunkRefs);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = UIntAdd(offset, cbChunk, &nextOffset);
+        }
+        if (FAILED(hr))
+        {
+            // Chunks already added are harmless, but the item's refs must not survive
+            m_numChunkRefs = firstChunkRef;
+            return hr;
+        }
+
+        m_pChunkRefs[m_numChunkRefs++] = chunkIndex;
+        offset = nextOffset;
+    }
+
+    m_pLargeItems[m_numLargeItems].offset = firstChunkRef;
+    m_pLargeItems[m_numLargeItems].cbData = cbData;
+
+    pRefOut->isLarge = true;
+    pRefOut->index = m_numLargeItems;
+
+    m_numLargeItems++;
+    return S_OK;
+}
+
+HRESULT DataItemsSectionBuilder::GetOrAddChunk(
+    __in_bcount(cbData) const BYTE* pData,
+    __in UINT32 cbData,
+    __in int align,
+    __out int* pChunkIndexOut)
+{
+    *pChunkIndexOut = -1;
+
+    int cbChunk;
+    RETURN_IF_FAILED(UIntToInt(cbData, &cbChunk));
+
+    DEF_CHECKSUM checksum = DefChecksum::ComputeChecksum(0, pData, cbData);
+
+    if (m_pChunkIndex != NULL)
+    {
+        int mask = m_sizeChunkIndex - 1;
+        for (int slot = (checksum & mask); m_pChunkIndex[slot] != 0; slot = ((slot + 1) & mask))
+        {
+            int chunkIndex = m_pChunkIndex[slot] - 1;
+            const ChunkInfo* pChunk = &m_pChunks[chunkIndex];
+            if ((pChunk->checksum == checksum) && (pChunk->cbData == cbChunk) &&
+                (memcmp(&m_pLargeItemData[pChunk->offset], pData, cbData) == 0))
+            {
+                *pChunkIndexOut = chunkIndex;
+                return S_OK;
+            }
+        }
+    }
+
+    // New chunk.  Keep the index at most half full so probe sequences stay short.
+    if (((m_numChunks + 1) * 2) > m_sizeChunkIndex)
+    {
+        RETURN_IF_FAILED(GrowChunkIndex());
+    }
+
+    if (m_numChunks >= m_sizeChunks)
+    {
+        int newSize = ((m_sizeChunks == 0) ? InitialChunkSize : (m_sizeChunks * 2));
+        if (!_DefArray_TryEnsureSize(&m_pChunks, struct ChunkInfo, m_sizeChunks, newSize))
+        {
+            return E_OUTOFMEMORY;
+        }
+        m_sizeChunks = newSize;
+    }
+
+    // Pad here rather than in AddChunkedItem, so a first chunk that turns out to be
+    // a duplicate doesn't leave unused alignment bytes behind.
+    int startOffset;
+    int cbTotal;
+    RETURN_IF_FAILED(IntAdd(m_cbLargeItemDataUsed, (align - 1), &startOffset));
+    startOffset -= (startOffset % align);
+    RETURN_IF_FAILED(IntAdd(startOffset, cbChunk, &cbTotal));
+    RETURN_IF_FAILED(EnsureLargeItemCapacity(cbTotal));
+
+    while (m_cbLargeItemDataUsed < startOffset)
+    {
+        m_pLargeItemData[m_cbLargeItemDataUsed++] = 0;
+    }
+
+    errno_t err = memcpy_s(&m_pLargeItemData[startOffset], (m_cbLargeItemDataCapacity - startOffset), pData, cbData);
+    RETURN_IF_FAILED(ErrnoToHResult(err));
+    m_cbLargeItemDataUsed = cbTotal;
+
+    m_pChunks[m_numChunks].offset = startOffset;
+    m_pChunks[m_numChunks].cbData = cbChunk;
+    m_pChunks[m_numChunks].checksum = checksum;
+
+    int mask = m_sizeChunkIndex - 1;
+    int slot = (checksum & mask);
+    while (m_pChunkIndex[slot] != 0)
+    {
+        slot = ((slot + 1) & mask);
+    }
+    m_pChunkIndex[slot] = m_numChunks + 1;
+
+    *pChunkIndexOut = m_numChunks++;
+    return S_OK;
+}
+
+HRESULT DataItemsSectionBuilder::GrowChunkIndex()
+{
+    int newSize = ((m_sizeChunkIndex == 0) ? InitialChunkIndexSize : (m_sizeChunkIndex * 2));
+    int* pNewIndex = _DefArray_AllocZeroed(int, newSize);
+    RETURN_IF_NULL_ALLOC(pNewIndex);
+
+    int mask = newSize - 1;
+    for (int i = 0; i < m_numChunks; i++)
+    {
+        int slot = (m_pChunks[i].checksum & mask);
+        while (pNewIndex[slot] != 0)
+        {
+            slot = ((slot + 1) & mask);
+        }
+        pNewIndex[slot] = i + 1;
+    }
+
+    if (m_pChunkIndex != NULL)
+    {
+        Def_Free(m_pChunkIndex);
+    }
+    m_pChunkIndex = pNewIndex;
+    m_sizeChunkIndex = newSize;
+    return S_OK;
+}
+
 HRESULT DataItemsSectionBuilder::AddDataString(__in PCWSTR pString, __out PrebuildItemReference* pRefOut)
 {
     RETURN_HR_IF_NULL(E_INVALIDARG, pString);
@@ -482,6 +727,41 @@ HRESULT DataItemsSectionBuilder::GetDataBlob(_In_ int itemIndex, _Inout_ BlobRes
 
         int indexFromLargeBase = itemIndex - m_numSmallItems;
 
+        if (IsChunked())
+        {
+            const struct ItemRef* pItem = &m_pLargeItems[indexFromLargeBase];
+
+            // Hand out a direct reference when the chunks are back-to-back; otherwise reassemble.
+            int cbContiguous = 0;
+            int chunkRef = pItem->offset;
+            const ChunkInfo* pFirstChunk = &m_pChunks[m_pChunkRefs[chunkRef]];
+            while ((cbContiguous < pItem->cbData) && (m_pChunks[m_pChunkRefs[chunkRef]].offset == (pFirstChunk->offset + cbContiguous)))
+            {
+                cbContiguous += m_pChunks[m_pChunkRefs[chunkRef++]].cbData;
+            }
+
+            if (cbContiguous >= pItem->cbData)
+            {
+                RETURN_IF_FAILED(pBlobResult->SetRef(&m_pLargeItemData[pFirstChunk->offset], pItem->cbData));
+                return S_OK;
+            }
+
+            BYTE* pBuf = nullptr;
+            RETURN_IF_FAILED(pBlobResult->SetEmptyContents(pItem->cbData, (void**)&pBuf, nullptr));
+
+            int cbCopied = 0;
+            for (chunkRef = pItem->offset; cbCopied < pItem->cbData; chunkRef++)
+            {
+                const ChunkInfo* pChunk = &m_pChunks[m_pChunkRefs[chunkRef]];
+                CopyMemory(&pBuf[cbCopied], &m_pLargeItemData[pChunk->offset], pChunk->cbData);
+                cbCopied += pChunk->cbData;
+            }
+
+            // The buffer may be larger than the item if it was reused
+            RETURN_IF_FAILED(pBlobResult->SetRef(pBuf, pItem->cbData));
+            return S_OK;
+        }
+
         int offset = m_pLargeItems[indexFromLargeBase].offset;
         RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), offset >= m_cbLargeItemDataCapacity);
 
@@ -506,6 +786,10 @@ UINT32 DataItemsSectionBuilder::GetMaxSizeInBytes() const
 {
     UINT32 maxSize = sizeof(DEFFILE_DATAITEMS_HEADER) + (m_numSmallItems * sizeof(DEFFILE_DATA_ITEM_SMALL)) +
                      (m_numLargeItems * sizeof(DEFFILE_DATA_ITEM_LARGE)) + m_cbSmallItemDataUsed;
+    if (IsChunked())
+    {
+        maxSize += sizeof(DEFFILE_DATAITEMS_CHUNK_TABLE) + (m_numChunkRefs * sizeof(DEFFILE_DATA_ITEM_LARGE));
+    }
     // align to 64 bits before the large items section
     maxSize = _DEFFILE_PAD(maxSize, BaseFile::Align64Bit) + _DEFFILE_PAD(m_cbLargeItemDataUsed, BaseFile::Align64Bit);
     return maxSize;
@@ -543,6 +827,10 @@ HRESULT DataItemsSectionBuilder::Build(__out_bcount(cbBuffer) VOID* pBuffer, __i
     {
         pHdr->flags = 0;
     }
+    if (IsChunked())
+    {
+        pHdr->flags |= DEFFILE_DATAITEMS_CHUNKED_LARGE_ITEMS;
+    }
     pHdr->numSmallItems = static_cast<UINT16>(m_numSmallItems);
     pHdr->numLargeItems = static_cast<UINT16>(m_numLargeItems);
     pHdr->cbData = 0; // we'll update later with what we actually write
@@ -564,24 +852,52 @@ HRESULT DataItemsSectionBuilder::Build(__out_bcount(cbBuffer) VOID* pBuffer, __i
         }
     }
 
+    DEFFILE_DATA_ITEM_LARGE* pLargeItems = NULL;
     if (m_numLargeItems > 0)
     {
-        DEFFILE_DATA_ITEM_LARGE* pItems = _SECTION_BUILDER_NEXT_ARRAY(data, m_numLargeItems, DEFFILE_DATA_ITEM_LARGE, &hr);
+        pLargeItems = _SECTION_BUILDER_NEXT_ARRAY(data, m_numLargeItems, DEFFILE_DATA_ITEM_LARGE, &hr);
+        RETURN_IF_FAILED(hr);
+    }
+
+    DEFFILE_DATA_ITEM_LARGE* pChunkRefs = NULL;
+    if (IsChunked())
+    {
+        DEFFILE_DATAITEMS_CHUNK_TABLE* pChunkTable = _SECTION_BUILDER_NEXT(data, DEFFILE_DATAITEMS_CHUNK_TABLE, &hr);
         RETURN_IF_FAILED(hr);
 
-        // Large data starts at the first 64-bit boundary after the small data.
-        UINT32 dataOffset = static_cast<UINT32>(
-            _DEFFILE_PAD(data.UsedBufferSizeInBytes() + m_cbSmallItemDataUsed, BaseFile::Align64Bit) - data.UsedBufferSizeInBytes());
+        pChunkTable->numChunkRefs = static_cast<UINT32>(m_numChunkRefs);
+        pChunkTable->reserved = 0;
 
+        if (m_numChunkRefs > 0)
+        {
+            pChunkRefs = _SECTION_BUILDER_NEXT_ARRAY(data, m_numChunkRefs, DEFFILE_DATA_ITEM_LARGE, &hr);
+            RETURN_IF_FAILED(hr);
+        }
+    }
+
+    // Large data starts at the first 64-bit boundary after the small data.
+    UINT32 dataOffset = static_cast<UINT32>(
+        _DEFFILE_PAD(data.UsedBufferSizeInBytes() + m_cbSmallItemDataUsed, BaseFile::Align64Bit) - data.UsedBufferSizeInBytes());
+
+    if (pLargeItems != NULL)
+    {
         __analysis_assume(m_sizeLargeItems >= m_numLargeItems);
 
-        if (pItems != NULL)
+        for (int i = 0; i < m_numLargeItems; i++)
         {
-            for (int i = 0; i < m_numLargeItems; i++)
-            {
-                pItems[i].cbData = static_cast<UINT32>(m_pLargeItems[i].cbData);
-                pItems[i].offset = static_cast<UINT32>(m_pLargeItems[i].offset + dataOffset);
-            }
+            // Chunked items locate their first chunk ref rather than their data
+            pLargeItems[i].cbData = static_cast<UINT32>(m_pLargeItems[i].cbData);
+            pLargeItems[i].offset = static_cast<UINT32>(IsChunked() ? m_pLargeItems[i].offset : (m_pLargeItems[i].offset + dataOffset));
+        }
+    }
+
+    if (pChunkRefs != NULL)
+    {
+        for (int i = 0; i < m_numChunkRefs; i++)
+        {
+            const ChunkInfo* pChunk = &m_pChunks[m_pChunkRefs[i]];
+            pChunkRefs[i].cbData = static_cast<UINT32>(pChunk->cbData);
+            pChunkRefs[i].offset = static_cast<UINT32>(pChunk->offset + dataOffset);
         }
     }
 
@@ -653,6 +969,23 @@ HRESULT DataItemsSectionBuilder::EnsureLargeItemCapacity(__in int cbTotal)
     return S_OK;
 }
 
+HRESULT DataItemsSectionBuilder::EnsureChunkRefCapacity(__in int numTotal)
+{
+    if (numTotal > m_sizeChunkRefs)
+    {
+        int newSize = ((m_sizeChunkRefs == 0) ? InitialChunkSize : (m_sizeChunkRefs * 2));
+        newSize = max(newSize, numTotal);
+
+        if (!_DefArray_TryEnsureSize(&m_pChunkRefs, int, m_sizeChunkRefs, newSize))
+        {
+            return E_OUTOFMEMORY;
+        }
+        m_sizeChunkRefs = newSize;
+    }
+
+    return S_OK;
+}
+
 HRESULT DataItemsSectionBuilder::EnsureSmallItemCapacity(__in int cbTotal)
 {
     // ensure space for the item
@@ -17,6 +17,10 @@ HRESULT FileAtomPoolBuilder::Init(_In_opt_ PCWSTR pDescription, _In_ WriteableSt
     m_finalized = false;
     m_flags = flags;
     m_hashMethod = ((flags & fIsCaseInsensitive) ? Atom::HashMethodCaseInsensitive : Atom::HashMethodDefault);
+    if (flags & fUseStrongHash)
+    {
+        m_hashMethod = static_cast<Atom::HashMethod>(m_hashMethod | Atom::HashMethodStrong);
+    }
 
     m_group = NULL;
     m_poolIndex = Atom::NullPoolIndex;
@@ -120,6 +124,27 @@ FileAtomPoolBuilder::~FileAtomPoolBuilder()
     }
 }
 
+HRESULT FileAtomPoolBuilder::SetUseStrongHash(bool useStrongHash)
+{
+    if (GetUsesStrongHash() == useStrongHash)
+    {
+        return S_OK;
+    }
+
+    m_flags = (useStrongHash ? (m_flags | fUseStrongHash) : (m_flags & ~fUseStrongHash));
+    m_hashMethod = static_cast<Atom::HashMethod>(
+        useStrongHash ? (m_hashMethod | Atom::HashMethodStrong) : (m_hashMethod & ~Atom::HashMethodStrong));
+
+    // Rehash anything already in the pool
+    for (Atom::Index i = 0; i < m_numAtoms; i++)
+    {
+        m_hash[i].hash = Atom::HashString(m_pStrings->GetString(m_offset[m_hash[i].index]), m_hashMethod);
+    }
+    m_finalized = false;
+
+    return S_OK;
+}
+
 HRESULT FileAtomPoolBuilder::Extend(__in size_t newSize)
 {
     if (newSize <= m_sizeAtoms)
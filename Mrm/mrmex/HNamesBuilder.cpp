@@ -116,7 +116,7 @@ HRESULT ItemInfo::CreateInstance(_In_ const HierarchicalNameSegment* pName, _In_
 {
     *result = nullptr;
 
-    AutoDeletePtr<ItemInfo> pRtrn = new ItemInfo(pParent);
+    AutoDeletePtr<ItemInfo> pRtrn = new (pParent->GetGlobalNodes()->GetArena()) ItemInfo(pParent);
     RETURN_IF_NULL_ALLOC(pRtrn);
     RETURN_IF_FAILED(pRtrn->Init(pName, pParent));
 
@@ -188,7 +188,7 @@ HRESULT ScopeInfo::CreateInstance(_In_ const HierarchicalNameSegment* pName, _In
     *result = nullptr;
     RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pName->GetName()) || (pParent == nullptr));
 
-    AutoDeletePtr<ScopeInfo> pRtrn = new ScopeInfo(pParent);
+    AutoDeletePtr<ScopeInfo> pRtrn = new (pParent->GetGlobalNodes()->GetArena()) ScopeInfo(pParent);
     RETURN_IF_NULL_ALLOC(pRtrn);
     RETURN_IF_FAILED(pRtrn->Init(pName));
 
@@ -207,7 +207,7 @@ HRESULT ScopeInfo::NewRootScope(__in IHNamesGlobalNodes* pGlobalNodes, _Outptr_
 {
     *result = nullptr;
 
-    AutoDeletePtr<ScopeInfo> pRtrn = new ScopeInfo(pGlobalNodes);
+    AutoDeletePtr<ScopeInfo> pRtrn = new (pGlobalNodes->GetArena()) ScopeInfo(pGlobalNodes);
     RETURN_IF_NULL_ALLOC(pRtrn);
     RETURN_IF_FAILED(pRtrn->Init());
     RETURN_IF_FAILED(pRtrn->AddToGlobal(nullptr));
@@ -395,30 +395,33 @@ HRESULT ScopeInfo::GetOrAddChildScope(_In_ const HierarchicalNameSegment* pSegme
         return HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
     }
 
-    AutoDeletePtr<ScopeInfo> pRtrn;
-    RETURN_IF_FAILED(ScopeInfo::CreateInstance(pSegment, this, &pRtrn));
-
+    // Look for an existing child first so we only allocate nodes that get inserted.
     HNamesNode* foundNode;
-    RETURN_IF_FAILED(GetOrAddChildNode(pRtrn, &foundNode));
-
-    if (foundNode != nullptr)
+    if (!TryGetChild(pSegment, &foundNode))
     {
-        // already exists
-        if (!foundNode->IsScope())
+        AutoDeletePtr<ScopeInfo> pRtrn;
+        RETURN_IF_FAILED(ScopeInfo::CreateInstance(pSegment, this, &pRtrn));
+        RETURN_IF_FAILED(GetOrAddChildNode(pRtrn, &foundNode));
+
+        if (foundNode == nullptr)
         {
-            // Oops. It exists but it's an item!
-            return HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY);
-        }
+            RETURN_IF_FAILED(pRtrn->AddToGlobal(this));
 
-        *result = foundNode->ToScope();
-        return S_OK;
+            m_numChildScopes++;
+            NoteSubscopeChanges(1, 0);
+            *result = pRtrn.Detach();
+            return S_OK;
+        }
     }
 
-    RETURN_IF_FAILED(pRtrn->AddToGlobal(this));
+    // already exists
+    if (!foundNode->IsScope())
+    {
+        // Oops. It exists but it's an item!
+        return HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY);
+    }
 
-    m_numChildScopes++;
-    NoteSubscopeChanges(1, 0);
-    *result = pRtrn.Detach();
+    *result = foundNode->ToScope();
     return S_OK;
 }
 
@@ -432,30 +435,33 @@ HRESULT ScopeInfo::GetOrAddChildItem(_In_ const HierarchicalNameSegment* pName,
         return HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
     }
 
-    AutoDeletePtr<ItemInfo> pRtrn;
-    RETURN_IF_FAILED(ItemInfo::CreateInstance(pName, this, &pRtrn));
-
+    // Look for an existing child first so we only allocate nodes that get inserted.
     HNamesNode* foundNode;
-    RETURN_IF_FAILED(GetOrAddChildNode(pRtrn, &foundNode));
-
-    if (foundNode != nullptr)
+    if (!TryGetChild(pName, &foundNode))
     {
-        // already exists
-        if (foundNode->IsScope())
+        AutoDeletePtr<ItemInfo> pRtrn;
+        RETURN_IF_FAILED(ItemInfo::CreateInstance(pName, this, &pRtrn));
+        RETURN_IF_FAILED(GetOrAddChildNode(pRtrn, &foundNode));
+
+        if (foundNode == nullptr)
         {
-            // Oops. It exists but it's a scope!
-            return HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY);
-        }
+            RETURN_IF_FAILED(pRtrn->AddToGlobal(this));
 
-        *result = foundNode->ToItem();
-        return S_OK;
+            m_numChildItems++;
+            NoteSubscopeChanges(0, 1);
+            *result = pRtrn.Detach();
+            return S_OK;
+        }
     }
 
-    RETURN_IF_FAILED(pRtrn->AddToGlobal(this));
+    // already exists
+    if (foundNode->IsScope())
+    {
+        // Oops. It exists but it's a scope!
+        return HRESULT_FROM_WIN32(ERROR_MRM_DUPLICATE_ENTRY);
+    }
 
-    m_numChildItems++;
-    NoteSubscopeChanges(0, 1);
-    *result = pRtrn.Detach();
+    *result = foundNode->ToItem();
     return S_OK;
 }
 
@@ -1077,6 +1083,59 @@ HRESULT HierarchicalNamesBuilder::GetOrAddItem(__in PCWSTR pPath, _Out_ ItemInfo
     return m_pRootScope->GetOrAddItem(pPath, result);
 }
 
+HRESULT HierarchicalNamesBuilder::GetOrAddItems(
+    _In_reads_(numPaths) const PCWSTR* pPaths,
+    _In_ int numPaths,
+    _Out_writes_(numPaths) ItemInfo** results)
+{
+    RETURN_HR_IF(E_INVALIDARG, (numPaths < 0) || ((numPaths > 0) && ((pPaths == nullptr) || (results == nullptr))));
+
+    ScopeInfo* pLastParent = nullptr;
+    PCWSTR pLastPath = nullptr;
+    size_t cchLastParent = 0;
+
+    for (int i = 0; i < numPaths; i++)
+    {
+        results[i] = nullptr;
+
+        PCWSTR pPath = pPaths[i];
+        RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pPath));
+
+        if (IsPathSeparator(pPath[0]))
+        {
+            pPath++;
+        }
+
+        // cchParent includes the trailing separator, so it is 0 only for children of the root.
+        size_t cchParent = 0;
+        for (size_t ich = 0; pPath[ich] != L'\0'; ich++)
+        {
+            if (IsPathSeparator(pPath[ich]))
+            {
+                cchParent = ich + 1;
+            }
+        }
+        PCWSTR pLeaf = pPath + cchParent;
+
+        if ((pLastParent != nullptr) && (pLeaf[0] != L'\0') && (cchParent == cchLastParent) &&
+            (DefString_CchCompareWithOptions(pPath, pLastPath, cchParent, DefCompare_CaseInsensitive) == Def_Equal))
+        {
+            // Same parent path as the previous name, so the leaf is all that's left to resolve.
+            RETURN_IF_FAILED(pLastParent->GetOrAddItem(pLeaf, &results[i]));
+        }
+        else
+        {
+            RETURN_IF_FAILED(m_pRootScope->GetOrAddItem(pPath, &results[i]));
+
+            pLastParent = results[i]->GetParentScope();
+            pLastPath = pPath;
+            cchLastParent = cchParent;
+        }
+    }
+
+    return S_OK;
+}
+
 bool HierarchicalNamesBuilder::TryGetScopeByIndex(_In_ int index, _Outptr_result_maybenull_ ScopeInfo** ppScopeOut) const
 {
     if (ppScopeOut == nullptr)
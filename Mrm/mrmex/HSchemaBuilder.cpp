@@ -50,7 +50,7 @@ _Use_decl_annotations_ HRESULT HierarchicalSchemaVersionInfoBuilder::Build(void*
     pVersion->csType = MRMFILE_HSCHEMA_CSTYPE_DEFAULT;
     pVersion->checksum = 0;
 
-    RETURN_IF_FAILED(ComputeHierarchicalSchemaVersionChecksum(m_pSchema, this, &pVersion->checksum));
+    RETURN_IF_FAILED(ComputeVersionChecksum(&pVersion->checksum));
 
     if (pcbWrittenOut != nullptr)
     {
@@ -63,13 +63,37 @@ DEF_CHECKSUM
 HierarchicalSchemaVersionInfoBuilder::GetVersionChecksum() const
 {
     DEF_CHECKSUM cs = 0;
-    if (SUCCEEDED(ComputeHierarchicalSchemaVersionChecksum(m_pSchema, this, &cs)))
+    if (SUCCEEDED(ComputeVersionChecksum(&cs)))
     {
         return cs;
     }
     return 0;
 }
 
+_Use_decl_annotations_ HRESULT HierarchicalSchemaVersionInfoBuilder::ComputeVersionChecksum(DEF_CHECKSUM* pChecksumOut) const
+{
+    *pChecksumOut = 0;
+
+    int numScopes = m_pSchema->GetNumScopes();
+    int numItems = m_pSchema->GetNumItems();
+    if (m_bChecksumValid && (numScopes == m_checksumNumScopes) && (numItems == m_checksumNumItems) &&
+        (m_pSchema->GetScopeNames() == m_scopeNamesChecksum.pool) && (m_pSchema->GetItemNames() == m_itemNamesChecksum.pool))
+    {
+        *pChecksumOut = m_checksum;
+        return S_OK;
+    }
+
+    m_bChecksumValid = false;
+    RETURN_IF_FAILED(ComputeHierarchicalSchemaVersionChecksum(m_pSchema, this, &m_scopeNamesChecksum, &m_itemNamesChecksum, &m_checksum));
+
+    m_checksumNumScopes = numScopes;
+    m_checksumNumItems = numItems;
+    m_bChecksumValid = true;
+
+    *pChecksumOut = m_checksum;
+    return S_OK;
+}
+
 HierarchicalSchemaSectionBuilder::HierarchicalSchemaSectionBuilder() :
     m_finalized(false),
     m_numFinalizedScopes(-1),
@@ -115,6 +139,7 @@ HRESULT HierarchicalSchemaSectionBuilder::Init(
                                                                                        HierarchicalNamesBuilder::BuildAsciiOrUtf16);
 
     RETURN_IF_FAILED(HierarchicalNamesBuilder::CreateInstance(namesBuildFlags, pPriBuilder->GetAtoms(), &m_pNames));
+    m_pNames->SetArena(pPriBuilder->GetArena());
 
     return S_OK;
 }
@@ -144,6 +169,7 @@ HierarchicalSchemaSectionBuilder::Init(
                                                                                        HierarchicalNamesBuilder::BuildAsciiOrUtf16);
 
     RETURN_IF_FAILED(HierarchicalNamesBuilder::CreateInstance(namesBuildFlags, pPriBuilder->GetAtoms(), &m_pNames));
+    m_pNames->SetArena(pPriBuilder->GetArena());
 
     if ((m_priBuildType & PriBuildType::PriBuildForDeploymentMerge) == 0)
     {
@@ -319,6 +345,46 @@ HRESULT HierarchicalSchemaSectionBuilder::GetOrAddItem(PCWSTR pItemName, int* in
     return S_OK;
 }
 
+HRESULT HierarchicalSchemaSectionBuilder::GetOrAddItems(
+    _In_reads_(numItems) const PCWSTR* pItemNames,
+    _In_ int numItems,
+    _Out_writes_(numItems) int* indexes)
+{
+    RETURN_HR_IF(E_INVALIDARG, (numItems < 0) || ((numItems > 0) && ((pItemNames == nullptr) || (indexes == nullptr))));
+
+    if (numItems == 0)
+    {
+        return S_OK;
+    }
+
+    if (m_pPreviousSchema != nullptr)
+    {
+        RETURN_IF_FAILED(ReadPreviousSchemaContents());
+    }
+
+    if ((m_priBuildType == PriBuildType::PriBuildFromPrevReadOnlySchema))
+    {
+        for (int i = 0; i < numItems; i++)
+        {
+            if (!m_pNames->Contains(pItemNames[i]))
+            {
+                return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_FILE_TYPE);
+            }
+        }
+    }
+
+    unique_deffree_ptr<ItemInfo*> items(_DefArray_AllocZeroed(ItemInfo*, numItems));
+    RETURN_IF_NULL_ALLOC(items);
+
+    RETURN_IF_FAILED(m_pNames->GetOrAddItems(pItemNames, numItems, items.get()));
+
+    for (int i = 0; i < numItems; i++)
+    {
+        indexes[i] = items.get()[i]->GetIndex();
+    }
+    return S_OK;
+}
+
 _Success_(return == true)
 bool HierarchicalSchemaSectionBuilder::TryGetScopeInfo(_In_ int scopeIndex, _Out_ StringResult* pNameOut, _Out_opt_ int* pNumChildrenOut) const
 {
@@ -657,9 +723,6 @@ HRESULT HierarchicalSchemaSectionBuilder::Finalize()
         return S_OK;
     }
 
-    delete m_pVersionInfo;
-    m_pVersionInfo = nullptr;
-
     m_numFinalizedScopes = m_pNames->GetNumScopes();
     m_numFinalizedItems = m_pNames->GetNumItems();
 
@@ -675,6 +738,12 @@ HRESULT HierarchicalSchemaSectionBuilder::Finalize()
         }
     }
 
+    if (m_pVersionInfo != nullptr)
+    {
+        // Keep the existing version info so its checksum only has to take in the names added since.
+        m_pVersionInfo->SetMinorVersion(m_minorVersion);
+    }
+
     m_finalized = true;
     return S_OK;
 }
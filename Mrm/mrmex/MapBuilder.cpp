@@ -29,20 +29,20 @@ int BuilderCandidateResult::GetSectionIndex() const { return m_builderCandidate.
 
 int BuilderCandidateResult::GetItemIndex() const { return (m_builderCandidate.value.data3 << 16) | m_builderCandidate.value.data1; }
 
-class BuilderItemInfo : protected DefObject
+class BuilderItemInfo : protected DefArenaObject<>
 {
 public:
-    static HRESULT CreateInstance(_Outptr_ BuilderItemInfo** result)
+    static HRESULT CreateInstance(_In_opt_ DefArena* pArena, _Outptr_ BuilderItemInfo** result)
     {
         *result = nullptr;
-        BuilderItemInfo* pRtrn = new BuilderItemInfo();
+        BuilderItemInfo* pRtrn = new (pArena) BuilderItemInfo();
         RETURN_IF_NULL_ALLOC(pRtrn);
 
         *result = pRtrn;
         return S_OK;
     }
 
-    using DefObject::operator delete;
+    using DefArenaObject<>::operator delete;
 
     ~BuilderItemInfo()
     {
@@ -95,6 +95,15 @@ public:
         return S_OK;
     }
 
+    HRESULT ReserveCandidates(_In_ int numAdditionalCandidates)
+    {
+        if (m_pCandidates == NULL)
+        {
+            return DynamicArray<BUILDER_CANDIDATE>::CreateInstance(max(numAdditionalCandidates, 2), &m_pCandidates);
+        }
+        return m_pCandidates->Reserve(m_pCandidates->Count() + numAdditionalCandidates);
+    }
+
     _Success_(return == true)
     bool TryFindCandidateForQualifierSet(_In_ int qualifierSetIndex, _Out_ const BUILDER_CANDIDATE** ppCandidateOut) const
     {
@@ -187,13 +196,13 @@ private:
     bool m_hasLargeCandidates = false;
 };
 
-class ResourceMapSectionBuilder::MapBuilderItemData : protected DefObject
+class ResourceMapSectionBuilder::MapBuilderItemData : protected DefArenaObject<>
 {
 public:
     static HRESULT CreateInstance(_In_ ResourceMapSectionBuilder* pMap, _Outptr_ MapBuilderItemData** result)
     {
         *result = nullptr;
-        MapBuilderItemData* pRtrn = new MapBuilderItemData(pMap);
+        MapBuilderItemData* pRtrn = new (pMap->m_pPriBuilder->GetArena()) MapBuilderItemData(pMap);
         RETURN_IF_NULL_ALLOC(pRtrn);
 
         *result = pRtrn;
@@ -206,14 +215,14 @@ public:
         _Outptr_ MapBuilderItemData** result)
     {
         *result = nullptr;
-        MapBuilderItemData* pRtrn = new MapBuilderItemData(pMap, priBuildType);
+        MapBuilderItemData* pRtrn = new (pMap->m_pPriBuilder->GetArena()) MapBuilderItemData(pMap, priBuildType);
         RETURN_IF_NULL_ALLOC(pRtrn);
 
         *result = pRtrn;
         return S_OK;
     }
 
-    using DefObject::operator delete;
+    using DefArenaObject<>::operator delete;
 
     virtual ~MapBuilderItemData()
     {
@@ -300,6 +309,16 @@ public:
         return pItem->AddCandidate(candidate, false, instanceValue.data3 != 0);
     }
 
+    HRESULT ReserveCandidates(_In_ int indexInSchema, _In_ int numAdditionalCandidates)
+    {
+        BuilderItemInfo* pItem;
+        RETURN_IF_FAILED(GetOrAddResource(indexInSchema, &pItem));
+
+        _Analysis_assume_(pItem != nullptr);
+
+        return pItem->ReserveCandidates(numAdditionalCandidates);
+    }
+
     HRESULT AddResourceLink(_In_ int indexInSchema)
     {
         BuilderItemInfo* item;
@@ -517,7 +536,7 @@ private:
 
         if (m_ppItems[indexInSchema] == NULL)
         {
-            RETURN_IF_FAILED(BuilderItemInfo::CreateInstance(&m_ppItems[indexInSchema]));
+            RETURN_IF_FAILED(BuilderItemInfo::CreateInstance(m_pMap->m_pPriBuilder->GetArena(), &m_ppItems[indexInSchema]));
         }
 
         *ppItemOut = m_ppItems[indexInSchema];
@@ -949,6 +968,128 @@ HRESULT ResourceMapSectionBuilder::AddCandidate(
     return m_pItems->AddReferenceValue(itemIndex, qualifierSetIndex, pBuildInstanceReference, typeIndex);
 }
 
+struct CandidateInputSortContext
+{
+    const BUILDER_CANDIDATE_INPUT* pCandidates;
+};
+
+static int __cdecl CandidateInputSorter(_In_ void* pContext, _In_ const void* pLeft, _In_ const void* pRight)
+{
+    const BUILDER_CANDIDATE_INPUT* pCandidates = static_cast<CandidateInputSortContext*>(pContext)->pCandidates;
+    int left = *static_cast<const int*>(pLeft);
+    int right = *static_cast<const int*>(pRight);
+
+    // Item names are case-insensitive, so compare the way HNames does; this also keeps names with a
+    // common parent scope next to each other regardless of how their case was spelled.
+    int cmp = DefString_ICompare(pCandidates[left].pItemName, pCandidates[right].pItemName);
+    if (cmp != 0)
+    {
+        return cmp;
+    }
+
+    // Candidates for the same name keep the order in which they were supplied.
+    return (left < right) ? -1 : ((left > right) ? 1 : 0);
+}
+
+HRESULT ResourceMapSectionBuilder::AddCandidates(_Inout_updates_(numCandidates) BUILDER_CANDIDATE_INPUT* pCandidates, _In_ int numCandidates)
+{
+    RETURN_HR_IF(E_INVALIDARG, (numCandidates < 0) || ((numCandidates > 0) && (pCandidates == nullptr)));
+
+    if (numCandidates == 0)
+    {
+        return S_OK;
+    }
+
+    for (int i = 0; i < numCandidates; i++)
+    {
+        RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pCandidates[i].pItemName));
+    }
+
+    // Sort an index over the input once so that each name is resolved once and siblings are adjacent.
+    unique_deffree_ptr<int> order(_DefArray_AllocZeroed(int, numCandidates));
+    RETURN_IF_NULL_ALLOC(order);
+
+    for (int i = 0; i < numCandidates; i++)
+    {
+        order.get()[i] = i;
+    }
+
+    CandidateInputSortContext context{pCandidates};
+    qsort_s(order.get(), numCandidates, sizeof(int), CandidateInputSorter, &context);
+
+    // Collect each distinct name once, in sorted order, and resolve them in a single pass over the tree.
+    unique_deffree_ptr<PCWSTR> names(_DefArray_AllocZeroed(PCWSTR, numCandidates));
+    RETURN_IF_NULL_ALLOC(names);
+    unique_deffree_ptr<int> nameIndexes(_DefArray_AllocZeroed(int, numCandidates));
+    RETURN_IF_NULL_ALLOC(nameIndexes);
+
+    int numNames = 0;
+    for (int i = 0; i < numCandidates; i++)
+    {
+        PCWSTR pName = pCandidates[order.get()[i]].pItemName;
+        if ((numNames == 0) || (DefString_ICompare(names.get()[numNames - 1], pName) != Def_Equal))
+        {
+            names.get()[numNames++] = pName;
+        }
+    }
+
+    unique_deffree_ptr<int> itemIndexes(_DefArray_AllocZeroed(int, numNames));
+    RETURN_IF_NULL_ALLOC(itemIndexes);
+    RETURN_IF_FAILED(m_pSchema->GetOrAddItems(names.get(), numNames, itemIndexes.get()));
+
+    // Reserve candidate storage for each item once, then add the candidates themselves.
+    for (int i = 0, iName = -1, runStart = 0; i <= numCandidates; i++)
+    {
+        bool newName = (i == numCandidates) || (iName < 0) || (DefString_ICompare(names.get()[iName], pCandidates[order.get()[i]].pItemName) != Def_Equal);
+        if (newName)
+        {
+            if (iName >= 0)
+            {
+                RETURN_IF_FAILED(m_pItems->ReserveCandidates(itemIndexes.get()[iName], i - runStart));
+            }
+            iName++;
+            runStart = i;
+        }
+
+        if (i < numCandidates)
+        {
+            nameIndexes.get()[i] = iName;
+        }
+    }
+
+    MrmEnvironment::ResourceValueType lastValueType = MrmEnvironment::ResourceValueType_Utf16String;
+    int lastTypeIndex = -1;
+
+    m_finalized = false;
+
+    for (int i = 0; i < numCandidates; i++)
+    {
+        BUILDER_CANDIDATE_INPUT* pCandidate = &pCandidates[order.get()[i]];
+        int itemIndex = itemIndexes.get()[nameIndexes.get()[i]];
+
+        if ((lastTypeIndex < 0) || (pCandidate->valueType != lastValueType))
+        {
+            RETURN_IF_FAILED(GetOrAddResourceValueTypeIndex(pCandidate->valueType, &lastTypeIndex));
+            lastValueType = pCandidate->valueType;
+        }
+
+        if (pCandidate->pBuildInstanceReference != nullptr)
+        {
+            RETURN_IF_FAILED(m_pItems->AddReferenceValue(itemIndex, pCandidate->qualifierSetIndex, pCandidate->pBuildInstanceReference, lastTypeIndex));
+
+            // AddReferenceValue took ownership.
+            pCandidate->pBuildInstanceReference = nullptr;
+        }
+        else
+        {
+            PCWSTR pValue = (pCandidate->pValue ? pCandidate->pValue : L"");
+            RETURN_IF_FAILED(m_pItems->AddInternalStringValue(itemIndex, pCandidate->qualifierSetIndex, pValue, lastTypeIndex));
+        }
+    }
+
+    return S_OK;
+}
+
 HRESULT ResourceMapSectionBuilder::InitLinks()
 {
     if (m_links == nullptr)
@@ -1243,7 +1384,28 @@ HRESULT ResourceMapSectionBuilder::Finalize()
         return S_OK;
     }
 
-    RETURN_IF_FAILED(m_pItems->FinalizeDecisionIndexes());
+    RETURN_IF_FAILED(FinalizeDecisions());
+    return FinalizeLayout();
+}
+
+HRESULT ResourceMapSectionBuilder::FinalizeDecisions()
+{
+    if (m_finalized)
+    {
+        return S_OK;
+    }
+
+    // Registers decisions and qualifier sets with the shared decision info,
+    // so callers must run this for every map in a fixed order.
+    return m_pItems->FinalizeDecisionIndexes();
+}
+
+HRESULT ResourceMapSectionBuilder::FinalizeLayout()
+{
+    if (m_finalized)
+    {
+        return S_OK;
+    }
 
     if (m_links != nullptr)
     {
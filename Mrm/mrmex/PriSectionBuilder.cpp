@@ -112,6 +112,10 @@ PriSectionBuilder::~PriSectionBuilder()
 
     delete m_pAtoms;
     m_pAtoms = nullptr;
+
+    // Everything allocated from the arena has been deleted by now.
+    delete m_pArena;
+    m_pArena = nullptr;
 }
 
 HRESULT PriSectionBuilder::Init(_In_ CoreProfile* pProfile)
@@ -126,6 +130,7 @@ HRESULT PriSectionBuilder::Init(_In_ CoreProfile* pProfile)
         return E_OUTOFMEMORY;
     }
 
+    RETURN_IF_FAILED(DefArena::CreateInstance(&m_pArena));
     RETURN_IF_FAILED(AtomPoolGroup::CreateInstance(10, &m_pAtoms));
 
     RETURN_IF_FAILED(UnifiedEnvironment::CreateInstance(pProfile, m_pAtoms, &m_pUnifiedEnvironment));
@@ -150,7 +155,7 @@ HRESULT PriSectionBuilder::Init(_In_ CoreProfile* pProfile)
         RETURN_IF_FAILED(m_pFileBuilder->AddSection(m_environmentMapping));
     }
 
-    RETURN_IF_FAILED(DataItemOrchestrator::CreateInstance(m_pFileBuilder, pProfile, m_pDecisionInfo, &m_dataItems));
+    RETURN_IF_FAILED(DataItemOrchestrator::CreateInstance(m_pFileBuilder, pProfile, m_pDecisionInfo, &m_dataItems, m_pArena));
 
     return S_OK;
 }
@@ -1085,6 +1090,131 @@ HRESULT PriSectionBuilder::AddFileListSectionBuilder(_In_ FileListBuilder* pFile
     return S_OK;
 }
 
+typedef HRESULT (*PFN_FINALIZE_TASK)(_In_ void* pItem);
+
+struct ParallelFinalizeContext
+{
+    PFN_FINALIZE_TASK pfnTask;
+    void** ppItems;
+    LONG numItems;
+    volatile LONG nextItem;
+    volatile LONG hr;
+};
+
+static void RunFinalizeTasks(_Inout_ ParallelFinalizeContext* pContext)
+{
+    for (;;)
+    {
+        LONG index = InterlockedIncrement(&pContext->nextItem) - 1;
+        if ((index >= pContext->numItems) || FAILED(pContext->hr))
+        {
+            return;
+        }
+
+        HRESULT hr = pContext->pfnTask(pContext->ppItems[index]);
+        if (FAILED(hr))
+        {
+            // Keep the first failure
+            InterlockedCompareExchange(&pContext->hr, hr, S_OK);
+        }
+    }
+}
+
+static VOID CALLBACK ParallelFinalizeWorkCallback(_Inout_ PTP_CALLBACK_INSTANCE, _Inout_opt_ PVOID pContext, _Inout_ PTP_WORK)
+{
+    RunFinalizeTasks(static_cast<ParallelFinalizeContext*>(pContext));
+}
+
+// Runs pfnTask on every item, spreading the work across the default thread pool.
+// The calling thread takes part too, so one item (or one processor) runs inline.
+static HRESULT RunFinalizeTasksInParallel(_In_ PFN_FINALIZE_TASK pfnTask, _In_reads_(numItems) void** ppItems, _In_ int numItems)
+{
+    ParallelFinalizeContext context = { pfnTask, ppItems, numItems, 0, S_OK };
+
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+
+    int numWorkers = min(numItems, static_cast<int>(systemInfo.dwNumberOfProcessors)) - 1;
+    if (numWorkers > 0)
+    {
+        PTP_WORK work = CreateThreadpoolWork(ParallelFinalizeWorkCallback, &context, nullptr);
+        RETURN_LAST_ERROR_IF_NULL(work);
+
+        for (int i = 0; i < numWorkers; i++)
+        {
+            SubmitThreadpoolWork(work);
+        }
+
+        RunFinalizeTasks(&context);
+
+        WaitForThreadpoolWorkCallbacks(work, FALSE);
+        CloseThreadpoolWork(work);
+    }
+    else
+    {
+        RunFinalizeTasks(&context);
+    }
+
+    return context.hr;
+}
+
+static HRESULT FinalizeMapLayoutTask(_In_ void* pItem) { return static_cast<ResourceMapSectionBuilder*>(pItem)->FinalizeLayout(); }
+
+static HRESULT FinalizeSchemaTask(_In_ void* pItem) { return static_cast<HierarchicalSchemaSectionBuilder*>(pItem)->Finalize(); }
+
+HRESULT PriSectionBuilder::FinalizeMapsAndSchemasInParallel()
+{
+    int numItems = max(m_pMaps->Count(), m_pSchemas->Count());
+    if (numItems < 1)
+    {
+        return S_OK;
+    }
+
+    unique_deffree_ptr<void*> items(_DefArray_AllocZeroed(void*, numItems));
+    RETURN_IF_NULL_ALLOC(items.get());
+
+    // Decision and qualifier set indexes are assigned as each map registers its
+    // decisions, so that step stays serial and in map order to keep output stable.
+    for (int i = 0; i < m_pMaps->Count(); i++)
+    {
+        ResourceMapSectionBuilder* pMap;
+        RETURN_IF_FAILED(m_pMaps->Get(i, &pMap));
+        RETURN_IF_FAILED(pMap->FinalizeDecisions());
+    }
+
+    // Maps with resource links finalize their link section, which can read
+    // other maps and schemas, so only the self-contained ones run in parallel.
+    int numConcurrentMaps = 0;
+    for (int i = 0; i < m_pMaps->Count(); i++)
+    {
+        ResourceMapSectionBuilder* pMap;
+        RETURN_IF_FAILED(m_pMaps->Get(i, &pMap));
+        if (pMap->CanFinalizeLayoutConcurrently())
+        {
+            items.get()[numConcurrentMaps++] = pMap;
+        }
+    }
+
+    RETURN_IF_FAILED(RunFinalizeTasksInParallel(FinalizeMapLayoutTask, items.get(), numConcurrentMaps));
+
+    for (int i = 0; i < m_pMaps->Count(); i++)
+    {
+        ResourceMapSectionBuilder* pMap;
+        RETURN_IF_FAILED(m_pMaps->Get(i, &pMap));
+        RETURN_IF_FAILED(pMap->FinalizeLayout());
+    }
+
+    // Schemas only depend on their own names.
+    for (int i = 0; i < m_pSchemas->Count(); i++)
+    {
+        HierarchicalSchemaSectionBuilder* pSchema;
+        RETURN_IF_FAILED(m_pSchemas->Get(i, &pSchema));
+        items.get()[i] = pSchema;
+    }
+
+    return RunFinalizeTasksInParallel(FinalizeSchemaTask, items.get(), m_pSchemas->Count());
+}
+
 /*
   *   ISectionBuilder Implementation
   */
@@ -1109,18 +1239,25 @@ HRESULT PriSectionBuilder::Finalize()
     // decision info, to make sure they finalize in the proper
     // order.  The file builder will finalize again but that's
     // a no-op.
-    for (int i = 0; i < m_pMaps->Count(); i++)
+    if (m_pBuilderConfiguration->UseParallelFinalize())
     {
-        ResourceMapSectionBuilder* pMap;
-        RETURN_IF_FAILED(m_pMaps->Get(i, &pMap));
-        RETURN_IF_FAILED(pMap->Finalize());
+        RETURN_IF_FAILED(FinalizeMapsAndSchemasInParallel());
     }
-
-    for (int i = 0; i < m_pSchemas->Count(); i++)
+    else
     {
-        HierarchicalSchemaSectionBuilder* pSchema;
-        RETURN_IF_FAILED(m_pSchemas->Get(i, &pSchema));
-        RETURN_IF_FAILED(pSchema->Finalize());
+        for (int i = 0; i < m_pMaps->Count(); i++)
+        {
+            ResourceMapSectionBuilder* pMap;
+            RETURN_IF_FAILED(m_pMaps->Get(i, &pMap));
+            RETURN_IF_FAILED(pMap->Finalize());
+        }
+
+        for (int i = 0; i < m_pSchemas->Count(); i++)
+        {
+            HierarchicalSchemaSectionBuilder* pSchema;
+            RETURN_IF_FAILED(m_pSchemas->Get(i, &pSchema));
+            RETURN_IF_FAILED(pSchema->Finalize());
+        }
     }
 
     RETURN_IF_FAILED(m_pDecisionInfo->Finalize());
@@ -19,9 +19,100 @@ const Atom Atom::NullAtom(0, 0);
     (((A1).s.poolIndex == (A2).s.poolIndex) ? (((A1).s.index == (A2).s.index) ? DEF_ATOMS_EQUAL : DEF_ATOMS_UNEQUAL) : \
                                               DEF_ATOMS_INDETERMINATE)
 
+#define DEFATOM_STRONG_HASH_SEED 0x9E3779B97F4A7C15ull
+#define DEFATOM_STRONG_HASH_PRIME1 0xA0761D6478BD642Full
+#define DEFATOM_STRONG_HASH_PRIME2 0xE7037ED1A0B428DBull
+
+static inline UINT64 DefAtom_Mix64(UINT64 a, UINT64 b)
+{
+    // 64x64->128 multiply folded back to 64 bits (as in wyhash).
+#if defined(_M_X64) && !defined(__clang__)
+    UINT64 hi;
+    UINT64 lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#elif defined(__SIZEOF_INT128__)
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<UINT64>(r) ^ static_cast<UINT64>(r >> 64);
+#else
+    UINT64 aHi = a >> 32, aLo = a & 0xFFFFFFFF;
+    UINT64 bHi = b >> 32, bLo = b & 0xFFFFFFFF;
+    UINT64 ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    UINT64 mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+    UINT64 lo = (ll & 0xFFFFFFFF) | (mid << 32);
+    UINT64 hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+// Lower-cases four packed ASCII characters at once.  Each 16-bit lane is
+// known to be < 0x80, so the additions below can't carry between lanes.
+static inline UINT64 DefAtom_LowerCaseAscii4(UINT64 chars)
+{
+    const UINT64 geA = chars + 0x003F003F003F003Full; // bit 7 set if >= 'A'
+    const UINT64 gtZ = chars + 0x0025002500250025ull; // bit 7 set if > 'Z'
+    return chars | (((geA & ~gtZ) & 0x0080008000800080ull) >> 2);
+}
+
+// Collision-resistant hash used by DEF_HASH_STRONG.  Consumes the string four
+// UTF-16 code units at a time, folding case on the packed block when every
+// unit is ASCII and falling back to towlower per unit otherwise.
+static DEF_ATOM_HASH DefAtom_HashStringStrong(__in PCWSTR pString, bool caseInsensitive)
+{
+    UINT64 state = DEFATOM_STRONG_HASH_SEED;
+    UINT64 cchTotal = 0;
+
+    for (;;)
+    {
+        UINT64 block = 0;
+        int cchBlock = 0;
+        while ((cchBlock < 4) && (pString[cchBlock] != 0))
+        {
+            block |= static_cast<UINT64>(static_cast<UINT16>(pString[cchBlock])) << (16 * cchBlock);
+            cchBlock++;
+        }
+        if (cchBlock == 0)
+        {
+            break;
+        }
+
+        if (caseInsensitive)
+        {
+            if ((block & 0xFF80FF80FF80FF80ull) == 0)
+            {
+                block = DefAtom_LowerCaseAscii4(block);
+            }
+            else
+            {
+                UINT64 folded = 0;
+                for (int i = 0; i < cchBlock; i++)
+                {
+                    folded |= static_cast<UINT64>(static_cast<UINT16>(towlower(pString[i]))) << (16 * i);
+                }
+                block = folded;
+            }
+        }
+
+        state = DefAtom_Mix64(state ^ block, DEFATOM_STRONG_HASH_PRIME1);
+        cchTotal += cchBlock;
+        pString += cchBlock;
+        if (cchBlock < 4)
+        {
+            break;
+        }
+    }
+
+    state = DefAtom_Mix64(state ^ cchTotal, DEFATOM_STRONG_HASH_PRIME2);
+    return static_cast<DEF_ATOM_HASH>(state ^ (state >> 32));
+}
+
 DEF_ATOM_HASH
 DefAtom_HashString(__in PCWSTR pString, DEF_ATOM_HASH_METHOD hashMethod)
 {
+    if (hashMethod & DEF_HASH_STRONG)
+    {
+        return DefAtom_HashStringStrong(pString, ((hashMethod & DEF_HASH_CASE_INSENSITIVE) != 0));
+    }
+
     DEF_ATOM_HASH rtrn = 0x3482;
 
     //! \todo really basic hash function.  Do something better someday.
@@ -60,4 +151,103 @@ Atom::Comparison Atom::Compare(__in Atom atom) const { return DefAtom_Compare(m_
 /// </returns>
 Atom::Hash Atom::HashString(__in PCWSTR pString, __in Atom::HashMethod hashType) { return DefAtom_HashString(pString, hashType); }
 
+HRESULT AtomHashIndex::CreateInstance(_In_ const IAtomPool* pPool, _Outptr_ AtomHashIndex** result)
+{
+    *result = nullptr;
+    RETURN_HR_IF_NULL(E_INVALIDARG, pPool);
+
+    Atom::Index numAtoms = pPool->GetNumAtoms();
+    RETURN_HR_IF(E_INVALIDARG, (numAtoms < 0) || (numAtoms >= Atom::MaxAtomIndex));
+
+    // Keep the load factor at or below one half so probe sequences stay short.
+    UINT32 numSlots = 16;
+    while (numSlots < static_cast<UINT32>(numAtoms) * 2)
+    {
+        numSlots *= 2;
+    }
+
+    AutoDeletePtr<AtomHashIndex> pRtrn = new AtomHashIndex();
+    RETURN_IF_NULL_ALLOC(pRtrn);
+
+    pRtrn->m_pEntries = _DefArray_AllocZeroed(Entry, numSlots);
+    RETURN_IF_NULL_ALLOC(pRtrn->m_pEntries);
+    pRtrn->m_mask = numSlots - 1;
+    if (pPool->GetIsCaseInsensitive())
+    {
+        pRtrn->m_hashMethod = static_cast<Atom::HashMethod>(Atom::HashMethodStrong | Atom::HashMethodCaseInsensitive);
+    }
+
+    StringResult str;
+    for (Atom::Index i = 0; i < numAtoms; i++)
+    {
+        // Null or unreadable entries can never be matched by a lookup
+        if (!pPool->TryGetString(i, &str) || DefString_IsEmpty(str.GetRef()))
+        {
+            continue;
+        }
+
+        Atom::Hash hash = pRtrn->HashString(str.GetRef());
+        UINT32 slot = pRtrn->GetFirstSlot(hash);
+        while (pRtrn->m_pEntries[slot].indexPlusOne != 0)
+        {
+            slot = (slot + 1) & pRtrn->m_mask;
+        }
+        pRtrn->m_pEntries[slot].hash = hash;
+        pRtrn->m_pEntries[slot].indexPlusOne = static_cast<UINT32>(i) + 1;
+    }
+
+    *result = pRtrn.Detach();
+    return S_OK;
+}
+
+AtomHashIndex::~AtomHashIndex()
+{
+    if (m_pEntries != nullptr)
+    {
+        _DefFree(m_pEntries);
+        m_pEntries = nullptr;
+    }
+}
+
+_Success_(return == true)
+bool AtomHashIndex::TryGetNextCandidate(_In_ Atom::Hash hash, _Inout_ UINT32* pSlot, _Out_ Atom::Index* pIndexOut) const
+{
+    *pIndexOut = Atom::NullAtomIndex;
+
+    for (UINT32 slot = (*pSlot & m_mask); m_pEntries[slot].indexPlusOne != 0; slot = (slot + 1) & m_mask)
+    {
+        if (m_pEntries[slot].hash == hash)
+        {
+            *pIndexOut = static_cast<Atom::Index>(m_pEntries[slot].indexPlusOne - 1);
+            *pSlot = (slot + 1) & m_mask;
+            return true;
+        }
+    }
+    return false;
+}
+
+const AtomHashIndex* AtomHashIndex::GetOrCreate(_In_ const IAtomPool* pPool, _Inout_ AtomHashIndex* volatile* ppIndex)
+{
+    AtomHashIndex* pIndex = *ppIndex;
+    if ((pIndex != nullptr) || (pPool->GetNumAtoms() <= MinAtomsToIndex))
+    {
+        return pIndex;
+    }
+
+    if (FAILED(CreateInstance(pPool, &pIndex)))
+    {
+        return nullptr;
+    }
+
+    // Another thread may have published its own copy first; keep that one.
+    AtomHashIndex* pExisting = static_cast<AtomHashIndex*>(
+        InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(ppIndex), pIndex, nullptr));
+    if (pExisting != nullptr)
+    {
+        delete pIndex;
+        return pExisting;
+    }
+    return pIndex;
+}
+
 } // namespace Microsoft::Resources
@@ -161,6 +161,30 @@ QualifierTypeBase::ValidateQualifier(_In_ const IQualifier* pQualifier) const
     return S_OK;
 }
 
+HRESULT
+QualifierTypeBase::ValidateParsedQualifier(_In_ const IQualifier* pQualifier, _Out_ ParsedQualifierOperand* pOperandOut) const
+{
+    if (pQualifier->TryGetParsedOperand2(pOperandOut))
+    {
+        ICondition::ConditionOperator op;
+        RETURN_IF_FAILED(pQualifier->GetOperator(&op));
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_QUALIFIER_OPERATOR), op != ICondition::MatchOp);
+
+        HRESULT hr = ValidateParsedQualifierValue(pOperandOut);
+        RETURN_IF_FAILED(hr);
+
+        if (hr == S_OK)
+        {
+            return S_OK;
+        }
+    }
+
+    *pOperandOut = {};
+    RETURN_IF_FAILED(ValidateQualifier(pQualifier));
+
+    return S_FALSE;
+}
+
 HRESULT
 QualifierTypeBase::ValidateQualifierComparison(
     _In_ Atom /*qualifierName*/,
@@ -526,20 +550,45 @@ IntegerQualifierType::ValidateSingleQualifierValue(_In_ PCWSTR pValue) const
     return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_QUALIFIER_VALUE);
 }
 
+HRESULT
+IntegerQualifierType::ValidateParsedQualifierValue(_In_ const ParsedQualifierOperand* pOperand) const
+{
+    if ((pOperand->flags & ParsedQualifierOperand::DecimalValue) != 0)
+    {
+        if ((pOperand->integerValue >= m_minAllowedValue) && (pOperand->integerValue <= m_maxAllowedValue))
+        {
+            return S_OK;
+        }
+    }
+    else if (((pOperand->flags & ParsedQualifierOperand::EmptyValue) != 0) && m_allowEmptyProviderValue)
+    {
+        return S_OK;
+    }
+
+    return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_QUALIFIER_VALUE);
+}
+
 HRESULT
 IntegerQualifierType::Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pszProviderValue, _Out_ double* score) const
 {
     *score = 0.0;
 
-    RETURN_IF_FAILED(ValidateQualifier(pQualifier));
+    ParsedQualifierOperand qualifierOperand;
+    HRESULT hr = ValidateParsedQualifier(pQualifier, &qualifierOperand);
+    RETURN_IF_FAILED(hr);
     RETURN_HR_IF_EXPECTED(S_OK, DefString_IsEmpty(pszProviderValue)); // Empty provider value is valid but doesn't match anything
     RETURN_IF_FAILED(ValidateQualifierValue(pszProviderValue)); // downlevel provider can return illegal values
 
-    StringResult qualifierValue;
-    RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierValue));
-
     int providerValue = _wtoi(pszProviderValue);
-    int qualiferValue = _wtoi(qualifierValue.GetRef());
+    int qualiferValue = qualifierOperand.integerValue;
+
+    if (hr == S_FALSE)
+    {
+        // not parsed at load
+        StringResult qualifierValue;
+        RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierValue));
+        qualiferValue = _wtoi(qualifierValue.GetRef());
+    }
 
     // same value => 1.0
     // cond > prov => 0.75
@@ -53,27 +53,12 @@ DefChecksum::ComputeStringChecksum(
         *checksum = ComputeChecksum(partialChecksum, NULL, 0);
         return S_OK;
     }
-    StringResult str;
-    RETURN_IF_FAILED(str.Init(pString));
-    if (caseInsensitive)
-    {
-        size_t size = 0;
-        PWSTR pStr;
-        RETURN_IF_FAILED(str.GetWritableRef(&pStr, &size));
-        if (pStr == NULL)
-        {
-            return S_OK;
-        }
-        while ((*pStr) != L'\0')
-        {
-            (*pStr) = towlower(*pStr);
-            pStr++;
-        }
-    }
-    size_t length;
-    RETURN_IF_FAILED(str.GetLength(&length));
-    length = (length + 1) * sizeof(WCHAR); // include terminating NULL
-    *checksum = ComputeChecksum(partialChecksum, reinterpret_cast<const BYTE*>(str.GetRef()), static_cast<UINT32>(length));
+    // Same as ComputeChecksum over the (lower-cased) string and its terminating NULL, but
+    // folded and checksummed in place rather than on a copy.
+    size_t length = wcslen(pString) + 1;
+    UINT32 cbData = static_cast<UINT32>(length * sizeof(WCHAR));
+    UINT32 crc = _DefComputeCrc32(partialChecksum, reinterpret_cast<const BYTE*>(&cbData), sizeof(UINT32));
+    *checksum = _DefComputeStringCrc32(crc, caseInsensitive, pString, static_cast<UINT32>(length));
 
     return S_OK;
 }
@@ -135,6 +120,61 @@ DefChecksum::ComputeAtomPoolChecksum(
     return S_OK;
 }
 
+HRESULT
+DefChecksum::ComputeAtomPoolChecksum(
+    __in Checksum partialChecksum,
+    __in_opt const IAtomPool* pPool,
+    __in UINT32 numAtoms,
+    _Inout_ AtomPoolStringsChecksum* pState,
+    _Out_ DefChecksum::Checksum* checksum)
+{
+    *checksum = partialChecksum;
+    if (pPool == NULL)
+    {
+        if (numAtoms > 0)
+        {
+            return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
+        }
+        *checksum = ComputeChecksum(partialChecksum, NULL, 0);
+        return S_OK;
+    }
+    RETURN_HR_IF(E_DEF_SIZE_MISMATCH, static_cast<UINT32>(pPool->GetNumAtoms()) < numAtoms);
+
+    UINT32 crc;
+    RETURN_IF_FAILED(ComputeStringChecksum(partialChecksum, true, pPool->GetDescription(), &crc));
+    crc = ComputeUInt32Checksum(crc, (pPool->GetIsCaseInsensitive() ? 1 : 0));
+    crc = ComputeUInt32Checksum(crc, numAtoms);
+
+    // Atoms are never removed or renamed, so anything already in the state is still valid.
+    if ((pState->pool != pPool) || (pState->numAtoms > numAtoms))
+    {
+        pState->pool = pPool;
+        pState->numAtoms = 0;
+        pState->cbData = 0;
+        pState->checksum = 0;
+    }
+
+    StringResult atomStr;
+    while (pState->numAtoms < numAtoms)
+    {
+        if (!pPool->TryGetString(pState->numAtoms, &atomStr))
+        {
+            // ComputeAtomPoolChecksum stops at the first missing atom too
+            break;
+        }
+
+        // ComputeStringChecksum adds the length of the string as a UINT32, then the string and its NULL.
+        PCWSTR pAtom = atomStr.GetRef();
+        UINT64 cbAtom = (pAtom != NULL) ? ((wcslen(pAtom) + 1) * sizeof(WCHAR)) : sizeof(UINT32);
+        RETURN_IF_FAILED(ComputeStringChecksum(pState->checksum, pPool->GetIsCaseInsensitive(), pAtom, &pState->checksum));
+        pState->cbData += sizeof(UINT32) + cbAtom;
+        pState->numAtoms++;
+    }
+
+    *checksum = _DefCombineCrc32(crc, pState->checksum, pState->cbData);
+    return S_OK;
+}
+
 HRESULT
 DefChecksum::ComputeAtomChecksum(
     __in Checksum partialChecksum,
@@ -9,6 +9,77 @@
 namespace Microsoft::Resources
 {
 
+// Indexed by ParsedQualifierOperand::KnownValue.
+static PCWSTR const KnownQualifierValues[ParsedQualifierOperand::NumKnownValues] = {
+    nullptr,
+    CoreEnvironment::ContrastValue_Standard,
+    CoreEnvironment::ContrastValue_High,
+    CoreEnvironment::ContrastValue_Black,
+    CoreEnvironment::ContrastValue_White,
+    CoreEnvironment::DXFeatureLevelValue_9,
+    CoreEnvironment::DXFeatureLevelValue_10,
+    CoreEnvironment::DXFeatureLevelValue_11,
+    CoreEnvironment::DXFeatureLevelValue_12,
+    CoreEnvironment::DeviceFamilyValue_UniversalAppPlatform,
+    CoreEnvironment::DeviceFamilyValue_Desktop,
+    CoreEnvironment::DeviceFamilyValue_Core,
+};
+
+void ParsedQualifierOperand::Parse(_In_opt_ PCWSTR pValue, _Out_ ParsedQualifierOperand* pOperandOut)
+{
+    *pOperandOut = {};
+
+    UINT16 flags = ParsedValue;
+
+    if (DefString_IsEmpty(pValue))
+    {
+        pOperandOut->flags = static_cast<UINT16>(flags | EmptyValue);
+        return;
+    }
+
+    bool isDecimal = true;
+    for (PCWSTR pTest = pValue; *pTest != L'\0'; pTest++)
+    {
+        if (*pTest == L';')
+        {
+            flags = static_cast<UINT16>(flags | ListValue);
+        }
+
+        if (!iswdigit(*pTest))
+        {
+            isDecimal = false;
+        }
+    }
+
+    if (isDecimal)
+    {
+        flags = static_cast<UINT16>(flags | DecimalValue);
+    }
+
+    pOperandOut->integerValue = _wtoi(pValue);
+    pOperandOut->knownValue = GetKnownValue(pValue, ContrastStandard, DeviceFamilyCore);
+    pOperandOut->flags = flags;
+}
+
+ParsedQualifierOperand::KnownValue
+ParsedQualifierOperand::GetKnownValue(_In_opt_ PCWSTR pValue, _In_ KnownValue first, _In_ KnownValue last)
+{
+    if (DefString_IsEmpty(pValue) || (first == UnknownValue) || (last >= NumKnownValues))
+    {
+        return UnknownValue;
+    }
+
+    for (int i = first; i <= last; i++)
+    {
+        if (DefString_ICompare(pValue, KnownQualifierValues[i]) == Def_Equal)
+        {
+            return static_cast<KnownValue>(i);
+        }
+    }
+
+    return UnknownValue;
+}
+
 HRESULT ContrastQualifierType::CreateInstance(_Outptr_ ContrastQualifierType** type)
 {
     *type = nullptr;
@@ -21,47 +92,68 @@ HRESULT ContrastQualifierType::CreateInstance(_Outptr_ ContrastQualifierType** t
     return S_OK;
 }
 
+HRESULT ContrastQualifierType::ValidateParsedQualifierValue(_In_ const ParsedQualifierOperand* pOperand) const
+{
+    if (pOperand->IsKnownValueInRange(ParsedQualifierOperand::ContrastStandard, ParsedQualifierOperand::ContrastWhite))
+    {
+        return S_OK;
+    }
+
+    return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_QUALIFIER_VALUE);
+}
+
 HRESULT ContrastQualifierType::Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pszProviderValue, _Out_ double* score) const
 {
     *score = 0.0;
 
-    StringResult qualifierValue;
+    ParsedQualifierOperand qualifierOperand;
     double result = 0.0;
 
-    RETURN_IF_FAILED(ValidateQualifier(pQualifier));
+    HRESULT hr = ValidateParsedQualifier(pQualifier, &qualifierOperand);
+    RETURN_IF_FAILED(hr);
     RETURN_IF_FAILED(ValidateQualifierValue(pszProviderValue));
-    RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierValue));
 
-    PCWSTR pszQualifierValue = qualifierValue.GetRef();
+    auto qualifierValue = static_cast<ParsedQualifierOperand::KnownValue>(qualifierOperand.knownValue);
+    if (hr == S_FALSE)
+    {
+        // not parsed at load
+        StringResult qualifierLiteral;
+        RETURN_IF_FAILED(pQualifier->GetOperand2Literal(&qualifierLiteral));
+        qualifierValue = ParsedQualifierOperand::GetKnownValue(
+            qualifierLiteral.GetRef(), ParsedQualifierOperand::ContrastStandard, ParsedQualifierOperand::ContrastWhite);
+    }
+
+    // Both values were validated above, so each is one of the known contrast values.
+    auto providerValue = ParsedQualifierOperand::GetKnownValue(
+        pszProviderValue, ParsedQualifierOperand::ContrastStandard, ParsedQualifierOperand::ContrastWhite);
 
     // same value => 1.0
     // any of standard => 0.0
     // asset white  => 0.5
     // others => 0.1
-    if (CompareStringOrdinal(pszProviderValue, -1, pszQualifierValue, -1, TRUE) == 2)
+    if ((providerValue != ParsedQualifierOperand::UnknownValue) && (providerValue == qualifierValue))
     {
         result = 1.0;
     }
     else
     {
-        if (CompareStringOrdinal(CoreEnvironment::ContrastValue_Standard, -1, pszProviderValue, -1, TRUE) == 2 ||
-            CompareStringOrdinal(CoreEnvironment::ContrastValue_Standard, -1, pszQualifierValue, -1, TRUE) == 2)
+        if ((providerValue == ParsedQualifierOperand::ContrastStandard) || (qualifierValue == ParsedQualifierOperand::ContrastStandard))
         {
             result = 0.0;
         }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_High, -1, pszQualifierValue, -1, TRUE) == 2)
+        else if (qualifierValue == ParsedQualifierOperand::ContrastHigh)
         {
             result = 0.5;
         }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_White, -1, pszQualifierValue, -1, TRUE) == 2)
+        else if (qualifierValue == ParsedQualifierOperand::ContrastWhite)
         {
             result = 0.1;
         }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_White, -1, pszProviderValue, -1, TRUE) == 2)
+        else if (providerValue == ParsedQualifierOperand::ContrastWhite)
         {
             result = 0.1;
         }
-        else if (CompareStringOrdinal(CoreEnvironment::ContrastValue_Black, -1, pszQualifierValue, -1, TRUE) == 2)
+        else if (qualifierValue == ParsedQualifierOperand::ContrastBlack)
         {
             // make sure the asset (condition) value is a supported one by adding this additional comparison.
             result = 0.5;
@@ -176,9 +268,10 @@ HRESULT ScaleQualifierType::Evaluate(_In_ const IQualifier* pAssetQualifier, _In
     *score = 0.0;
 
     double result = 0.0;
-    StringResult assetQualifierValue;
+    ParsedQualifierOperand assetOperand;
 
-    RETURN_IF_FAILED(ValidateQualifier(pAssetQualifier));
+    HRESULT hr = ValidateParsedQualifier(pAssetQualifier, &assetOperand);
+    RETURN_IF_FAILED(hr);
     RETURN_IF_FAILED(ValidateQualifierValue(pContextValue)); // downlevel provider can return illegal values
 
     if (DefString_IsEmpty(pContextValue))
@@ -187,10 +280,16 @@ HRESULT ScaleQualifierType::Evaluate(_In_ const IQualifier* pAssetQualifier, _In
         return S_OK;
     }
 
-    RETURN_IF_FAILED(pAssetQualifier->GetOperand2Literal(&assetQualifierValue));
-
     int contextValue = _wtoi(pContextValue);
-    int assetValue = _wtoi(assetQualifierValue.GetRef());
+    int assetValue = assetOperand.integerValue;
+
+    if (hr == S_FALSE)
+    {
+        // not parsed at load
+        StringResult assetQualifierValue;
+        RETURN_IF_FAILED(pAssetQualifier->GetOperand2Literal(&assetQualifierValue));
+        assetValue = _wtoi(assetQualifierValue.GetRef());
+    }
 
     // same value => 1.0
     // (asset > context) && (asset <= context * 2) => 0.75..0.99
@@ -275,49 +374,45 @@ HRESULT DXFeatureLevelQualifierType::CreateInstance(_Outptr_ DXFeatureLevelQuali
     return S_OK;
 }
 
+int DXFeatureLevelQualifierType::GetFeatureLevel(_In_ ParsedQualifierOperand::KnownValue value)
+{
+    switch (value)
+    {
+    case ParsedQualifierOperand::DXFeatureLevel9:
+        return 9;
+    case ParsedQualifierOperand::DXFeatureLevel10:
+        return 10;
+    case ParsedQualifierOperand::DXFeatureLevel11:
+        return 11;
+    case ParsedQualifierOperand::DXFeatureLevel12:
+        return 12;
+    }
+
+    return -1;
+}
+
 HRESULT DXFeatureLevelQualifierType::Evaluate(_In_ const IQualifier* pQualifier, _In_ PCWSTR pszProviderValue, _Out_ double* score) const
 {
     *score = 0.0;
 
     double result = 0.0;
-    StringResult qualifierValue;
-    int providerLevel = -1;
+    ParsedQualifierOperand qualifierOperand;
     int qualifierLevel = -1;
 
-    if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_9) == Def_Equal)
-    {
-        providerLevel = 9;
-    }
-    else if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_10) == Def_Equal)
-    {
-        providerLevel = 10;
-    }
-    else if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_11) == Def_Equal)
-    {
-        providerLevel = 11;
-    }
-    else if (DefString_ICompare(pszProviderValue, CoreEnvironment::DXFeatureLevelValue_12) == Def_Equal)
+    int providerLevel = GetFeatureLevel(ParsedQualifierOperand::GetKnownValue(
+        pszProviderValue, ParsedQualifierOperand::DXFeatureLevel9, ParsedQualifierOperand::DXFeatureLevel12));
+
+    if (pQualifier->TryGetParsedOperand2(&qualifierOperand))
     {
-        providerLevel = 12;
+        qualifierLevel = GetFeatureLevel(static_cast<ParsedQualifierOperand::KnownValue>(qualifierOperand.knownValue));
     }
-
-    if (SUCCEEDED(pQualifier->GetOperand2Literal(&qualifierValue)))
+    else
     {
-        if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_9) == Def_Equal)
-        {
-            qualifierLevel = 9;
-        }
-        else if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_10) == Def_Equal)
+        StringResult qualifierValue;
+        if (SUCCEEDED(pQualifier->GetOperand2Literal(&qualifierValue)))
         {
-            qualifierLevel = 10;
-        }
-        else if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_11) == Def_Equal)
-        {
-            qualifierLevel = 11;
-        }
-        else if (DefString_ICompare(qualifierValue.GetRef(), CoreEnvironment::DXFeatureLevelValue_12) == Def_Equal)
-        {
-            qualifierLevel = 12;
+            qualifierLevel = GetFeatureLevel(ParsedQualifierOperand::GetKnownValue(
+                qualifierValue.GetRef(), ParsedQualifierOperand::DXFeatureLevel9, ParsedQualifierOperand::DXFeatureLevel12));
         }
     }
 
@@ -388,9 +483,31 @@ HRESULT DeviceFamilyQualifierType::Evaluate(_In_ const IQualifier* pAssetQualifi
     *score = 0.0;
 
     StringResult assetValue;
+    ParsedQualifierOperand assetOperand;
     double result = 0.0;
 
-    if (SUCCEEDED(pAssetQualifier->GetOperand2Literal(&assetValue)))
+    if (pAssetQualifier->TryGetParsedOperand2(&assetOperand) &&
+        assetOperand.IsKnownValueInRange(ParsedQualifierOperand::DeviceFamilyUniversal, ParsedQualifierOperand::DeviceFamilyCore))
+    {
+        // A context value that isn't one of the known families can't equal a known asset value.
+        auto contextFamily = ParsedQualifierOperand::GetKnownValue(
+            pContextValue, ParsedQualifierOperand::DeviceFamilyUniversal, ParsedQualifierOperand::DeviceFamilyCore);
+
+        if (contextFamily == assetOperand.knownValue)
+        {
+            result = 1.0;
+        }
+        else if (assetOperand.knownValue == ParsedQualifierOperand::DeviceFamilyUniversal)
+        {
+            result = 0.5;
+        }
+        else if ((contextFamily == ParsedQualifierOperand::DeviceFamilyCore) &&
+                 (assetOperand.knownValue == ParsedQualifierOperand::DeviceFamilyDesktop))
+        {
+            result = 0.25;
+        }
+    }
+    else if (SUCCEEDED(pAssetQualifier->GetOperand2Literal(&assetValue)))
     {
         if (DefString_IEqual(pContextValue, assetValue.GetRef()))
         {
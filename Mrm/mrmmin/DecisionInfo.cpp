@@ -28,7 +28,14 @@ public:
         return S_OK;
     }
 
-    virtual ~DecisionInfoFileData() {}
+    virtual ~DecisionInfoFileData()
+    {
+        if (m_pParsedOperands != nullptr)
+        {
+            Def_Free(m_pParsedOperands);
+            m_pParsedOperands = nullptr;
+        }
+    }
 
     int GetNumBaseQualifiers() const { return m_pHeader->numBaseQualifiers; }
     int GetNumQualifiers() const { return m_pHeader->numQualifiers; }
@@ -129,6 +136,20 @@ public:
         return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
     }
 
+    bool TryGetParsedOperand(_In_ int baseQualifierIndex, _Out_ ParsedQualifierOperand* pOperandOut) const
+    {
+        if ((m_pParsedOperands == nullptr) || (!IsValidBaseQualifierIndex(baseQualifierIndex)))
+        {
+            *pOperandOut = {};
+            return false;
+        }
+
+        _Analysis_assume_((baseQualifierIndex >= 0) && (baseQualifierIndex < m_pHeader->numBaseQualifiers));
+
+        *pOperandOut = m_pParsedOperands[baseQualifierIndex];
+        return pOperandOut->IsParsed();
+    }
+
     const RemapAtomPool* GetQualifierMapping() const { return m_pQualifierMapping; }
 
     const IDecisionInfo* GetPool() const { return m_pDecisionInfo; }
@@ -145,6 +166,9 @@ private:
     _Field_size_(m_pHeader->numReferences) const UINT16* m_pReferences{ nullptr };
     _Field_size_(m_pHeader->cchLiterals) PCWSTR m_pLiterals{ nullptr };
 
+    // Operand of each base qualifier, parsed at load.
+    _Field_size_opt_(m_pHeader->numBaseQualifiers) ParsedQualifierOperand* m_pParsedOperands{ nullptr };
+
     DecisionInfoFileData() :
         m_pHeader(nullptr),
         m_pDecisions(nullptr),
@@ -178,8 +202,32 @@ private:
         m_pReferences = _SECTION_PARSER_NEXT_ARRAY(data, m_pHeader->numReferences, UINT16, &hr);
         m_pLiterals = _SECTION_PARSER_NEXT_ARRAY(data, m_pHeader->cchLiterals, WCHAR, &hr);
         data.GetPadBytes(BaseFile::Align32Bit, &hr, nullptr);
+        RETURN_IF_FAILED(hr);
+
+        return ParseOperands();
+    }
+
+    HRESULT ParseOperands()
+    {
+        if (m_pHeader->numBaseQualifiers == 0)
+        {
+            return S_OK;
+        }
+
+        m_pParsedOperands = _DefArray_AllocZeroed(ParsedQualifierOperand, m_pHeader->numBaseQualifiers);
+        RETURN_IF_NULL_ALLOC(m_pParsedOperands);
+
+        for (int i = 0; i < m_pHeader->numBaseQualifiers; i++)
+        {
+            // Operands with a bad literal offset are left unparsed and fail on use as before.
+            int offset = m_pBaseQualifiers[i].valueOffset;
+            if (IsValidLiteralOffset(offset))
+            {
+                ParsedQualifierOperand::Parse(&m_pLiterals[offset], &m_pParsedOperands[i]);
+            }
+        }
 
-        return hr;
+        return S_OK;
     }
 };
 
@@ -663,6 +711,17 @@ HRESULT QualifierResult::GetOperand2Literal(_Inout_ StringResult* pLiteralOut) c
     return m_pRaw->GetLiteral(m_baseQualifier.valueOffset, pLiteralOut);
 }
 
+bool QualifierResult::TryGetParsedOperand2(_Out_ ParsedQualifierOperand* pOperandOut) const
+{
+    if (m_pRaw == nullptr)
+    {
+        *pOperandOut = {};
+        return false;
+    }
+
+    return m_pRaw->TryGetParsedOperand(m_baseIndex, pOperandOut);
+}
+
 HRESULT QualifierResult::GetOperand2Attribute(_Inout_ Atom* pAttrOut) const
 {
     *pAttrOut = Atom::NullAtom;
@@ -38,6 +38,13 @@ public:
 
     virtual HRESULT GetDecisionNumQualifierSets(_In_ int index, _Out_ int* pNumSetsOut) const = 0;
 
+    // Returns false if the operand of the base qualifier was not parsed at load.
+    virtual bool TryGetParsedOperand(_In_ int /* baseQualifierIndex */, _Out_ ParsedQualifierOperand* pOperandOut) const
+    {
+        *pOperandOut = {};
+        return false;
+    }
+
 protected:
     IRawDecisionInfo() {}
 };
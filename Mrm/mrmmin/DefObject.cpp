@@ -8,4 +8,124 @@ namespace Microsoft::Resources
 
 void DefFreeMemory(void* p) { Def_Free(p); }
 
+// Keeps object payloads aligned the same way the process heap would.
+static const size_t DefArenaHeaderSize = MEMORY_ALLOCATION_ALIGNMENT;
+
+static_assert(DefArenaHeaderSize >= sizeof(DefArena*), "arena header too small");
+
+DefArena::DefArena() : m_pBlocks(nullptr) { _DefInitializeSRWLock(&m_lock); }
+
+DefArena::~DefArena()
+{
+    while (m_pBlocks != nullptr)
+    {
+        Block* pNext = m_pBlocks->pNext;
+        _DefPlatformFree(m_pBlocks);
+        m_pBlocks = pNext;
+    }
+}
+
+HRESULT DefArena::CreateInstance(_Outptr_ DefArena** result)
+{
+    *result = nullptr;
+
+    DefArena* pRtrn = new DefArena();
+    RETURN_IF_NULL_ALLOC(pRtrn);
+
+    *result = pRtrn;
+    return S_OK;
+}
+
+_Ret_maybenull_ void* DefArena::AllocZeroed(_In_ size_t size)
+{
+    const size_t cbHeader = _DEFFILE_PAD(sizeof(Block), MEMORY_ALLOCATION_ALIGNMENT);
+    size_t cbNeeded = _DEFFILE_PAD(size, MEMORY_ALLOCATION_ALIGNMENT);
+    if ((cbNeeded < size) || (cbNeeded > (SIZE_MAX - cbHeader)))
+    {
+        return nullptr;
+    }
+
+    AutoReaderWriterLock lock(&m_lock);
+
+    Block* pBlock = m_pBlocks;
+    if ((pBlock == nullptr) || ((pBlock->cbSize - pBlock->cbUsed) < cbNeeded))
+    {
+        // Oversized requests get a block of their own, which goes behind the
+        // current block so the space left in it can still be used.
+        size_t cbBlock = cbNeeded + cbHeader;
+        if (cbBlock < BlockSize)
+        {
+            cbBlock = BlockSize;
+        }
+
+        Block* pNewBlock = static_cast<Block*>(_DefPlatformAllocZeroed(cbBlock));
+        if (pNewBlock == nullptr)
+        {
+            return nullptr;
+        }
+
+        pNewBlock->cbSize = cbBlock;
+        pNewBlock->cbUsed = cbHeader;
+
+        if ((pBlock != nullptr) && (cbBlock > BlockSize))
+        {
+            pNewBlock->pNext = pBlock->pNext;
+            pBlock->pNext = pNewBlock;
+        }
+        else
+        {
+            pNewBlock->pNext = pBlock;
+            m_pBlocks = pNewBlock;
+        }
+
+        pBlock = pNewBlock;
+    }
+
+    void* p = reinterpret_cast<BYTE*>(pBlock) + pBlock->cbUsed;
+    pBlock->cbUsed += cbNeeded;
+    return p;
+}
+
+_Ret_maybenull_ void* DefArena::AllocObject(_In_opt_ DefArena* pArena, _In_ size_t size)
+{
+    if (size > (SIZE_MAX - DefArenaHeaderSize))
+    {
+        return nullptr;
+    }
+
+    BYTE* p;
+    if (pArena != nullptr)
+    {
+        p = static_cast<BYTE*>(pArena->AllocZeroed(size + DefArenaHeaderSize));
+    }
+    else
+    {
+        p = static_cast<BYTE*>(_DefPlatformAllocZeroed(size + DefArenaHeaderSize));
+    }
+
+    if (p == nullptr)
+    {
+        return nullptr;
+    }
+
+    *reinterpret_cast<DefArena**>(p) = pArena;
+    return p + DefArenaHeaderSize;
+}
+
+void DefArena::FreeObject(_In_opt_ void* p)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+
+    BYTE* pAlloc = static_cast<BYTE*>(p) - DefArenaHeaderSize;
+
+    // Arena memory is reclaimed when the arena itself is deleted.
+    if (*reinterpret_cast<DefArena**>(pAlloc) == nullptr)
+    {
+        _DefPlatformFree(pAlloc);
+    }
+}
+
 } // namespace Microsoft::Resources
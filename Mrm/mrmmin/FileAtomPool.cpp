@@ -86,7 +86,14 @@ HRESULT FileAtomPool::Initialize(__in_opt const IFileSection* pSection, __in_bco
     return hr;
 }
 
-FileAtomPool::~FileAtomPool() {}
+FileAtomPool::~FileAtomPool()
+{
+    if (m_pLookupIndex != nullptr)
+    {
+        delete m_pLookupIndex;
+        m_pLookupIndex = nullptr;
+    }
+}
 
 HRESULT FileAtomPool::CreateInstance(__in const IFileSection* pFileSection, _Outptr_ FileAtomPool** result)
 {
@@ -267,7 +274,26 @@ bool FileAtomPool::TryGetIndex(__in PCWSTR pString, __out_opt Atom::Index* pInde
         return false;
     }
 
-    if (m_pHeader->flags & DEFFILE_ATOMPOOL_HASH_NONE)
+    const AtomHashIndex* pLookupIndex = nullptr;
+    if (m_pHeader->flags & (DEFFILE_ATOMPOOL_HASH_NONE | DEFFILE_ATOMPOOL_HASH_UNSORTED))
+    {
+        pLookupIndex = AtomHashIndex::GetOrCreate(this, &m_pLookupIndex);
+    }
+
+    if (pLookupIndex != nullptr)
+    {
+        hash = pLookupIndex->HashString(pString);
+        UINT32 slot = pLookupIndex->GetFirstSlot(hash);
+        while (pLookupIndex->TryGetNextCandidate(hash, &slot, &i))
+        {
+            if (CompareAtIndex(i, pString) == 0)
+            {
+                found = true;
+                break;
+            }
+        }
+    }
+    else if (m_pHeader->flags & DEFFILE_ATOMPOOL_HASH_NONE)
     {
         for (i = 0; i < m_pHeader->nAtoms; i++)
         {
@@ -85,7 +85,18 @@ _Use_decl_annotations_ HRESULT FileDataItemsSection::Init(const IFileSection* pS
 {
     SectionParser data;
 
-    RETURN_IF_FAILED(FileSectionBase::Init(pSection, pData, cbData, gDataItemsSectionType));
+    // Chunked sections use their own type so that older readers reject them
+    // rather than misinterpreting the large item table.
+    bool isChunkedType = false;
+    if (pSection != nullptr)
+    {
+        isChunkedType = BaseFile::SectionTypesEqual(pSection->GetSectionType(), gDataItemsChunkedSectionType);
+        RETURN_HR_IF(
+            HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+            !isChunkedType && !BaseFile::SectionTypesEqual(pSection->GetSectionType(), gDataItemsSectionType));
+    }
+
+    RETURN_IF_FAILED(FileSectionBase::Init(pSection, pData, cbData));
     RETURN_IF_FAILED(ValidateHeader(pData, cbData));
     RETURN_IF_FAILED(data.Set(pData, cbData));
 
@@ -101,6 +112,24 @@ _Use_decl_annotations_ HRESULT FileDataItemsSection::Init(const IFileSection* pS
         {
             m_pLargeItems = _SECTION_PARSER_NEXT_ARRAY(data, GetNumberOfLargeItems(m_pHeader), DEFFILE_DATA_ITEM_LARGE, &hr);
         }
+        if (IsChunked())
+        {
+            RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (pSection != nullptr) && !isChunkedType);
+
+            const DEFFILE_DATAITEMS_CHUNK_TABLE* pChunkTable = _SECTION_PARSER_NEXT(data, DEFFILE_DATAITEMS_CHUNK_TABLE, &hr);
+            if (pChunkTable != nullptr)
+            {
+                m_numChunkRefs = pChunkTable->numChunkRefs;
+                if (m_numChunkRefs > 0)
+                {
+                    m_pChunkRefs = _SECTION_PARSER_NEXT_ARRAY(data, m_numChunkRefs, DEFFILE_DATA_ITEM_LARGE, &hr);
+                }
+            }
+        }
+        else
+        {
+            RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), isChunkedType);
+        }
         if (m_pHeader->cbData > 0)
         {
             m_pData = _SECTION_PARSER_NEXT_ARRAY(data, m_pHeader->cbData, BYTE, &hr);
@@ -151,6 +180,47 @@ _Use_decl_annotations_ HRESULT FileDataItemsSection::ValidateHeader(const void*
     return S_OK;
 }
 
+_Use_decl_annotations_ HRESULT FileDataItemsSection::GetChunkedItemInfo(
+    UINT32 largeItemIndex,
+    UINT32* pFirstChunkRef,
+    UINT32* pNumChunkRefs,
+    bool* pIsContiguous) const
+{
+    *pFirstChunkRef = 0;
+    *pNumChunkRefs = 0;
+    *pIsContiguous = true;
+
+    const DEFFILE_DATA_ITEM_LARGE* pItem = &m_pLargeItems[largeItemIndex];
+    size_t cbRemaining = pItem->cbData;
+    UINT32 chunkRef = pItem->offset;
+
+    while (cbRemaining > 0)
+    {
+        // File data is bad if the item runs off the end of the chunk table, or
+        // if any chunk points outside of the data
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), chunkRef >= m_numChunkRefs);
+
+        const DEFFILE_DATA_ITEM_LARGE* pChunk = &m_pChunkRefs[chunkRef];
+        RETURN_HR_IF(
+            HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+            (pChunk->cbData == 0) || (pChunk->cbData > cbRemaining) ||
+                ((static_cast<size_t>(pChunk->offset) + pChunk->cbData) > m_pHeader->cbData));
+
+        if ((chunkRef > pItem->offset) &&
+            ((static_cast<size_t>(m_pChunkRefs[chunkRef - 1].offset) + m_pChunkRefs[chunkRef - 1].cbData) != pChunk->offset))
+        {
+            *pIsContiguous = false;
+        }
+
+        cbRemaining -= pChunk->cbData;
+        chunkRef++;
+    }
+
+    *pFirstChunkRef = pItem->offset;
+    *pNumChunkRefs = chunkRef - pItem->offset;
+    return S_OK;
+}
+
 _Use_decl_annotations_ HRESULT FileDataItemsSection::GetItemDataRef(UINT32 index, const BYTE** result, UINT32* pcbDataOut) const
 {
     *result = nullptr;
@@ -163,6 +233,19 @@ _Use_decl_annotations_ HRESULT FileDataItemsSection::GetItemDataRef(UINT32 index
         offset = m_pSmallItems[index].offset;
         cbItemData = m_pSmallItems[index].cbData;
     }
+    else if (((index - m_pHeader->numSmallItems) < GetNumberOfLargeItems(m_pHeader)) && IsChunked())
+    {
+        // A chunked item can only be returned as a single reference if its chunks
+        // happen to be laid out back-to-back; otherwise it must be reassembled.
+        UINT32 firstChunkRef;
+        UINT32 numChunkRefs;
+        bool isContiguous;
+        RETURN_IF_FAILED(GetChunkedItemInfo(index - m_pHeader->numSmallItems, &firstChunkRef, &numChunkRefs, &isContiguous));
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED), !isContiguous);
+
+        offset = (numChunkRefs > 0) ? m_pChunkRefs[firstChunkRef].offset : 0;
+        cbItemData = m_pLargeItems[index - m_pHeader->numSmallItems].cbData;
+    }
     else if ((index - m_pHeader->numSmallItems) < GetNumberOfLargeItems(m_pHeader))
     {
         offset = m_pLargeItems[index - m_pHeader->numSmallItems].offset;
@@ -190,6 +273,33 @@ _Use_decl_annotations_ HRESULT FileDataItemsSection::GetItemDataRef(UINT32 index
 
 _Use_decl_annotations_ HRESULT FileDataItemsSection::GetItemDataRef(UINT32 index, BlobResult* pData) const
 {
+    if (IsChunked() && (index >= m_pHeader->numSmallItems) && ((index - m_pHeader->numSmallItems) < GetNumberOfLargeItems(m_pHeader)))
+    {
+        UINT32 largeItemIndex = index - m_pHeader->numSmallItems;
+        UINT32 firstChunkRef;
+        UINT32 numChunkRefs;
+        bool isContiguous;
+        RETURN_IF_FAILED(GetChunkedItemInfo(largeItemIndex, &firstChunkRef, &numChunkRefs, &isContiguous));
+
+        if (!isContiguous)
+        {
+            UINT32 cbItemData = m_pLargeItems[largeItemIndex].cbData;
+            BYTE* pBuf = nullptr;
+            RETURN_IF_FAILED(pData->SetEmptyContents(cbItemData, (void**)&pBuf, nullptr));
+
+            size_t cbCopied = 0;
+            for (UINT32 i = firstChunkRef; i < firstChunkRef + numChunkRefs; i++)
+            {
+                CopyMemory(pBuf + cbCopied, &m_pData[m_pChunkRefs[i].offset], m_pChunkRefs[i].cbData);
+                cbCopied += m_pChunkRefs[i].cbData;
+            }
+
+            // The buffer may be larger than the item if it was reused
+            RETURN_IF_FAILED(pData->SetRef(pBuf, cbItemData));
+            return S_OK;
+        }
+    }
+
     UINT32 cbData;
     const BYTE* pLocalData;
     RETURN_IF_FAILED(GetItemDataRef(index, &pLocalData, &cbData));
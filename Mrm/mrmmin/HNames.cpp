@@ -355,6 +355,8 @@ HierarchicalNames::HierarchicalNames() :
     m_pAsciiNames(nullptr),
     m_pScopeNames(nullptr),
     m_pItemNames(nullptr),
+    m_pLookupCache(nullptr),
+    m_pPathIndex(nullptr),
     m_largeNode(false)
 {}
 
@@ -479,13 +481,910 @@ HRESULT HierarchicalNames::CreateInstance(
     return S_OK;
 }
 
+#define HNAMES_PATH_HASH_SEED 0xCBF29CE484222325ull
+#define HNAMES_PATH_HASH_PRIME 0x100000001B3ull
+#define HNAMES_FILTER_BITS_PER_NAME 16
+#define HNAMES_FILTER_NUM_PROBES 4
+#define HNAMES_PATH_INDEX_MAX_NODES 0x40000000
+
+// A direct-mapped cache of recent path lookups plus a Bloom filter over the
+// root-relative paths of every node in the section.
+struct HierarchicalNames::LookupCache
+{
+    struct Entry
+    {
+        UINT64 hash;
+        int relativeToScope;
+        int nameIndex;
+        PWSTR pPath; // owned
+    };
+
+    _DEF_SRWLOCK lock;
+    UINT32 entryMask;
+    _Field_size_(entryMask + 1) Entry* pEntries;
+
+    // null if the filter couldn't be built; negative lookups then walk the tree
+    UINT32 filterBitMask;
+    UINT64* pFilterBits;
+};
+
+// An open-addressed table from the root-relative path hash of every node to
+// its index.  The low bits of the hash pick the slot and the high bits are
+// kept to skip most non-matching entries without touching the node.
+struct HierarchicalNames::PathIndex
+{
+    struct Entry
+    {
+        UINT32 hashHigh;
+        UINT32 nameIndexPlusOne; // zero marks an empty slot
+    };
+
+    UINT32 slotMask;
+    _Field_size_(slotMask + 1) Entry* pEntries;
+};
+
+// Folds one character the way CompareSegments compares them and feeds it to
+// an FNV-1a hash.  Separators are normalized so '\\' and '/' hash alike.
+static inline UINT64 HNamesHashChar(_In_ UINT64 hash, _In_ WCHAR ch)
+{
+    if (ch < 0x80)
+    {
+        if ((ch >= L'a') && (ch <= L'z'))
+        {
+            ch -= (L'a' - L'A');
+        }
+        else if (ch == L'\\')
+        {
+            ch = L'/';
+        }
+    }
+    else
+    {
+        ch = towupper(ch);
+    }
+    return (hash ^ ch) * HNAMES_PATH_HASH_PRIME;
+}
+
+// Hashes a lookup path as Contains would interpret it: an optional leading
+// separator and a single trailing separator are ignored.  Returns false for
+// paths that have nothing left to hash.  The hashed part of the path is
+// returned through ppTrimmedOut and pcchTrimmedOut.
+static bool HNamesTryHashLookupPath(
+    _In_ const HierarchicalNamesConfig* pConfig,
+    _In_ PCWSTR pPath,
+    _Out_ UINT64* pHashOut,
+    _Out_ bool* pIsAsciiOut,
+    _Out_opt_ PCWSTR* ppTrimmedOut = nullptr,
+    _Out_opt_ int* pcchTrimmedOut = nullptr)
+{
+    *pHashOut = HNAMES_PATH_HASH_SEED;
+    *pIsAsciiOut = true;
+
+    if (pConfig->IsPathSeparator(pPath[0]))
+    {
+        pPath++;
+    }
+
+    size_t cchPath = wcslen(pPath);
+    if ((cchPath > 0) && pConfig->IsPathSeparator(pPath[cchPath - 1]))
+    {
+        cchPath--;
+    }
+    if ((cchPath == 0) || (cchPath > MAXUINT16))
+    {
+        return false;
+    }
+
+    UINT64 hash = HNAMES_PATH_HASH_SEED;
+    WCHAR allChars = 0;
+    for (size_t i = 0; i < cchPath; i++)
+    {
+        allChars |= pPath[i];
+        hash = HNamesHashChar(hash, pPath[i]);
+    }
+
+    *pHashOut = hash;
+    *pIsAsciiOut = (allChars < 0x80);
+    if (ppTrimmedOut != nullptr)
+    {
+        *ppTrimmedOut = pPath;
+    }
+    if (pcchTrimmedOut != nullptr)
+    {
+        *pcchTrimmedOut = static_cast<int>(cchPath);
+    }
+    return true;
+}
+
+static inline void HNamesAddToFilter(_Inout_ UINT64* pBits, _In_ UINT32 bitMask, _In_ UINT64 hash)
+{
+    UINT32 h1 = static_cast<UINT32>(hash);
+    UINT32 h2 = static_cast<UINT32>(hash >> 32) | 1;
+    for (UINT32 i = 0; i < HNAMES_FILTER_NUM_PROBES; i++)
+    {
+        UINT32 bit = (h1 + (i * h2)) & bitMask;
+        pBits[bit / 64] |= (1ull << (bit % 64));
+    }
+}
+
+static inline bool HNamesFilterMayContain(_In_ const UINT64* pBits, _In_ UINT32 bitMask, _In_ UINT64 hash)
+{
+    UINT32 h1 = static_cast<UINT32>(hash);
+    UINT32 h2 = static_cast<UINT32>(hash >> 32) | 1;
+    for (UINT32 i = 0; i < HNAMES_FILTER_NUM_PROBES; i++)
+    {
+        UINT32 bit = (h1 + (i * h2)) & bitMask;
+        if ((pBits[bit / 64] & (1ull << (bit % 64))) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 HierarchicalNames::~HierarchicalNames()
 {
-    delete m_pScopeNames;
-    delete m_pItemNames;
+    delete m_pScopeNames;
+    delete m_pItemNames;
+
+    m_pScopeNames = NULL;
+    m_pItemNames = NULL;
+
+    if (m_pLookupCache != nullptr)
+    {
+        for (UINT32 i = 0; i <= m_pLookupCache->entryMask; i++)
+        {
+            if (m_pLookupCache->pEntries[i].pPath != nullptr)
+            {
+                _DefFree(m_pLookupCache->pEntries[i].pPath);
+            }
+        }
+        _DefFree(m_pLookupCache->pEntries);
+        if (m_pLookupCache->pFilterBits != nullptr)
+        {
+            _DefFree(m_pLookupCache->pFilterBits);
+        }
+        _DefFree(m_pLookupCache);
+        m_pLookupCache = nullptr;
+    }
+
+    if (m_pPathIndex != nullptr)
+    {
+        _DefFree(m_pPathIndex->pEntries);
+        _DefFree(m_pPathIndex);
+        m_pPathIndex = nullptr;
+    }
+}
+
+HRESULT HierarchicalNames::EnableLookupCache(_In_ UINT32 maxEntries) const
+{
+    RETURN_HR_IF(E_INVALIDARG, (maxEntries == 0) || (maxEntries > 0x100000));
+
+    if (m_pLookupCache != nullptr)
+    {
+        return S_OK;
+    }
+
+    UINT32 numEntries = 1;
+    while (numEntries < maxEntries)
+    {
+        numEntries *= 2;
+    }
+
+    LookupCache* pCache = _DefAllocZeroed(LookupCache);
+    RETURN_IF_NULL_ALLOC(pCache);
+
+    pCache->entryMask = numEntries - 1;
+    pCache->pEntries = _DefArray_AllocZeroed(LookupCache::Entry, numEntries);
+    if (pCache->pEntries == nullptr)
+    {
+        _DefFree(pCache);
+        return E_OUTOFMEMORY;
+    }
+
+    // The filter is an optimization only.  If it can't be built, misses
+    // simply fall through to the tree walk.
+    UINT64 numFilterBits = 64;
+    while ((numFilterBits < (static_cast<UINT64>(m_pHeader->numNodes) * HNAMES_FILTER_BITS_PER_NAME)) && (numFilterBits < 0x80000000ull))
+    {
+        numFilterBits *= 2;
+    }
+    pCache->filterBitMask = static_cast<UINT32>(numFilterBits - 1);
+    pCache->pFilterBits = _DefArray_AllocZeroed(UINT64, static_cast<size_t>(numFilterBits / 64));
+    if ((pCache->pFilterBits != nullptr) && ((m_pHeader->numScopes == 0) ||
+                                             FAILED(AddScopeToLookupFilter(pCache, 0, HNAMES_PATH_HASH_SEED, 0))))
+    {
+        _DefFree(pCache->pFilterBits);
+        pCache->pFilterBits = nullptr;
+    }
+
+    if (InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pLookupCache), pCache, nullptr) != nullptr)
+    {
+        // Someone else got there first
+        if (pCache->pFilterBits != nullptr)
+        {
+            _DefFree(pCache->pFilterBits);
+        }
+        _DefFree(pCache->pEntries);
+        _DefFree(pCache);
+    }
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::AddScopeToLookupFilter(
+    _Inout_ LookupCache* pCache,
+    _In_ int scopeIndex,
+    _In_ UINT64 pathHash,
+    _In_ UINT32 currentDepth) const
+{
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scopeIndex < 0) || (scopeIndex > m_pHeader->numScopes - 1));
+
+    DEFFILE_HNAMES_SCOPE_LARGE scope =
+        (m_largeNode ? m_pScopesLarge[scopeIndex] : HNAMES_SCOPE_TO_HNAMES_SCOPE_LARGE(&m_pScopes[scopeIndex]));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scope.firstChildNameNode + scope.numChildNames) > m_pHeader->numNodes);
+
+    // The root scope has no name of its own, so its children have no leading separator
+    if (currentDepth > 0)
+    {
+        pathHash = HNamesHashChar(pathHash, GetDefaultPathSeparator());
+    }
+
+    for (int i = 0; i < scope.numChildNames; i++)
+    {
+        int nodeIndex = scope.firstChildNameNode + i;
+        DEFFILE_HNAMES_NODE_LARGE node = (m_largeNode ? m_pNodesLarge[nodeIndex] : HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[nodeIndex]));
+        UINT64 hash;
+        RETURN_IF_FAILED(HashNodeName(&node, pathHash, &hash));
+
+        HNamesAddToFilter(pCache->pFilterBits, pCache->filterBitMask, hash);
+
+        if ((node.flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NODE_IS_SCOPE) != 0)
+        {
+            RETURN_HR_IF(
+                HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+                (static_cast<int>(node.payload) == scopeIndex) || (currentDepth > m_pHeader->numScopes));
+            RETURN_IF_FAILED(AddScopeToLookupFilter(pCache, node.payload, hash, currentDepth + 1));
+        }
+    }
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::GetNodeNameLength(_In_ const DEFFILE_HNAMES_NODE_LARGE* pNode, _Out_ int* pcchName) const
+{
+    *pcchName = pNode->cchName;
+    if (pNode->cchName != 0)
+    {
+        return S_OK;
+    }
+
+    UINT32 nameOffset = HNamesGetNodeNameOffsetLarge(pNode);
+    if ((pNode->flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
+    {
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), nameOffset >= m_pHeader->cchAsciiNamesPool);
+        *pcchName = static_cast<int>(strnlen(&m_pAsciiNames[nameOffset], m_pHeader->cchAsciiNamesPool - nameOffset));
+    }
+    else
+    {
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), nameOffset >= m_pHeader->cchUtf16NamesPool);
+        *pcchName = static_cast<int>(wcsnlen(&m_pUtf16Names[nameOffset], m_pHeader->cchUtf16NamesPool - nameOffset));
+    }
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::HashNodeName(_In_ const DEFFILE_HNAMES_NODE_LARGE* pNode, _In_ UINT64 pathHash, _Out_ UINT64* pHashOut) const
+{
+    *pHashOut = pathHash;
+
+    UINT32 nameOffset = HNamesGetNodeNameOffsetLarge(pNode);
+    UINT64 hash = pathHash;
+    int cchName;
+    RETURN_IF_FAILED(GetNodeNameLength(pNode, &cchName));
+
+    if ((pNode->flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
+    {
+        PCSTR pName;
+        RETURN_IF_FAILED(GetAsciiName(nameOffset, cchName, &pName));
+        for (int ch = 0; ch < cchName; ch++)
+        {
+            hash = HNamesHashChar(hash, static_cast<WCHAR>(pName[ch]));
+        }
+    }
+    else
+    {
+        PCWSTR pName;
+        RETURN_IF_FAILED(GetUtf16Name(nameOffset, cchName, &pName));
+        for (int ch = 0; ch < cchName; ch++)
+        {
+            hash = HNamesHashChar(hash, pName[ch]);
+        }
+    }
+
+    *pHashOut = hash;
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::EnablePathIndex() const
+{
+    if ((m_pPathIndex != nullptr) || (m_pHeader->numScopes == 0) || (m_pHeader->numNodes < 2))
+    {
+        return S_OK;
+    }
+
+    RETURN_HR_IF(E_OUTOFMEMORY, m_pHeader->numNodes > HNAMES_PATH_INDEX_MAX_NODES);
+
+    // Keep the table at most half full so probe sequences stay short
+    // and every miss ends at an empty slot.
+    UINT32 numSlots = 16;
+    while (numSlots < (static_cast<UINT32>(m_pHeader->numNodes) * 2))
+    {
+        numSlots *= 2;
+    }
+
+    PathIndex* pIndex = _DefAllocZeroed(PathIndex);
+    RETURN_IF_NULL_ALLOC(pIndex);
+
+    pIndex->slotMask = numSlots - 1;
+    pIndex->pEntries = _DefArray_AllocZeroed(PathIndex::Entry, numSlots);
+    if (pIndex->pEntries == nullptr)
+    {
+        _DefFree(pIndex);
+        return E_OUTOFMEMORY;
+    }
+
+    HRESULT hr = AddScopeToPathIndex(pIndex, 0, HNAMES_PATH_HASH_SEED, 0);
+    if (FAILED(hr) ||
+        (InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pPathIndex), pIndex, nullptr) != nullptr))
+    {
+        // Either the section is malformed or someone else got there first
+        _DefFree(pIndex->pEntries);
+        _DefFree(pIndex);
+    }
+    return (FAILED(hr) ? hr : S_OK);
+}
+
+HRESULT HierarchicalNames::AddScopeToPathIndex(
+    _Inout_ PathIndex* pIndex,
+    _In_ int scopeIndex,
+    _In_ UINT64 pathHash,
+    _In_ UINT32 currentDepth) const
+{
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scopeIndex < 0) || (scopeIndex > m_pHeader->numScopes - 1));
+
+    DEFFILE_HNAMES_SCOPE_LARGE scope =
+        (m_largeNode ? m_pScopesLarge[scopeIndex] : HNAMES_SCOPE_TO_HNAMES_SCOPE_LARGE(&m_pScopes[scopeIndex]));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scope.firstChildNameNode + scope.numChildNames) > m_pHeader->numNodes);
+
+    if (currentDepth > 0)
+    {
+        pathHash = HNamesHashChar(pathHash, GetDefaultPathSeparator());
+    }
+
+    for (int i = 0; i < scope.numChildNames; i++)
+    {
+        int nodeIndex = scope.firstChildNameNode + i;
+        DEFFILE_HNAMES_NODE_LARGE node = (m_largeNode ? m_pNodesLarge[nodeIndex] : HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[nodeIndex]));
+        UINT64 hash;
+        RETURN_IF_FAILED(HashNodeName(&node, pathHash, &hash));
+
+        // Each node is a child of exactly one scope, so a well-formed section
+        // can never fill the table.  Bound the probe anyway.
+        UINT32 slot = static_cast<UINT32>(hash) & pIndex->slotMask;
+        UINT32 numProbes = 0;
+        while (pIndex->pEntries[slot].nameIndexPlusOne != 0)
+        {
+            RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), ++numProbes > pIndex->slotMask);
+            slot = (slot + 1) & pIndex->slotMask;
+        }
+        pIndex->pEntries[slot].hashHigh = static_cast<UINT32>(hash >> 32);
+        pIndex->pEntries[slot].nameIndexPlusOne = static_cast<UINT32>(nodeIndex) + 1;
+
+        if ((node.flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NODE_IS_SCOPE) != 0)
+        {
+            RETURN_HR_IF(
+                HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+                (static_cast<int>(node.payload) == scopeIndex) || (currentDepth > m_pHeader->numScopes));
+            RETURN_IF_FAILED(AddScopeToPathIndex(pIndex, node.payload, hash, currentDepth + 1));
+        }
+    }
+    return S_OK;
+}
+
+_Success_(return == true)
+bool HierarchicalNames::TryFindIndexedPath(
+    _In_ const PathIndex* pIndex,
+    _In_ UINT64 hash,
+    _In_reads_(cchPath) PCWSTR pPath,
+    _In_ int cchPath,
+    _Out_ int* pNameIndexOut) const
+{
+    *pNameIndexOut = -1;
+
+    UINT32 hashHigh = static_cast<UINT32>(hash >> 32);
+    UINT32 slot = static_cast<UINT32>(hash) & pIndex->slotMask;
+    for (UINT32 numProbes = 0; numProbes <= pIndex->slotMask; numProbes++)
+    {
+        const PathIndex::Entry* pEntry = &pIndex->pEntries[slot];
+        if (pEntry->nameIndexPlusOne == 0)
+        {
+            return false;
+        }
+        if ((pEntry->hashHigh == hashHigh) && NodeMatchesPath(static_cast<int>(pEntry->nameIndexPlusOne - 1), pPath, cchPath))
+        {
+            *pNameIndexOut = static_cast<int>(pEntry->nameIndexPlusOne - 1);
+            return true;
+        }
+        slot = (slot + 1) & pIndex->slotMask;
+    }
+    return false;
+}
+
+// Checks a root-relative path against a node by comparing segments from the
+// end of the path while walking up through the node's parents, so no name
+// has to be built.
+bool HierarchicalNames::NodeMatchesPath(_In_ int nameIndex, _In_reads_(cchPath) PCWSTR pPath, _In_ int cchPath) const
+{
+    int cchRemaining = cchPath;
+    int numSteps = 0;
+
+    while (nameIndex > 0)
+    {
+        if ((nameIndex > m_pHeader->numNodes - 1) || (++numSteps > m_pHeader->numNodes))
+        {
+            return false;
+        }
+
+        DEFFILE_HNAMES_NODE_LARGE node = (m_largeNode ? m_pNodesLarge[nameIndex] : HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[nameIndex]));
+        if ((numSteps == 1) && (node.cchFullPath != cchPath))
+        {
+            return false;
+        }
+
+        int cchName;
+        if (FAILED(GetNodeNameLength(&node, &cchName)))
+        {
+            return false;
+        }
+
+        cchRemaining -= cchName;
+        if (cchRemaining < 0)
+        {
+            return false;
+        }
+
+        UINT32 nameOffset = HNamesGetNodeNameOffsetLarge(&node);
+        if ((node.flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) != 0)
+        {
+            PCSTR pName;
+            if (FAILED(GetAsciiName(nameOffset, cchName, &pName)))
+            {
+                return false;
+            }
+            for (int i = 0; i < cchName; i++)
+            {
+                if ((pName[i] != pPath[cchRemaining + i]) && (towupper(pName[i]) != towupper(pPath[cchRemaining + i])))
+                {
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            PCWSTR pName;
+            if (FAILED(GetUtf16Name(nameOffset, cchName, &pName)) ||
+                (CompareSegments(pName, cchName, &pPath[cchRemaining], cchName) != 0))
+            {
+                return false;
+            }
+        }
+
+        if (cchRemaining > 0)
+        {
+            if (!IsPathSeparator(pPath[--cchRemaining]))
+            {
+                return false;
+            }
+        }
+
+        nameIndex = node.parentNodeIndex;
+    }
+    return (cchRemaining == 0);
+}
+
+HRESULT HierarchicalNames::EnumerateNames(_In_ int relativeToScope, _In_ IHierarchicalNamesVisitor* pVisitor) const
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, pVisitor);
+    RETURN_HR_IF(E_INVALIDARG, (relativeToScope < 0) || (relativeToScope > m_pHeader->numScopes - 1));
+
+    PWSTR pPath;
+    int cchPath;
+    RETURN_IF_FAILED(AllocatePathBuffer(&pPath, &cchPath));
+
+    HRESULT hr = EnumerateScopeNames(relativeToScope, pPath, cchPath, 0, 0, pVisitor);
+    _DefFree(pPath);
+    return hr;
+}
+
+HRESULT HierarchicalNames::AllocatePathBuffer(_Outptr_result_buffer_(*pcchPath) PWSTR* ppPath, _Out_ int* pcchPath) const
+{
+    *ppPath = nullptr;
+    *pcchPath = 0;
+
+    // Relative names are never longer than the longest full path.  Don't
+    // trust the header alone for that, since walks write into the buffer.
+    int cchLongest = m_pHeader->cchLongestPath;
+    for (int i = 0; i < m_pHeader->numNodes; i++)
+    {
+        int cchFullPath = (m_largeNode ? m_pNodesLarge[i].cchFullPath : m_pNodes[i].cchFullPath);
+        cchLongest = max(cchLongest, cchFullPath);
+    }
+
+    int cchPath = cchLongest + 1;
+    PWSTR pPath = _DefArray_Alloc(WCHAR, cchPath);
+    RETURN_IF_NULL_ALLOC(pPath);
+    pPath[0] = L'\0';
+
+    *ppPath = pPath;
+    *pcchPath = cchPath;
+    return S_OK;
+}
+
+HRESULT HierarchicalNames::EnumerateScopeNames(
+    _In_ int scopeIndex,
+    _Inout_updates_(cchPath) PWSTR pPath,
+    _In_ int cchPath,
+    _In_ int cchPrefix,
+    _In_ UINT32 currentDepth,
+    _In_ IHierarchicalNamesVisitor* pVisitor) const
+{
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scopeIndex < 0) || (scopeIndex > m_pHeader->numScopes - 1));
+
+    DEFFILE_HNAMES_SCOPE_LARGE scope =
+        (m_largeNode ? m_pScopesLarge[scopeIndex] : HNAMES_SCOPE_TO_HNAMES_SCOPE_LARGE(&m_pScopes[scopeIndex]));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scope.firstChildNameNode + scope.numChildNames) > m_pHeader->numNodes);
+
+    // Children of the starting scope have no leading separator
+    int cchBase = cchPrefix;
+    if (currentDepth > 0)
+    {
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (cchBase + 1) >= cchPath);
+        pPath[cchBase++] = GetDefaultPathSeparator();
+    }
+
+    for (int i = 0; i < scope.numChildNames; i++)
+    {
+        int nodeIndex = scope.firstChildNameNode + i;
+        DEFFILE_HNAMES_NODE_LARGE node = (m_largeNode ? m_pNodesLarge[nodeIndex] : HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[nodeIndex]));
+
+        // Push this segment.  Siblings overwrite it in place, which pops it.
+        int cchSegment;
+        RETURN_IF_FAILED(GetNodeNameLength(&node, &cchSegment));
+        int cchName = cchBase + cchSegment;
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), cchName >= cchPath);
+        RETURN_IF_FAILED(CopyNameSegment(node.flagsAndNameOffsetHigh, HNamesGetNodeNameOffsetLarge(&node), cchSegment, &pPath[cchBase]));
+        pPath[cchName] = L'\0';
+
+        HRESULT hr;
+        bool isScope = ((node.flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NODE_IS_SCOPE) != 0);
+        if (isScope)
+        {
+            hr = pVisitor->VisitScope(node.payload, pPath, cchName);
+        }
+        else
+        {
+            hr = pVisitor->VisitItem(node.payload, pPath, cchName);
+        }
+        RETURN_IF_FAILED(hr);
+        if (hr == S_FALSE)
+        {
+            return S_FALSE;
+        }
+
+        if (isScope)
+        {
+            RETURN_HR_IF(
+                HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+                (static_cast<int>(node.payload) == scopeIndex) || (currentDepth > m_pHeader->numScopes));
+            hr = EnumerateScopeNames(node.payload, pPath, cchPath, cchName, currentDepth + 1, pVisitor);
+            RETURN_IF_FAILED(hr);
+            if (hr == S_FALSE)
+            {
+                return S_FALSE;
+            }
+        }
+    }
+    return S_OK;
+}
+
+#define HNAMES_PATTERN_MAX_SEGMENTS 63
+
+// A name pattern split into segments.  Matching tracks the set of segment
+// positions that are still live as a bit mask; bit numSegments means the
+// whole pattern has been consumed.
+struct HierarchicalNames::NamePattern
+{
+    struct Segment
+    {
+        PCWSTR pChars; // not null terminated
+        int cchChars;
+        bool isAnySegments; // "**"
+        bool hasWildcards;
+    };
+
+    int numSegments;
+    Segment segments[HNAMES_PATTERN_MAX_SEGMENTS];
+
+    // Adds the positions reachable by letting "**" segments match nothing.
+    UINT64 GetClosure(_In_ UINT64 states) const
+    {
+        for (int i = 0; i < numSegments; i++)
+        {
+            if (((states & (1ull << i)) != 0) && segments[i].isAnySegments)
+            {
+                states |= (1ull << (i + 1));
+            }
+        }
+        return states;
+    }
+};
+
+static inline WCHAR HNamesFoldChar(_In_ WCHAR ch)
+{
+    return ((ch >= L'a') && (ch <= L'z')) ? static_cast<WCHAR>(ch - (L'a' - L'A')) : ((ch < 0x80) ? ch : towupper(ch));
+}
+
+// Matches a single segment against '*' and '?' wildcards, backtracking to
+// the most recent '*' on a mismatch.
+static bool HNamesMatchGlobSegment(
+    _In_reads_(cchPattern) PCWSTR pPattern,
+    _In_ int cchPattern,
+    _In_reads_(cchName) PCWSTR pName,
+    _In_ int cchName)
+{
+    int p = 0;
+    int n = 0;
+    int star = -1;
+    int starMatch = 0;
+
+    while (n < cchName)
+    {
+        if ((p < cchPattern) && ((pPattern[p] == L'?') || (HNamesFoldChar(pPattern[p]) == HNamesFoldChar(pName[n]))))
+        {
+            p++;
+            n++;
+        }
+        else if ((p < cchPattern) && (pPattern[p] == L'*'))
+        {
+            star = p++;
+            starMatch = n;
+        }
+        else if (star >= 0)
+        {
+            p = star + 1;
+            n = ++starMatch;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while ((p < cchPattern) && (pPattern[p] == L'*'))
+    {
+        p++;
+    }
+    return (p == cchPattern);
+}
+
+HRESULT HierarchicalNames::FindNames(_In_ int relativeToScope, _In_ PCWSTR pPattern, _In_ IHierarchicalNamesVisitor* pVisitor) const
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, pVisitor);
+    RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pPattern));
+    RETURN_HR_IF(E_INVALIDARG, (relativeToScope < 0) || (relativeToScope > m_pHeader->numScopes - 1));
 
-    m_pScopeNames = NULL;
-    m_pItemNames = NULL;
+    NamePattern pattern;
+    pattern.numSegments = 0;
+
+    // ignore leading separator, if present
+    PCWSTR pStr = (IsPathSeparator(pPattern[0]) ? &pPattern[1] : pPattern);
+    while (*pStr != L'\0')
+    {
+        RETURN_HR_IF(E_INVALIDARG, pattern.numSegments >= HNAMES_PATTERN_MAX_SEGMENTS);
+
+        NamePattern::Segment* pSegment = &pattern.segments[pattern.numSegments++];
+        pSegment->pChars = pStr;
+        pSegment->cchChars = 0;
+        pSegment->hasWildcards = false;
+        while ((pStr[pSegment->cchChars] != L'\0') && !IsPathSeparator(pStr[pSegment->cchChars]))
+        {
+            WCHAR ch = pStr[pSegment->cchChars++];
+            pSegment->hasWildcards |= ((ch == L'*') || (ch == L'?'));
+        }
+
+        // multiple separators not allowed
+        RETURN_HR_IF(E_INVALIDARG, pSegment->cchChars == 0);
+        pSegment->isAnySegments = ((pSegment->cchChars == 2) && (pStr[0] == L'*') && (pStr[1] == L'*'));
+
+        pStr += pSegment->cchChars;
+        if (*pStr != L'\0')
+        {
+            pStr++;
+            if (*pStr == L'\0')
+            {
+                // A trailing separator asks for everything below the scope
+                RETURN_HR_IF(E_INVALIDARG, pattern.numSegments >= HNAMES_PATTERN_MAX_SEGMENTS);
+                NamePattern::Segment* pAny = &pattern.segments[pattern.numSegments++];
+                pAny->pChars = L"**";
+                pAny->cchChars = 2;
+                pAny->isAnySegments = true;
+                pAny->hasWildcards = true;
+            }
+        }
+    }
+    RETURN_HR_IF(E_INVALIDARG, pattern.numSegments == 0);
+
+    PWSTR pPath;
+    int cchPath;
+    RETURN_IF_FAILED(AllocatePathBuffer(&pPath, &cchPath));
+
+    HRESULT hr = FindScopeNames(&pattern, relativeToScope, 1, pPath, cchPath, 0, 0, pVisitor);
+    _DefFree(pPath);
+    return hr;
+}
+
+HRESULT HierarchicalNames::FindScopeNames(
+    _In_ const NamePattern* pPattern,
+    _In_ int scopeIndex,
+    _In_ UINT64 states,
+    _Inout_updates_(cchPath) PWSTR pPath,
+    _In_ int cchPath,
+    _In_ int cchPrefix,
+    _In_ UINT32 currentDepth,
+    _In_ IHierarchicalNamesVisitor* pVisitor) const
+{
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scopeIndex < 0) || (scopeIndex > m_pHeader->numScopes - 1));
+
+    const UINT64 doneState = (1ull << pPattern->numSegments);
+    UINT64 liveStates = (pPattern->GetClosure(states) & ~doneState);
+    if (liveStates == 0)
+    {
+        return S_OK;
+    }
+
+    DEFFILE_HNAMES_SCOPE_LARGE scope =
+        (m_largeNode ? m_pScopesLarge[scopeIndex] : HNAMES_SCOPE_TO_HNAMES_SCOPE_LARGE(&m_pScopes[scopeIndex]));
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (scope.firstChildNameNode + scope.numChildNames) > m_pHeader->numNodes);
+
+    int cchBase = cchPrefix;
+    if (currentDepth > 0)
+    {
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), (cchBase + 1) >= cchPath);
+        pPath[cchBase++] = GetDefaultPathSeparator();
+    }
+
+    int firstChild = 0;
+    int lastChild = scope.numChildNames - 1;
+
+    // When the only live position is a plain name, binary search for it
+    // instead of looking at every child.
+    int onlyState = -1;
+    if ((liveStates & (liveStates - 1)) == 0)
+    {
+        for (onlyState = 0; (liveStates & (1ull << onlyState)) == 0; onlyState++)
+        {
+        }
+
+        const NamePattern::Segment* pSegment = &pPattern->segments[onlyState];
+        WCHAR firstChildChar = 0;
+        if (scope.numChildNames > 0)
+        {
+            firstChildChar =
+                (m_largeNode ? m_pNodesLarge[scope.firstChildNameNode].initialChar : m_pNodes[scope.firstChildNameNode].initialChar);
+        }
+
+        if (!pSegment->hasWildcards && (firstChildChar != 0))
+        {
+            int match =
+                (m_largeNode ?
+                     FindChildNode<DEFFILE_HNAMES_NODE_LARGE>(
+                         &m_pNodesLarge[scope.firstChildNameNode], scope.numChildNames, pSegment->pChars, pSegment->cchChars) :
+                     FindChildNode<DEFFILE_HNAMES_NODE>(
+                         &m_pNodes[scope.firstChildNameNode], scope.numChildNames, pSegment->pChars, pSegment->cchChars));
+            if (match < 0)
+            {
+                return S_OK;
+            }
+            firstChild = lastChild = match;
+        }
+    }
+
+    for (int i = firstChild; i <= lastChild; i++)
+    {
+        int nodeIndex = scope.firstChildNameNode + i;
+        DEFFILE_HNAMES_NODE_LARGE node = (m_largeNode ? m_pNodesLarge[nodeIndex] : HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[nodeIndex]));
+
+        int cchSegment;
+        RETURN_IF_FAILED(GetNodeNameLength(&node, &cchSegment));
+        int cchName = cchBase + cchSegment;
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), cchName >= cchPath);
+        RETURN_IF_FAILED(CopyNameSegment(node.flagsAndNameOffsetHigh, HNamesGetNodeNameOffsetLarge(&node), cchSegment, &pPath[cchBase]));
+        pPath[cchName] = L'\0';
+
+        UINT64 nextStates = 0;
+        for (int pos = 0; pos < pPattern->numSegments; pos++)
+        {
+            if ((liveStates & (1ull << pos)) == 0)
+            {
+                continue;
+            }
+
+            const NamePattern::Segment* pSegment = &pPattern->segments[pos];
+            if (pSegment->isAnySegments)
+            {
+                // "**" consumes this segment and stays put
+                nextStates |= (1ull << pos);
+            }
+            else if (pSegment->hasWildcards ?
+                         HNamesMatchGlobSegment(pSegment->pChars, pSegment->cchChars, &pPath[cchBase], cchSegment) :
+                         (CompareSegments(&pPath[cchBase], cchSegment, pSegment->pChars, pSegment->cchChars) == 0))
+            {
+                nextStates |= (1ull << (pos + 1));
+            }
+        }
+
+        if (nextStates == 0)
+        {
+            continue;
+        }
+
+        HRESULT hr = S_OK;
+        bool isScope = ((node.flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NODE_IS_SCOPE) != 0);
+        UINT64 reachable = pPattern->GetClosure(nextStates);
+        if ((reachable & doneState) != 0)
+        {
+            hr = (isScope ? pVisitor->VisitScope(node.payload, pPath, cchName) : pVisitor->VisitItem(node.payload, pPath, cchName));
+            RETURN_IF_FAILED(hr);
+            if (hr == S_FALSE)
+            {
+                return S_FALSE;
+            }
+        }
+
+        if (isScope && ((reachable & ~doneState) != 0))
+        {
+            RETURN_HR_IF(
+                HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE),
+                (static_cast<int>(node.payload) == scopeIndex) || (currentDepth > m_pHeader->numScopes));
+            hr = FindScopeNames(pPattern, node.payload, nextStates, pPath, cchPath, cchName, currentDepth + 1, pVisitor);
+            RETURN_IF_FAILED(hr);
+            if (hr == S_FALSE)
+            {
+                return S_FALSE;
+            }
+        }
+    }
+    return S_OK;
+}
+
+bool HierarchicalNames::TryGetNodePayload(_In_ int nameIndex, _Out_ int* pScopeIndexOut, _Out_ int* pItemIndexOut) const
+{
+    *pScopeIndexOut = -1;
+    *pItemIndexOut = -1;
+
+    if ((nameIndex < 0) || (nameIndex > m_pHeader->numNodes - 1))
+    {
+        return false;
+    }
+
+    DEFFILE_HNAMES_NODE_LARGE node = (m_largeNode ? m_pNodesLarge[nameIndex] : HNAMES_NODE_TO_HNAMES_NODE_LARGE(&m_pNodes[nameIndex]));
+    if ((node.flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NODE_IS_SCOPE) != 0)
+    {
+        *pScopeIndexOut = node.payload;
+    }
+    else
+    {
+        *pItemIndexOut = node.payload;
+    }
+    return true;
 }
 
 _Success_(return ) bool HierarchicalNames::TryGetName(
@@ -692,6 +1591,142 @@ bool HierarchicalNames::Contains(
     __out_opt int* pScopeIndexOut,
     __out_opt int* pItemIndexOut,
     __out_opt int* pNameIndexOut) const
+{
+    PathIndex* pIndex = m_pPathIndex;
+    LookupCache* pCache = m_pLookupCache;
+    UINT64 hash;
+    bool isAscii;
+    PCWSTR pTrimmedPath;
+    int cchTrimmedPath;
+
+    // Absolute paths resolve directly through the path index when there is one.
+    // Non-ASCII misses still walk the tree, since towupper folding might not
+    // agree exactly with CompareStringOrdinal.
+    if ((pIndex != nullptr) && (relativeToScope == 0) && !DefString_IsEmpty(pPath) &&
+        HNamesTryHashLookupPath(this, pPath, &hash, &isAscii, &pTrimmedPath, &cchTrimmedPath))
+    {
+        int nameIndex;
+        int scopeIndex = -1;
+        int itemIndex = -1;
+        bool found = TryFindIndexedPath(pIndex, hash, pTrimmedPath, cchTrimmedPath, &nameIndex) &&
+                     TryGetNodePayload(nameIndex, &scopeIndex, &itemIndex);
+
+        if (found || isAscii)
+        {
+            if (pScopeIndexOut != nullptr)
+            {
+                *pScopeIndexOut = scopeIndex;
+            }
+            if (pItemIndexOut != nullptr)
+            {
+                *pItemIndexOut = itemIndex;
+            }
+            if (pNameIndexOut != nullptr)
+            {
+                *pNameIndexOut = (found ? nameIndex : -1);
+            }
+            return found;
+        }
+    }
+
+    if ((pCache == nullptr) || DefString_IsEmpty(pPath) || !HNamesTryHashLookupPath(this, pPath, &hash, &isAscii))
+    {
+        return LookupName(pPath, relativeToScope, pScopeIndexOut, pItemIndexOut, pNameIndexOut);
+    }
+
+    // Only absolute paths are in the filter, and non-ASCII folding might not
+    // agree exactly with CompareStringOrdinal, so only trust it for ASCII.
+    if ((relativeToScope == 0) && isAscii && (pCache->pFilterBits != nullptr) &&
+        !HNamesFilterMayContain(pCache->pFilterBits, pCache->filterBitMask, hash))
+    {
+        if (pScopeIndexOut != nullptr)
+        {
+            *pScopeIndexOut = -1;
+        }
+        if (pItemIndexOut != nullptr)
+        {
+            *pItemIndexOut = -1;
+        }
+        if (pNameIndexOut != nullptr)
+        {
+            *pNameIndexOut = -1;
+        }
+        return false;
+    }
+
+    LookupCache::Entry* pEntry = &pCache->pEntries[hash & pCache->entryMask];
+    int nameIndex = -1;
+
+    _DefAcquireSRWLockShared(&pCache->lock);
+    if ((pEntry->pPath != nullptr) && (pEntry->hash == hash) && (pEntry->relativeToScope == relativeToScope) &&
+        (DefString_ICompare(pEntry->pPath, pPath) == Def_Equal))
+    {
+        nameIndex = pEntry->nameIndex;
+    }
+    _DefReleaseSRWLockShared(&pCache->lock);
+
+    int scopeIndex, itemIndex;
+    if ((nameIndex >= 0) && TryGetNodePayload(nameIndex, &scopeIndex, &itemIndex))
+    {
+        if (pScopeIndexOut != nullptr)
+        {
+            *pScopeIndexOut = scopeIndex;
+        }
+        if (pItemIndexOut != nullptr)
+        {
+            *pItemIndexOut = itemIndex;
+        }
+        if (pNameIndexOut != nullptr)
+        {
+            *pNameIndexOut = nameIndex;
+        }
+        return true;
+    }
+
+    if (!LookupName(pPath, relativeToScope, pScopeIndexOut, pItemIndexOut, &nameIndex))
+    {
+        if (pNameIndexOut != nullptr)
+        {
+            *pNameIndexOut = -1;
+        }
+        return false;
+    }
+
+    if (pNameIndexOut != nullptr)
+    {
+        *pNameIndexOut = nameIndex;
+    }
+
+    // Caching is best effort, so failures are ignored.
+    size_t cchPath = wcslen(pPath) + 1;
+    PWSTR pKey = _DefArray_Alloc(WCHAR, cchPath);
+    if (pKey != nullptr)
+    {
+        memcpy(pKey, pPath, cchPath * sizeof(WCHAR));
+
+        _DefAcquireSRWLockExclusive(&pCache->lock);
+        PWSTR pOldKey = pEntry->pPath;
+        pEntry->hash = hash;
+        pEntry->relativeToScope = relativeToScope;
+        pEntry->nameIndex = nameIndex;
+        pEntry->pPath = pKey;
+        _DefReleaseSRWLockExclusive(&pCache->lock);
+
+        if (pOldKey != nullptr)
+        {
+            _DefFree(pOldKey);
+        }
+    }
+    return true;
+}
+
+_Success_(return == true)
+bool HierarchicalNames::LookupName(
+    __in PCWSTR pPath,
+    __in int relativeToScope,
+    __out_opt int* pScopeIndexOut,
+    __out_opt int* pItemIndexOut,
+    __out_opt int* pNameIndexOut) const
 {
     if (m_pHeader->numNodes == 0 || m_pHeader->numScopes == 0)
     {
@@ -784,52 +1819,73 @@ bool HierarchicalNames::Contains(
         pSegmentEnd = nullptr;
         initialChar = towupper(pStr[0]);
 
-        for (int i = 0; (i < numChildren); i++)
+        int cchSegment = 0;
+        while ((pStr[cchSegment] != L'\0') && !IsPathSeparator(pStr[cchSegment]))
+        {
+            cchSegment++;
+        }
+
+        int matchIndex = -1;
+        WCHAR firstChildChar = ((numChildren > 0) ? (m_largeNode ? pChildrenLarge[0].initialChar : pChildren[0].initialChar) : 0);
+        if (firstChildChar != 0)
+        {
+            // Children are sorted, so we can binary search them
+            matchIndex = (m_largeNode ? FindChildNode<DEFFILE_HNAMES_NODE_LARGE>(pChildrenLarge, numChildren, pStr, cchSegment) :
+                                        FindChildNode<DEFFILE_HNAMES_NODE>(pChildren, numChildren, pStr, cchSegment));
+        }
+        else
         {
-            WCHAR initChildChar = (m_largeNode ? pChildrenLarge[i].initialChar : pChildren[i].initialChar);
-            // WORKING HERE - NEED TO HANDLE ASCII IN COMPARISON
-            if ((initChildChar == initialChar) || (initChildChar == 0))
+            // No initial characters recorded; fall back to a linear scan
+            for (int i = 0; (i < numChildren); i++)
             {
-                int diff;
-                if (m_largeNode)
+                WCHAR initChildChar = (m_largeNode ? pChildrenLarge[i].initialChar : pChildren[i].initialChar);
+                if ((initChildChar == initialChar) || (initChildChar == 0))
                 {
-                    if (FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE_LARGE>(&pChildrenLarge[i], pStr, &diff)) || (diff > 0))
+                    int diff;
+                    if (m_largeNode)
                     {
-                        // we've either hit an error
-                        // or passed the last possiblse match.
-                        return false;
+                        if (FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE_LARGE>(&pChildrenLarge[i], pStr, &diff)) || (diff > 0))
+                        {
+                            // we've either hit an error
+                            // or passed the last possiblse match.
+                            return false;
+                        }
                     }
-                }
-                else
-                {
-                    if (FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE>(&pChildren[i], pStr, &diff)) || (diff > 0))
+                    else
                     {
-                        // we've either hit an error
-                        // or passed the last possiblse match.
-                        return false;
+                        if (FAILED(CompareNameSegment<DEFFILE_HNAMES_NODE>(&pChildren[i], pStr, &diff)) || (diff > 0))
+                        {
+                            // we've either hit an error
+                            // or passed the last possiblse match.
+                            return false;
+                        }
                     }
-                }
 
-                if (diff == 0)
-                {
-                    if (m_largeNode)
-                    {
-                        pMatch = &pChildrenLarge[i];
-                        pSegmentEnd = &pStr[pChildrenLarge[i].cchName];
-                        nameIndex = static_cast<int>(&pChildrenLarge[i] - m_pNodesLarge);
-                    }
-                    else
+                    if (diff == 0)
                     {
-                        matchNode = HNAMES_NODE_TO_HNAMES_NODE_LARGE(&pChildren[i]);
-                        pMatch = &matchNode;
-                        pSegmentEnd = &pStr[pChildren[i].cchName];
-                        nameIndex = static_cast<int>(&pChildren[i] - m_pNodes);
+                        matchIndex = i;
+                        break;
                     }
-                    break;
                 }
             }
         }
 
+        if (matchIndex >= 0)
+        {
+            if (m_largeNode)
+            {
+                pMatch = &pChildrenLarge[matchIndex];
+                nameIndex = static_cast<int>(&pChildrenLarge[matchIndex] - m_pNodesLarge);
+            }
+            else
+            {
+                matchNode = HNAMES_NODE_TO_HNAMES_NODE_LARGE(&pChildren[matchIndex]);
+                pMatch = &matchNode;
+                nameIndex = static_cast<int>(&pChildren[matchIndex] - m_pNodes);
+            }
+            pSegmentEnd = &pStr[cchSegment];
+        }
+
         if (pMatch == nullptr)
         {
             // no match found
@@ -1260,6 +2316,99 @@ HRESULT HierarchicalNames::CompareNameSegment(_In_ const T* pNode, _In_ PCWSTR p
     return S_OK;
 }
 
+template<typename T>
+HRESULT HierarchicalNames::CompareChildSegment(
+    _In_ const T* pNode,
+    _In_reads_(cchSegment) PCWSTR pSegment,
+    _In_ int cchSegment,
+    _Out_ int* result) const
+{
+    *result = -1;
+
+    WCHAR initialChar = towupper(pSegment[0]);
+    if (pNode->initialChar != initialChar)
+    {
+        *result = ((pNode->initialChar > initialChar) ? 1 : -1);
+        return S_OK;
+    }
+
+    UINT32 nameOffset = GetNodeNameOffset(pNode);
+    int cchName = pNode->cchName;
+
+    if ((pNode->flagsAndNameOffsetHigh & DEFFILE_HNAMES_FLAGS_NAME_IS_ASCII) == 0)
+    {
+        if ((nameOffset + cchName) >= m_pHeader->cchUtf16NamesPool)
+        {
+            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+        }
+
+        PCWSTR pName = &m_pUtf16Names[nameOffset];
+        if (cchName == 0)
+        {
+            // Names of 256 characters or more don't record their length
+            cchName = static_cast<int>(wcsnlen(pName, m_pHeader->cchUtf16NamesPool - nameOffset));
+        }
+        *result = CompareSegments(pName, cchName, pSegment, cchSegment);
+    }
+    else
+    {
+        if ((nameOffset + cchName) >= m_pHeader->cchAsciiNamesPool)
+        {
+            return HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE);
+        }
+
+        PCSTR pName = &m_pAsciiNames[nameOffset];
+        if (cchName == 0)
+        {
+            cchName = static_cast<int>(strnlen(pName, m_pHeader->cchAsciiNamesPool - nameOffset));
+        }
+
+        int diff = 0;
+        for (int i = 0; (i < cchName) && (i < cchSegment) && (diff == 0); i++)
+        {
+            diff = towupper(pName[i]) - towupper(pSegment[i]);
+        }
+        *result = ((diff != 0) ? diff : (cchName - cchSegment));
+    }
+
+    return S_OK;
+}
+
+template<typename T>
+int HierarchicalNames::FindChildNode(
+    _In_reads_(numChildren) const T* pChildren,
+    _In_ int numChildren,
+    _In_reads_(cchSegment) PCWSTR pSegment,
+    _In_ int cchSegment) const
+{
+    int low = 0;
+    int high = numChildren - 1;
+
+    while (low <= high)
+    {
+        int mid = low + ((high - low) / 2);
+        int diff;
+        if (FAILED(CompareChildSegment<T>(&pChildren[mid], pSegment, cchSegment, &diff)))
+        {
+            return -1;
+        }
+
+        if (diff == 0)
+        {
+            return mid;
+        }
+        else if (diff < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    return -1;
+}
+
 HRESULT
 HierarchicalNames::GetNumDescendents(_In_ int scopeIndex, _In_ UINT32 currentDepth, _Out_opt_ int* pNumScopes, _Out_opt_ int* pNumItems)
     const
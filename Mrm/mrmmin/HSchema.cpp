@@ -252,6 +252,8 @@ HRESULT
 ComputeHierarchicalSchemaVersionChecksum(
     _In_ const IHierarchicalSchema* pSchema,
     _In_ const IHierarchicalSchemaVersionInfo* pVersion,
+    _Inout_opt_ DefChecksum::AtomPoolStringsChecksum* pScopeNamesState,
+    _Inout_opt_ DefChecksum::AtomPoolStringsChecksum* pItemNamesState,
     _Out_ DefChecksum::Checksum* pChecksumOut)
 {
     RETURN_HR_IF(E_INVALIDARG, (pSchema == nullptr) || (pVersion == nullptr) || (pChecksumOut == nullptr));
@@ -271,13 +273,32 @@ ComputeHierarchicalSchemaVersionChecksum(
     RETURN_IF_FAILED(DefChecksum::ComputeStringChecksum(0, true, pSchema->GetUniqueId(), &crc));
     RETURN_IF_FAILED(DefChecksum::ComputeStringChecksum(crc, true, pSchema->GetSimpleId(), &crc));
     crc = DefChecksum::ComputeUInt32Checksum(crc, v.ui32);
-    RETURN_IF_FAILED(DefChecksum::ComputeAtomPoolChecksum(crc, pSchema->GetScopeNames(), pVersion->GetNumScopes(), &crc));
-    RETURN_IF_FAILED(DefChecksum::ComputeAtomPoolChecksum(crc, pSchema->GetItemNames(), pVersion->GetNumItems(), &crc));
+    if ((pScopeNamesState != nullptr) && (pItemNamesState != nullptr))
+    {
+        RETURN_IF_FAILED(
+            DefChecksum::ComputeAtomPoolChecksum(crc, pSchema->GetScopeNames(), pVersion->GetNumScopes(), pScopeNamesState, &crc));
+        RETURN_IF_FAILED(
+            DefChecksum::ComputeAtomPoolChecksum(crc, pSchema->GetItemNames(), pVersion->GetNumItems(), pItemNamesState, &crc));
+    }
+    else
+    {
+        RETURN_IF_FAILED(DefChecksum::ComputeAtomPoolChecksum(crc, pSchema->GetScopeNames(), pVersion->GetNumScopes(), &crc));
+        RETURN_IF_FAILED(DefChecksum::ComputeAtomPoolChecksum(crc, pSchema->GetItemNames(), pVersion->GetNumItems(), &crc));
+    }
 
     *pChecksumOut = crc;
     return S_OK;
 }
 
+HRESULT
+ComputeHierarchicalSchemaVersionChecksum(
+    _In_ const IHierarchicalSchema* pSchema,
+    _In_ const IHierarchicalSchemaVersionInfo* pVersion,
+    _Out_ DefChecksum::Checksum* pChecksumOut)
+{
+    return ComputeHierarchicalSchemaVersionChecksum(pSchema, pVersion, nullptr, nullptr, pChecksumOut);
+}
+
 bool CheckHierarchicalSchemaVersionIsIdentical(
     _In_opt_ const IHierarchicalSchemaVersionInfo* pVersion1,
     _In_opt_ const IHierarchicalSchemaVersionInfo* pVersion2)
@@ -322,6 +343,32 @@ bool CheckHierarchicalSchemaVersionIsCompatible(
         SUCCEEDED(ComputeHierarchicalSchemaVersionChecksum(pHaveSchema, pWantVersion, &cs)) && (cs == pWantVersion->GetVersionChecksum()));
 }
 
+HRESULT IHierarchicalSchema::EnumerateNames(_In_ IHierarchicalNamesVisitor* pVisitor) const
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, pVisitor);
+
+    StringResult name;
+    HRESULT hr = S_OK;
+
+    // Scope 0 is the unnamed root, which a depth-first walk doesn't report either
+    for (int i = 1; (i < GetNumScopes()) && (hr == S_OK); i++)
+    {
+        if (TryGetScopeInfo(i, &name) && !DefString_IsEmpty(name.GetRef()))
+        {
+            hr = pVisitor->VisitScope(i, name.GetRef(), static_cast<int>(wcslen(name.GetRef())));
+        }
+    }
+
+    for (int i = 0; (i < GetNumItems()) && (hr == S_OK); i++)
+    {
+        if (TryGetItemInfo(i, &name))
+        {
+            hr = pVisitor->VisitItem(i, name.GetRef(), static_cast<int>(wcslen(name.GetRef())));
+        }
+    }
+    return hr;
+}
+
 HierarchicalSchema::HierarchicalSchema() :
     m_pUniqueId(nullptr), m_pSimpleId(nullptr), m_pVersions(nullptr), m_pNames(nullptr), m_pMyBuffer(nullptr)
 {
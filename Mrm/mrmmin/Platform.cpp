@@ -908,40 +908,15 @@ extern "C"
         return DOSDEVICE_DRIVE_FIXED;
     }
 
-    BOOLEAN _DefIsWellFormedTag(_In_ PCWSTR tag)
-    {
-        if (tag == nullptr || *tag == L'\0')
-        {
-            return FALSE;
-        }
-
-        BOOLEAN ok = TRUE;
-        PCWSTR test = tag;
-
-        while (ok && (*test != L'\0'))
-        {
-            // we accept letters, numbers, dash and semi-colon (as list separator)
-            if (((*test >= L'0') && (*test <= L'9')) || ((*test >= L'a') && (*test <= L'z')) || ((*test >= L'A') && (*test <= L'Z')) ||
-                (*test == L'-') || (*test == L';'))
-            {
-                test++;
-            }
-            else
-            {
-                ok = FALSE;
-            }
-        }
-
-        return ok && ((test - tag) >= 2);
-    }
+    BOOLEAN _DefIsWellFormedTag(_In_ PCWSTR tag) { return _DefIsWellFormedLanguageTag(tag); }
 
-    HRESULT _DefGetDistanceOfClosestLanguageInList(
+    static HRESULT DefGetPlatformDistanceOfClosestLanguageInList(
         _In_ PCWSTR /* language */,
         _In_ PCWSTR /* languagesList */,
         _In_ wchar_t /* listDelimiter */,
         _Out_ double* closestDistance)
     {
-        // Not implemented. Let caller handle
+        // No platform implementation, _DefGetDistanceOfClosestLanguageInList uses the portable one.
         *closestDistance = -1.0;
 
         return S_OK;
@@ -1116,134 +1091,6 @@ extern "C"
         return rtrn;
     }
 
-    /*
-     * CRC-32 implementation (from RTL)
-     */
-
-    //
-    // This is the precomputed data table for the CRC32 algorithm as specified
-    // in IS0 3309. See RFC-1662 and RFC-1952 for implementation details and
-    // references.
-    //
-    // To calculate this table, use the following function:
-    //
-    //  VOID
-    //  PrintCrcTable(
-    //      )
-    //  {
-    //    ULONG32 Val;
-    //    ULONG i, k;
-    //
-    //      for (i = 0; i < 256; i++) {
-    //         Val = (ULONG) i;
-    //          for (k = 0; k < 8; k++) {
-    //              if (Val & 1) {
-    //                  Val = 0xedb88320L ^ (Val >> 1);
-    //              } else {
-    //                  Val = Val >> 1;
-    //              }
-    //          }
-    //
-    //          printf ("0x%08x, ", Val);
-    //
-    //          if ( (i+1) % 6 == 0) {
-    //              printf ("\n");
-    //          }
-    //      }
-    //  }
-    //
-    //
-
-    const UINT32 gCrc32Table[] = {
-        0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e,
-        0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb,
-        0xf4d4b551, 0x83d385c7, 0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9, 0xfa0f3d63, 0x8d080df5, 0x3b6e20c8,
-        0x4c69105e, 0xd56041e4, 0xa2677172, 0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940,
-        0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59, 0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423, 0xcfba9599,
-        0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924, 0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
-        0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433, 0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb,
-        0x086d3d2d, 0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e, 0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457,
-        0x65b0d9c6, 0x12b7e950, 0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65, 0x4db26158, 0x3ab551ce, 0xa3bc0074,
-        0xd4bb30e2, 0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0, 0x44042d73, 0x33031de5,
-        0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa, 0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f, 0x5edef90e,
-        0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-        0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27,
-        0x7d079eb1, 0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb, 0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0,
-        0x10da7a5a, 0x67dd4acc, 0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252, 0xd1bb67f1,
-        0xa6bc5767, 0x3fb506dd, 0x48b2364b, 0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55, 0x316e8eef, 0x4669be79,
-        0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236, 0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28, 0x2bb45a92,
-        0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d, 0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-        0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38, 0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4,
-        0xf1d4e242, 0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777, 0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c,
-        0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2, 0xa7672661, 0xd06016f7, 0x4969474d,
-        0x3e6e77db, 0xaed16a4a, 0xd9d65adc, 0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9, 0xbdbdf21c, 0xcabac28a,
-        0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37,
-        0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d};
-
-    /*
- * Compute the CRC32 as specified in in IS0 3309. See RFC-1662 and RFC-1952
- * for implementation details and references.
- * Pre- and post-conditioning (one's complement) is done by this function, so
- * it should not be done by the caller. That is, do:
- *
- *     Crc = _DefComputeCrc32 ( 0, buffer, length );
- * instead of
- *
- *     Crc = _DefComputeCrc32 ( 0xffffffff, buffer, length );
- * or
- *     Crc = _DefComputeCrc32 ( 0xffffffff, buffer, length) ^ 0xffffffff;
- *
- * Arguments:
- * 
- *    PartialCrc - A partially calculated CRC32.
- *
- *    Buffer - The buffer you want to CRC.
- *
- *    Length - The length of the buffer in bytes.
- *
- * Return Value:
- *    The updated CRC32 value.
- *
- */
-
-    UINT32
-    _DefComputeCrc32(__in UINT32 partialCrc, __in_bcount(cbBuf) const BYTE* pBuf, __in UINT32 cbBuf)
-    {
-        UINT32 crc;
-        UINT32 i;
-
-        //
-        // Compute the CRC32 checksum.
-        //
-
-        crc = partialCrc ^ 0xffffffffL;
-
-        for (i = 0; i < cbBuf; i++)
-        {
-            crc = gCrc32Table[(crc ^ pBuf[i]) & 0xff] ^ (crc >> 8);
-        }
-
-        return (crc ^ 0xffffffffL);
-    }
-
-    UINT32
-    _DefComputeStringCrc32(__in UINT32 partialCrc, __in BOOLEAN isCaseInsensitive, __in_ecount(cchStr) PCWSTR pStr, __in UINT32 cchStr)
-    {
-        UINT32 crc;
-        UINT32 i;
-
-        crc = partialCrc ^ 0xffffffffL;
-
-        for (i = 0; i < cchStr; i++)
-        {
-            WCHAR ch = (isCaseInsensitive ? towlower(pStr[i]) : pStr[i]);
-            crc = gCrc32Table[(crc ^ (ch & 0xff)) & 0xff] ^ (crc >> 8);
-            crc = gCrc32Table[(crc ^ ((ch >> 8) & 0xff)) & 0xff] ^ (crc >> 8);
-        }
-
-        return (crc ^ 0xffffffffL);
-    }
-
     UINT _DefGetDriveTypeW(_In_opt_ PCWSTR rootPathName) { return GetDriveTypeW(rootPathName); }
 
 #include <stdbool.h>
@@ -1298,8 +1145,8 @@ extern "C"
 
         if (g_bcp47 == nullptr)
         {
-            // Didn't find an implementation. Just return TRUE.
-            return TRUE;
+            // Didn't find an implementation, use the portable one.
+            return _DefIsWellFormedLanguageTag(tag);
         }
 
         IsWellFormedTagFunc func = (IsWellFormedTagFunc)(GetProcAddress(g_bcp47, "IsWellFormedTag"));
@@ -1312,7 +1159,7 @@ extern "C"
         return TRUE;
     }
 
-    HRESULT _DefGetDistanceOfClosestLanguageInList(
+    static HRESULT DefGetPlatformDistanceOfClosestLanguageInList(
         _In_ PCWSTR language,
         _In_ PCWSTR languagesList,
         _In_ wchar_t listDelimiter,
@@ -1323,7 +1170,7 @@ extern "C"
 
         if (g_bcp47 == nullptr)
         {
-            // Didn't find an implementation. Just return -1.0 as distance, and caller would handle.
+            // Didn't find an implementation. Return -1.0 so that the portable one is used.
             *closestDistance = -1.0;
             return S_OK;
         }
@@ -1345,3 +1192,1150 @@ extern "C"
 #endif
 
 #endif // !DEF_RTL
+
+#ifdef DEF_CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Platform-neutral: only depends on the compiler's CPUID intrinsics.
+    static volatile LONG g_defCpuFeatures = -1;
+
+#ifdef DEF_CPU_X86
+    static void DefCpuId(_In_ int leaf, _In_ int subleaf, _Out_writes_(4) int registers[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(registers, leaf, subleaf);
+#else
+        unsigned int a, b, c, d;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        registers[0] = (int)a;
+        registers[1] = (int)b;
+        registers[2] = (int)c;
+        registers[3] = (int)d;
+#endif
+    }
+
+    static UINT64 DefReadXcr0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return ((UINT64)edx << 32) | eax;
+#endif
+    }
+
+    static DEF_CPU_FEATURES DefDetectCpuFeatures()
+    {
+        DEF_CPU_FEATURES features = DEF_CPU_FEATURE_NONE;
+        int registers[4];
+
+        DefCpuId(0, 0, registers);
+        int maxLeaf = registers[0];
+        if (maxLeaf < 1)
+        {
+            return features;
+        }
+
+        DefCpuId(1, 0, registers);
+        if (registers[3] & (1 << 26))
+        {
+            features |= DEF_CPU_FEATURE_SSE2;
+        }
+        if (registers[2] & (1 << 19))
+        {
+            features |= DEF_CPU_FEATURE_SSE41;
+        }
+        if (registers[2] & (1 << 1))
+        {
+            features |= DEF_CPU_FEATURE_PCLMULQDQ;
+        }
+
+        // AVX2 also needs the OS to save the YMM state across context switches.
+        BOOL osSavesYmm = FALSE;
+        if ((registers[2] & (1 << 27)) && (registers[2] & (1 << 28)))
+        {
+            osSavesYmm = ((DefReadXcr0() & 0x6) == 0x6);
+        }
+
+        if (osSavesYmm && (maxLeaf >= 7))
+        {
+            DefCpuId(7, 0, registers);
+            if (registers[1] & (1 << 5))
+            {
+                features |= DEF_CPU_FEATURE_AVX2;
+            }
+        }
+
+        return features;
+    }
+#else
+    static DEF_CPU_FEATURES DefDetectCpuFeatures() { return DEF_CPU_FEATURE_NONE; }
+#endif
+
+    DEF_CPU_FEATURES _DefGetCpuFeatures()
+    {
+        LONG features = g_defCpuFeatures;
+        if (features < 0)
+        {
+            // Detection is idempotent, so racing initializers all store the same value.
+            features = (LONG)DefDetectCpuFeatures();
+            g_defCpuFeatures = features;
+        }
+        return (DEF_CPU_FEATURES)features;
+    }
+
+    /*
+     * CRC-32 as specified in IS0 3309 (polynomial 0xedb88320, reflected).
+     */
+
+    // All paths produce the same results as a byte-at-a-time table lookup.  The scalar path
+    // uses slice-by-16 tables, and processors with PCLMULQDQ fold 64 bytes per step.
+
+    static const UINT32 DefCrc32Polynomial = 0xedb88320;
+
+    // Multiplies two polynomials modulo the CRC polynomial, in the reflected bit order.
+    static constexpr UINT32 DefCrc32MultiplyModP(UINT32 a, UINT32 b)
+    {
+        UINT32 product = 0;
+        for (UINT32 mask = 0x80000000; mask != 0; mask >>= 1)
+        {
+            if (a & mask)
+            {
+                product ^= b;
+            }
+            b = (b & 1) ? ((b >> 1) ^ DefCrc32Polynomial) : (b >> 1);
+        }
+        return product;
+    }
+
+    typedef struct _DEF_CRC32_TABLES
+    {
+        UINT32 slices[16][256];
+        UINT32 powers[32]; // x^(2^n) modulo the polynomial
+
+        constexpr _DEF_CRC32_TABLES() : slices(), powers()
+        {
+            for (UINT32 i = 0; i < 256; i++)
+            {
+                UINT32 value = i;
+                for (int k = 0; k < 8; k++)
+                {
+                    value = (value & 1) ? ((value >> 1) ^ DefCrc32Polynomial) : (value >> 1);
+                }
+                slices[0][i] = value;
+            }
+
+            for (UINT32 i = 0; i < 256; i++)
+            {
+                for (int slice = 1; slice < 16; slice++)
+                {
+                    UINT32 previous = slices[slice - 1][i];
+                    slices[slice][i] = (previous >> 8) ^ slices[0][previous & 0xff];
+                }
+            }
+
+            UINT32 power = 0x40000000; // x^1
+            for (int n = 0; n < 32; n++)
+            {
+                powers[n] = power;
+                power = DefCrc32MultiplyModP(power, power);
+            }
+        }
+    } DEF_CRC32_TABLES;
+
+    static constexpr DEF_CRC32_TABLES g_defCrc32Tables{};
+
+    static inline UINT32 DefCrc32LoadUInt32(_In_reads_bytes_(4) const BYTE* pBuf)
+    {
+        return (UINT32)pBuf[0] | ((UINT32)pBuf[1] << 8) | ((UINT32)pBuf[2] << 16) | ((UINT32)pBuf[3] << 24);
+    }
+
+    // crc is the running (pre-conditioned) value, not the caller-visible checksum.
+    static UINT32 DefComputeCrc32Scalar(_In_ UINT32 crc, _In_reads_bytes_(cbBuf) const BYTE* pBuf, _In_ size_t cbBuf)
+    {
+        const UINT32(*slices)[256] = g_defCrc32Tables.slices;
+
+        while (cbBuf >= 16)
+        {
+            UINT32 word0 = DefCrc32LoadUInt32(pBuf) ^ crc;
+            UINT32 word1 = DefCrc32LoadUInt32(pBuf + 4);
+            UINT32 word2 = DefCrc32LoadUInt32(pBuf + 8);
+            UINT32 word3 = DefCrc32LoadUInt32(pBuf + 12);
+
+            crc = slices[15][word0 & 0xff] ^ slices[14][(word0 >> 8) & 0xff] ^ slices[13][(word0 >> 16) & 0xff] ^
+                  slices[12][word0 >> 24] ^ slices[11][word1 & 0xff] ^ slices[10][(word1 >> 8) & 0xff] ^
+                  slices[9][(word1 >> 16) & 0xff] ^ slices[8][word1 >> 24] ^ slices[7][word2 & 0xff] ^
+                  slices[6][(word2 >> 8) & 0xff] ^ slices[5][(word2 >> 16) & 0xff] ^ slices[4][word2 >> 24] ^
+                  slices[3][word3 & 0xff] ^ slices[2][(word3 >> 8) & 0xff] ^ slices[1][(word3 >> 16) & 0xff] ^
+                  slices[0][word3 >> 24];
+
+            pBuf += 16;
+            cbBuf -= 16;
+        }
+
+        if (cbBuf >= 8)
+        {
+            UINT32 word0 = DefCrc32LoadUInt32(pBuf) ^ crc;
+            UINT32 word1 = DefCrc32LoadUInt32(pBuf + 4);
+
+            crc = slices[7][word0 & 0xff] ^ slices[6][(word0 >> 8) & 0xff] ^ slices[5][(word0 >> 16) & 0xff] ^
+                  slices[4][word0 >> 24] ^ slices[3][word1 & 0xff] ^ slices[2][(word1 >> 8) & 0xff] ^
+                  slices[1][(word1 >> 16) & 0xff] ^ slices[0][word1 >> 24];
+
+            pBuf += 8;
+            cbBuf -= 8;
+        }
+
+        while (cbBuf-- > 0)
+        {
+            crc = slices[0][(crc ^ *pBuf++) & 0xff] ^ (crc >> 8);
+        }
+
+        return crc;
+    }
+
+#ifdef DEF_CPU_X86
+    // Folds 64 byte blocks with carry-less multiplies, then reduces to 32 bits with a Barrett
+    // reduction; see Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ".
+    // cbBuf must be a multiple of 16 and at least 64.
+    DEF_TARGET_PCLMULQDQ
+    static UINT32 DefComputeCrc32Pclmul(_In_ UINT32 crc, _In_reads_bytes_(cbBuf) const BYTE* pBuf, _In_ size_t cbBuf)
+    {
+        const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+        const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+        const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+        const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+        const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x00));
+        __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x10));
+        __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x20));
+        __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+        pBuf += 64;
+        cbBuf -= 64;
+
+        while (cbBuf >= 64)
+        {
+            __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+            __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf + 0x30)));
+
+            pBuf += 64;
+            cbBuf -= 64;
+        }
+
+        // Fold the four lanes into one, then any remaining 16 byte blocks into that.
+        __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x2), x5);
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x3), x5);
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x4), x5);
+
+        while (cbBuf >= 16)
+        {
+            x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBuf));
+            x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x2), x5);
+            pBuf += 16;
+            cbBuf -= 16;
+        }
+
+        // 128 bits to 64.
+        x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5k0, 0x00), x2);
+
+        // Barrett reduction to 32.
+        x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), poly, 0x10);
+        x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, low32), poly, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return (UINT32)_mm_extract_epi32(x1, 1);
+    }
+#endif
+
+    /*
+ * Compute the CRC32 as specified in in IS0 3309. See RFC-1662 and RFC-1952
+ * for implementation details and references.
+ * Pre- and post-conditioning (one's complement) is done by this function, so
+ * it should not be done by the caller. That is, do:
+ *
+ *     Crc = _DefComputeCrc32 ( 0, buffer, length );
+ * instead of
+ *
+ *     Crc = _DefComputeCrc32 ( 0xffffffff, buffer, length );
+ * or
+ *     Crc = _DefComputeCrc32 ( 0xffffffff, buffer, length) ^ 0xffffffff;
+ *
+ * Arguments:
+ * 
+ *    PartialCrc - A partially calculated CRC32.
+ *
+ *    Buffer - The buffer you want to CRC.
+ *
+ *    Length - The length of the buffer in bytes.
+ *
+ * Return Value:
+ *    The updated CRC32 value.
+ *
+ */
+
+    UINT32
+    _DefComputeCrc32(__in UINT32 partialCrc, __in_bcount(cbBuf) const BYTE* pBuf, __in UINT32 cbBuf)
+    {
+        UINT32 crc = partialCrc ^ 0xffffffffL;
+        size_t remaining = cbBuf;
+
+#ifdef DEF_CPU_X86
+        const DEF_CPU_FEATURES clmulFeatures = DEF_CPU_FEATURE_PCLMULQDQ | DEF_CPU_FEATURE_SSE41;
+        if ((remaining >= 64) && ((_DefGetCpuFeatures() & clmulFeatures) == clmulFeatures))
+        {
+            size_t cbFolded = remaining & ~(size_t)15;
+            crc = DefComputeCrc32Pclmul(crc, pBuf, cbFolded);
+            pBuf += cbFolded;
+            remaining -= cbFolded;
+        }
+#endif
+
+        crc = DefComputeCrc32Scalar(crc, pBuf, remaining);
+
+        return (crc ^ 0xffffffffL);
+    }
+
+    // Lower-cases cch characters from pSrc into pDest.  ASCII is folded directly; anything else
+    // goes through towlower.
+    static void DefLowerCaseScalar(_In_reads_(cch) PCWSTR pSrc, _Out_writes_(cch) WCHAR* pDest, _In_ size_t cch)
+    {
+        for (size_t i = 0; i < cch; i++)
+        {
+            WCHAR ch = pSrc[i];
+            if (ch < 0x80)
+            {
+                pDest[i] = ((ch >= L'A') && (ch <= L'Z')) ? (WCHAR)(ch | 0x20) : ch;
+            }
+            else
+            {
+                pDest[i] = (WCHAR)towlower(ch);
+            }
+        }
+    }
+
+#ifdef DEF_CPU_X86
+    // Folds eight characters at a time; blocks with any non-ASCII character take the scalar path.
+    DEF_TARGET_SSE2
+    static void DefLowerCaseSse2(_In_reads_(cch) PCWSTR pSrc, _Out_writes_(cch) WCHAR* pDest, _In_ size_t cch)
+    {
+        const __m128i nonAsciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+        const __m128i beforeA = _mm_set1_epi16(L'A' - 1);
+        const __m128i afterZ = _mm_set1_epi16(L'Z' + 1);
+        const __m128i caseBit = _mm_set1_epi16(0x20);
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 8 <= cch; i += 8)
+        {
+            __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, nonAsciiMask), zero)) != 0xFFFF)
+            {
+                DefLowerCaseScalar(pSrc + i, pDest + i, 8);
+                continue;
+            }
+
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(units, beforeA), _mm_cmplt_epi16(units, afterZ));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + i), _mm_or_si128(units, _mm_and_si128(upper, caseBit)));
+        }
+
+        DefLowerCaseScalar(pSrc + i, pDest + i, cch - i);
+    }
+#endif
+
+    UINT32
+    _DefComputeStringCrc32(__in UINT32 partialCrc, __in BOOLEAN isCaseInsensitive, __in_ecount(cchStr) PCWSTR pStr, __in UINT32 cchStr)
+    {
+        if (!isCaseInsensitive)
+        {
+            // Each character is checksummed low byte first, which is its layout in memory.
+            return _DefComputeCrc32(partialCrc, reinterpret_cast<const BYTE*>(pStr), cchStr * sizeof(WCHAR));
+        }
+
+        // Fold into a buffer on the stack a chunk at a time, so no copy of the string is needed.
+        WCHAR folded[256];
+        UINT32 crc = partialCrc;
+
+#ifdef DEF_CPU_X86
+        const bool useSse2 = ((_DefGetCpuFeatures() & DEF_CPU_FEATURE_SSE2) != 0);
+#endif
+
+        while (cchStr > 0)
+        {
+            UINT32 cchChunk = (cchStr < ARRAYSIZE(folded)) ? cchStr : static_cast<UINT32>(ARRAYSIZE(folded));
+
+#ifdef DEF_CPU_X86
+            if (useSse2)
+            {
+                DefLowerCaseSse2(pStr, folded, cchChunk);
+            }
+            else
+#endif
+            {
+                DefLowerCaseScalar(pStr, folded, cchChunk);
+            }
+
+            crc = _DefComputeCrc32(crc, reinterpret_cast<const BYTE*>(folded), cchChunk * sizeof(WCHAR));
+            pStr += cchChunk;
+            cchStr -= cchChunk;
+        }
+
+        return crc;
+    }
+
+    UINT32 _DefCombineCrc32(__in UINT32 crc1, __in UINT32 crc2, __in UINT64 cbBuf2)
+    {
+        // Appending cbBuf2 bytes multiplies crc1 by x^(8 * cbBuf2); walk the bits of the length
+        // starting from the x^8 power.
+        UINT32 shift = 0x80000000; // x^0
+        for (int n = 3; cbBuf2 != 0; cbBuf2 >>= 1, n++)
+        {
+            if (cbBuf2 & 1)
+            {
+                shift = DefCrc32MultiplyModP(g_defCrc32Tables.powers[n & 31], shift);
+            }
+        }
+
+        return DefCrc32MultiplyModP(shift, crc1) ^ crc2;
+    }
+
+    // Portable BCP-47 language matching, used where the platform doesn't provide one.
+    // Tags are compared case-insensitively on their language, script and region;
+    // any other subtags only take part in exact matches.
+
+    typedef struct _DEF_LANGUAGE_TAG
+    {
+        char language[9];
+        char script[5];
+        char region[4];
+        UINT32 otherSubtags; // hash of extlang, variant, extension and private use subtags, 0 if none
+    } DEF_LANGUAGE_TAG;
+
+    typedef struct _DEF_LIKELY_SUBTAGS
+    {
+        const char* language;
+        const char* script;
+        const char* region;
+    } DEF_LIKELY_SUBTAGS;
+
+    typedef struct _DEF_SUBTAG_MAPPING
+    {
+        const char* language;
+        const char* key;
+        const char* value;
+    } DEF_SUBTAG_MAPPING;
+
+    // Likely script and region of each language, sorted by language.
+    static constexpr DEF_LIKELY_SUBTAGS g_defLikelySubtags[] = {
+        { "af", "latn", "za" },
+        { "am", "ethi", "et" },
+        { "ar", "arab", "eg" },
+        { "as", "beng", "in" },
+        { "az", "latn", "az" },
+        { "be", "cyrl", "by" },
+        { "bg", "cyrl", "bg" },
+        { "bn", "beng", "bd" },
+        { "bs", "latn", "ba" },
+        { "ca", "latn", "es" },
+        { "cs", "latn", "cz" },
+        { "cy", "latn", "gb" },
+        { "da", "latn", "dk" },
+        { "de", "latn", "de" },
+        { "el", "grek", "gr" },
+        { "en", "latn", "us" },
+        { "es", "latn", "es" },
+        { "et", "latn", "ee" },
+        { "eu", "latn", "es" },
+        { "fa", "arab", "ir" },
+        { "fi", "latn", "fi" },
+        { "fil", "latn", "ph" },
+        { "fr", "latn", "fr" },
+        { "ga", "latn", "ie" },
+        { "gd", "latn", "gb" },
+        { "gl", "latn", "es" },
+        { "gu", "gujr", "in" },
+        { "ha", "latn", "ng" },
+        { "he", "hebr", "il" },
+        { "hi", "deva", "in" },
+        { "hr", "latn", "hr" },
+        { "hu", "latn", "hu" },
+        { "hy", "armn", "am" },
+        { "id", "latn", "id" },
+        { "ig", "latn", "ng" },
+        { "is", "latn", "is" },
+        { "it", "latn", "it" },
+        { "ja", "jpan", "jp" },
+        { "ka", "geor", "ge" },
+        { "kk", "cyrl", "kz" },
+        { "km", "khmr", "kh" },
+        { "kn", "knda", "in" },
+        { "ko", "kore", "kr" },
+        { "ky", "cyrl", "kg" },
+        { "lb", "latn", "lu" },
+        { "lo", "laoo", "la" },
+        { "lt", "latn", "lt" },
+        { "lv", "latn", "lv" },
+        { "mi", "latn", "nz" },
+        { "mk", "cyrl", "mk" },
+        { "ml", "mlym", "in" },
+        { "mn", "cyrl", "mn" },
+        { "mr", "deva", "in" },
+        { "ms", "latn", "my" },
+        { "mt", "latn", "mt" },
+        { "nb", "latn", "no" },
+        { "ne", "deva", "np" },
+        { "nl", "latn", "nl" },
+        { "nn", "latn", "no" },
+        { "or", "orya", "in" },
+        { "pa", "guru", "in" },
+        { "pl", "latn", "pl" },
+        { "prs", "arab", "af" },
+        { "ps", "arab", "af" },
+        { "pt", "latn", "br" },
+        { "quz", "latn", "pe" },
+        { "ro", "latn", "ro" },
+        { "ru", "cyrl", "ru" },
+        { "rw", "latn", "rw" },
+        { "sd", "arab", "pk" },
+        { "si", "sinh", "lk" },
+        { "sk", "latn", "sk" },
+        { "sl", "latn", "si" },
+        { "sq", "latn", "al" },
+        { "sr", "cyrl", "rs" },
+        { "sv", "latn", "se" },
+        { "sw", "latn", "tz" },
+        { "ta", "taml", "in" },
+        { "te", "telu", "in" },
+        { "tg", "cyrl", "tj" },
+        { "th", "thai", "th" },
+        { "ti", "ethi", "et" },
+        { "tk", "latn", "tm" },
+        { "tn", "latn", "za" },
+        { "tr", "latn", "tr" },
+        { "tt", "cyrl", "ru" },
+        { "ug", "arab", "cn" },
+        { "uk", "cyrl", "ua" },
+        { "ur", "arab", "pk" },
+        { "uz", "latn", "uz" },
+        { "vi", "latn", "vn" },
+        { "wo", "latn", "sn" },
+        { "xh", "latn", "za" },
+        { "yo", "latn", "ng" },
+        { "zh", "hans", "cn" },
+        { "zu", "latn", "za" },
+    };
+
+    // Script of a language that depends on its region.
+    static constexpr DEF_SUBTAG_MAPPING g_defLikelyScriptForRegion[] = {
+        { "az", "ir", "arab" }, { "pa", "pk", "arab" }, { "sr", "me", "latn" }, { "uz", "af", "arab" },
+        { "zh", "hk", "hant" }, { "zh", "mo", "hant" }, { "zh", "tw", "hant" },
+    };
+
+    // Region of a language that depends on its script.
+    static constexpr DEF_SUBTAG_MAPPING g_defLikelyRegionForScript[] = {
+        { "az", "arab", "ir" }, { "az", "cyrl", "az" }, { "bs", "cyrl", "ba" }, { "mn", "mong", "cn" }, { "pa", "arab", "pk" },
+        { "sr", "latn", "rs" }, { "uz", "arab", "af" }, { "uz", "cyrl", "uz" }, { "zh", "hant", "tw" },
+    };
+
+    // Parent of a regional variant of a language, for languages with macro-region locales.
+    static constexpr DEF_SUBTAG_MAPPING g_defParentRegions[] = {
+        { "en", "150", "001" }, { "en", "at", "150" }, { "en", "au", "001" }, { "en", "be", "150" }, { "en", "ca", "001" },
+        { "en", "ch", "150" },  { "en", "de", "150" }, { "en", "dk", "150" }, { "en", "fi", "150" }, { "en", "gb", "001" },
+        { "en", "ie", "001" },  { "en", "in", "001" }, { "en", "nl", "150" }, { "en", "nz", "001" }, { "en", "se", "150" },
+        { "en", "sg", "001" },  { "en", "za", "001" }, { "es", "ar", "419" }, { "es", "bo", "419" }, { "es", "cl", "419" },
+        { "es", "co", "419" },  { "es", "cr", "419" }, { "es", "cu", "419" }, { "es", "do", "419" }, { "es", "ec", "419" },
+        { "es", "gt", "419" },  { "es", "hn", "419" }, { "es", "mx", "419" }, { "es", "ni", "419" }, { "es", "pa", "419" },
+        { "es", "pe", "419" },  { "es", "pr", "419" }, { "es", "py", "419" }, { "es", "sv", "419" }, { "es", "us", "419" },
+        { "es", "uy", "419" },  { "es", "ve", "419" }, { "pt", "ao", "pt" },   { "pt", "ch", "pt" },   { "pt", "cv", "pt" },
+        { "pt", "gq", "pt" },   { "pt", "gw", "pt" },  { "pt", "lu", "pt" },  { "pt", "mo", "pt" },  { "pt", "mz", "pt" },
+        { "pt", "st", "pt" },   { "pt", "tl", "pt" },  { "zh", "mo", "hk" },
+    };
+
+    // Deprecated language subtags and their replacements.
+    static constexpr DEF_SUBTAG_MAPPING g_defLanguageAliases[] = {
+        { "in", nullptr, "id" }, { "iw", nullptr, "he" }, { "ji", nullptr, "yi" }, { "jw", nullptr, "jv" },
+        { "mo", nullptr, "ro" }, { "no", nullptr, "nb" }, { "tl", nullptr, "fil" },
+    };
+
+    // Match quality of a single asset tag against a single user language.
+    static const double DefLanguageMatch_Exact = 1.0;
+    static const double DefLanguageMatch_OtherSubtags = 0.95; // differs only in variants or redundant subtags
+    static const double DefLanguageMatch_NeutralLikely = 0.9; // neutral asset whose likely region is the user's
+    static const double DefLanguageMatch_UserNeutralLikely = 0.85; // neutral user language whose likely region is the asset's
+    static const double DefLanguageMatch_Neutral = 0.8; // neutral asset, other region
+    static const double DefLanguageMatch_ParentRegion = 0.75; // asset region is a parent of the user's
+    static const double DefLanguageMatch_SiblingRegion = 0.7; // regions share a parent
+    static const double DefLanguageMatch_OtherRegion = 0.6;
+
+    static BOOLEAN DefIsAsciiAlpha(_In_ WCHAR ch) { return ((ch >= L'a') && (ch <= L'z')) || ((ch >= L'A') && (ch <= L'Z')); }
+
+    static BOOLEAN DefIsAsciiDigit(_In_ WCHAR ch) { return (ch >= L'0') && (ch <= L'9'); }
+
+    static void DefCopyLowerSubtag(_In_reads_(cch) PCWSTR pSubtag, _In_ size_t cch, _Out_writes_(cchOut) char* pOut, _In_ size_t cchOut)
+    {
+        size_t i = 0;
+        for (; (i < cch) && (i < cchOut - 1); i++)
+        {
+            WCHAR ch = pSubtag[i];
+            pOut[i] = (char)(((ch >= L'A') && (ch <= L'Z')) ? (ch - L'A' + L'a') : ch);
+        }
+        pOut[i] = '\0';
+    }
+
+    static void DefCopySubtag(_In_ const char* pSubtag, _Out_writes_(cchOut) char* pOut, _In_ size_t cchOut)
+    {
+        size_t i = 0;
+        for (; (pSubtag[i] != '\0') && (i < cchOut - 1); i++)
+        {
+            pOut[i] = pSubtag[i];
+        }
+        pOut[i] = '\0';
+    }
+
+    static UINT32 DefHashSubtag(_In_ UINT32 hash, _In_reads_(cch) PCWSTR pSubtag, _In_ size_t cch)
+    {
+        // FNV-1a over the lower-cased subtag and a separator
+        for (size_t i = 0; i < cch; i++)
+        {
+            WCHAR ch = pSubtag[i];
+            hash = (hash ^ (UINT32)(((ch >= L'A') && (ch <= L'Z')) ? (ch - L'A' + L'a') : ch)) * 16777619u;
+        }
+        return (hash ^ (UINT32)'-') * 16777619u;
+    }
+
+    typedef enum _DEF_LANGUAGE_TAG_PART
+    {
+        DefTagPart_Language,
+        DefTagPart_ExtLang,
+        DefTagPart_Script,
+        DefTagPart_Region,
+        DefTagPart_Variant,
+        DefTagPart_Extension,
+        DefTagPart_PrivateUse
+    } DEF_LANGUAGE_TAG_PART;
+
+    // Parses a single well-formed tag per RFC 5646, without validating subtags against the registry.
+    static BOOLEAN DefParseLanguageTag(_In_reads_(cchTag) PCWSTR pTag, _In_ size_t cchTag, _Out_ DEF_LANGUAGE_TAG* pTagOut)
+    {
+        memset(pTagOut, 0, sizeof(*pTagOut));
+
+        DEF_LANGUAGE_TAG_PART part = DefTagPart_Language;
+        UINT32 hash = 2166136261u;
+        BOOLEAN hasOtherSubtags = FALSE;
+        BOOLEAN needSubtag = FALSE; // a singleton must be followed by at least one subtag
+        int numExtLangs = 0;
+        size_t pos = 0;
+
+        if (cchTag == 0)
+        {
+            return FALSE;
+        }
+
+        while (pos <= cchTag)
+        {
+            size_t start = pos;
+            size_t numDigits = 0;
+            size_t numAlpha = 0;
+
+            while ((pos < cchTag) && (pTag[pos] != L'-'))
+            {
+                numAlpha += DefIsAsciiAlpha(pTag[pos]) ? 1 : 0;
+                numDigits += DefIsAsciiDigit(pTag[pos]) ? 1 : 0;
+                pos++;
+            }
+
+            PCWSTR pSubtag = &pTag[start];
+            size_t cch = pos - start;
+            pos++;
+
+            if ((cch == 0) || (cch > 8) || ((numAlpha + numDigits) != cch))
+            {
+                return FALSE;
+            }
+
+            BOOLEAN isAlpha = (numAlpha == cch);
+
+            if (part == DefTagPart_Language)
+            {
+                if ((cch == 1) && ((pSubtag[0] == L'x') || (pSubtag[0] == L'X') || (pSubtag[0] == L'i') || (pSubtag[0] == L'I')))
+                {
+                    // private use or irregular tag, which only matches exactly
+                    part = DefTagPart_PrivateUse;
+                    needSubtag = TRUE;
+                }
+                else if (isAlpha && (cch >= 2) && (cch != 4))
+                {
+                    DefCopyLowerSubtag(pSubtag, cch, pTagOut->language, ARRAYSIZE(pTagOut->language));
+                    part = (cch <= 3) ? DefTagPart_ExtLang : DefTagPart_Script;
+                    continue;
+                }
+                else
+                {
+                    return FALSE;
+                }
+            }
+            else if (part == DefTagPart_PrivateUse)
+            {
+                needSubtag = FALSE;
+            }
+            else
+            {
+                if ((part == DefTagPart_ExtLang) && isAlpha && (cch == 3) && (numExtLangs < 3))
+                {
+                    numExtLangs++;
+                }
+                else if ((part <= DefTagPart_Script) && isAlpha && (cch == 4))
+                {
+                    DefCopyLowerSubtag(pSubtag, cch, pTagOut->script, ARRAYSIZE(pTagOut->script));
+                    part = DefTagPart_Region;
+                    continue;
+                }
+                else if ((part <= DefTagPart_Region) && ((isAlpha && (cch == 2)) || ((numDigits == 3) && (cch == 3))))
+                {
+                    DefCopyLowerSubtag(pSubtag, cch, pTagOut->region, ARRAYSIZE(pTagOut->region));
+                    part = DefTagPart_Variant;
+                    continue;
+                }
+                else if ((part <= DefTagPart_Variant) && ((cch >= 5) || ((cch == 4) && DefIsAsciiDigit(pSubtag[0]))))
+                {
+                    part = DefTagPart_Variant;
+                }
+                else if (cch == 1)
+                {
+                    if (needSubtag)
+                    {
+                        return FALSE;
+                    }
+                    part = ((pSubtag[0] == L'x') || (pSubtag[0] == L'X')) ? DefTagPart_PrivateUse : DefTagPart_Extension;
+                    needSubtag = TRUE;
+                }
+                else if ((part == DefTagPart_Extension) && (cch >= 2))
+                {
+                    needSubtag = FALSE;
+                }
+                else
+                {
+                    return FALSE;
+                }
+            }
+
+            hash = DefHashSubtag(hash, pSubtag, cch);
+            hasOtherSubtags = TRUE;
+        }
+
+        if (needSubtag)
+        {
+            return FALSE;
+        }
+
+        pTagOut->otherSubtags = hasOtherSubtags ? (hash | 1) : 0;
+
+        for (size_t i = 0; i < ARRAYSIZE(g_defLanguageAliases); i++)
+        {
+            if (strcmp(pTagOut->language, g_defLanguageAliases[i].language) == 0)
+            {
+                DefCopySubtag(g_defLanguageAliases[i].value, pTagOut->language, ARRAYSIZE(pTagOut->language));
+                break;
+            }
+        }
+
+        return TRUE;
+    }
+
+    static const DEF_LIKELY_SUBTAGS* DefFindLikelySubtags(_In_ const char* pLanguage)
+    {
+        size_t low = 0;
+        size_t high = ARRAYSIZE(g_defLikelySubtags);
+
+        while (low < high)
+        {
+            size_t mid = low + ((high - low) / 2);
+            int diff = strcmp(pLanguage, g_defLikelySubtags[mid].language);
+            if (diff == 0)
+            {
+                return &g_defLikelySubtags[mid];
+            }
+            else if (diff < 0)
+            {
+                high = mid;
+            }
+            else
+            {
+                low = mid + 1;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static const char* DefFindSubtagMapping(
+        _In_reads_(numMappings) const DEF_SUBTAG_MAPPING* pMappings,
+        _In_ size_t numMappings,
+        _In_ const char* pLanguage,
+        _In_ const char* pKey)
+    {
+        for (size_t i = 0; i < numMappings; i++)
+        {
+            if ((strcmp(pMappings[i].language, pLanguage) == 0) && (strcmp(pMappings[i].key, pKey) == 0))
+            {
+                return pMappings[i].value;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Fills in a missing script and region from the likely subtags tables.
+    static void DefMaximizeLanguageTag(_Inout_ DEF_LANGUAGE_TAG* pTag)
+    {
+        const DEF_LIKELY_SUBTAGS* pLikely = DefFindLikelySubtags(pTag->language);
+
+        if (pTag->script[0] == '\0')
+        {
+            const char* pScript = nullptr;
+            if (pTag->region[0] != '\0')
+            {
+                pScript = DefFindSubtagMapping(
+                    g_defLikelyScriptForRegion, ARRAYSIZE(g_defLikelyScriptForRegion), pTag->language, pTag->region);
+            }
+
+            if ((pScript == nullptr) && (pLikely != nullptr))
+            {
+                pScript = pLikely->script;
+            }
+
+            if (pScript != nullptr)
+            {
+                DefCopySubtag(pScript, pTag->script, ARRAYSIZE(pTag->script));
+            }
+        }
+
+        if (pTag->region[0] == '\0')
+        {
+            const char* pRegion =
+                DefFindSubtagMapping(g_defLikelyRegionForScript, ARRAYSIZE(g_defLikelyRegionForScript), pTag->language, pTag->script);
+
+            if ((pRegion == nullptr) && (pLikely != nullptr) && (strcmp(pLikely->script, pTag->script) == 0))
+            {
+                pRegion = pLikely->region;
+            }
+
+            if (pRegion != nullptr)
+            {
+                DefCopySubtag(pRegion, pTag->region, ARRAYSIZE(pTag->region));
+            }
+        }
+    }
+
+    static const char* DefGetParentRegion(_In_ const DEF_LANGUAGE_TAG* pTag, _In_ const char* pRegion)
+    {
+        return DefFindSubtagMapping(g_defParentRegions, ARRAYSIZE(g_defParentRegions), pTag->language, pRegion);
+    }
+
+    static BOOLEAN DefIsParentRegion(_In_ const DEF_LANGUAGE_TAG* pTag, _In_ const char* pParent, _In_ const char* pRegion)
+    {
+        // the parent tables are at most a few levels deep
+        for (int depth = 0; (depth < 4) && (pRegion != nullptr); depth++)
+        {
+            pRegion = DefGetParentRegion(pTag, pRegion);
+            if ((pRegion != nullptr) && (strcmp(pRegion, pParent) == 0))
+            {
+                return TRUE;
+            }
+        }
+
+        return FALSE;
+    }
+
+    static double DefGetLanguageMatchQuality(_In_ const DEF_LANGUAGE_TAG* pAsset, _In_ const DEF_LANGUAGE_TAG* pUser)
+    {
+        if (strcmp(pAsset->language, pUser->language) != 0)
+        {
+            return 0.0;
+        }
+
+        if ((strcmp(pAsset->script, pUser->script) == 0) && (strcmp(pAsset->region, pUser->region) == 0) &&
+            (pAsset->otherSubtags == pUser->otherSubtags))
+        {
+            return DefLanguageMatch_Exact;
+        }
+
+        if (pAsset->language[0] == '\0')
+        {
+            // private use tags only match exactly
+            return 0.0;
+        }
+
+        DEF_LANGUAGE_TAG asset = *pAsset;
+        DEF_LANGUAGE_TAG user = *pUser;
+        DefMaximizeLanguageTag(&asset);
+        DefMaximizeLanguageTag(&user);
+
+        if (strcmp(asset.script, user.script) != 0)
+        {
+            return 0.0;
+        }
+
+        BOOLEAN assetIsNeutral = (pAsset->region[0] == '\0');
+        BOOLEAN userIsNeutral = (pUser->region[0] == '\0');
+
+        if (strcmp(asset.region, user.region) == 0)
+        {
+            if (assetIsNeutral == userIsNeutral)
+            {
+                return DefLanguageMatch_OtherSubtags;
+            }
+            return assetIsNeutral ? DefLanguageMatch_NeutralLikely : DefLanguageMatch_UserNeutralLikely;
+        }
+
+        if (assetIsNeutral)
+        {
+            return DefLanguageMatch_Neutral;
+        }
+
+        if (DefIsParentRegion(&asset, asset.region, user.region))
+        {
+            return DefLanguageMatch_ParentRegion;
+        }
+
+        const char* pAssetParent = DefGetParentRegion(&asset, asset.region);
+        const char* pUserParent = DefGetParentRegion(&user, user.region);
+        if ((pAssetParent != nullptr) && (pUserParent != nullptr) && (strcmp(pAssetParent, pUserParent) == 0))
+        {
+            return DefLanguageMatch_SiblingRegion;
+        }
+
+        return DefLanguageMatch_OtherRegion;
+    }
+
+    BOOLEAN _DefIsWellFormedLanguageTag(_In_ PCWSTR tag)
+    {
+        if ((tag == nullptr) || (*tag == L'\0'))
+        {
+            return FALSE;
+        }
+
+        // accept a ';' separated list of tags
+        PCWSTR pItem = tag;
+        for (;;)
+        {
+            PCWSTR pEnd = wcschr(pItem, L';');
+            size_t cchItem = (pEnd != nullptr) ? (size_t)(pEnd - pItem) : wcslen(pItem);
+
+            DEF_LANGUAGE_TAG parsed;
+            if (!DefParseLanguageTag(pItem, cchItem, &parsed))
+            {
+                return FALSE;
+            }
+
+            if (pEnd == nullptr)
+            {
+                return TRUE;
+            }
+            pItem = pEnd + 1;
+        }
+    }
+
+    HRESULT _DefGetLanguageListMatchScore(
+        _In_ PCWSTR language,
+        _In_ PCWSTR languagesList,
+        _In_ wchar_t listDelimiter,
+        _Out_ double* score)
+    {
+        *score = -1.0;
+
+        DEF_LANGUAGE_TAG asset;
+        if ((language == nullptr) || (languagesList == nullptr) || !DefParseLanguageTag(language, wcslen(language), &asset))
+        {
+            // Let the caller fall back to comparing strings.
+            return S_OK;
+        }
+
+        int numLanguages = 0;
+        for (PCWSTR pTest = languagesList; *pTest != L'\0'; pTest++)
+        {
+            numLanguages += (*pTest == listDelimiter) ? 1 : 0;
+        }
+        numLanguages++;
+
+        // A match on an earlier language in the list always beats any match on a later one.
+        PCWSTR pItem = languagesList;
+        for (int i = 0; i < numLanguages; i++)
+        {
+            PCWSTR pEnd = wcschr(pItem, listDelimiter);
+            size_t cchItem = (pEnd != nullptr) ? (size_t)(pEnd - pItem) : wcslen(pItem);
+
+            DEF_LANGUAGE_TAG user;
+            if (DefParseLanguageTag(pItem, cchItem, &user))
+            {
+                double quality = DefGetLanguageMatchQuality(&asset, &user);
+                if (quality > 0.0)
+                {
+                    *score = ((double)(numLanguages - 1 - i) + quality) / (double)numLanguages;
+                    return S_OK;
+                }
+            }
+
+            if (pEnd == nullptr)
+            {
+                break;
+            }
+            pItem = pEnd + 1;
+        }
+
+        *score = 0.0;
+        return S_OK;
+    }
+
+    // Language match results are memoized by (asset language, user language list), since
+    // the same pairs are evaluated for every resource with a language qualifier.
+    typedef struct _DEF_LANGUAGE_MATCH_CACHE_ENTRY
+    {
+        UINT32 hash;
+        wchar_t listDelimiter;
+        PWSTR pLanguage; // owns the allocation; pLanguagesList points into it
+        PCWSTR pLanguagesList;
+        double score;
+    } DEF_LANGUAGE_MATCH_CACHE_ENTRY;
+
+#define DEF_LANGUAGE_MATCH_CACHE_SIZE 256
+
+    static DEF_LANGUAGE_MATCH_CACHE_ENTRY g_defLanguageMatchCache[DEF_LANGUAGE_MATCH_CACHE_SIZE];
+    static _DEF_SRWLOCK g_defLanguageMatchCacheLock; // zero-initialized, which is an unlocked SRW lock
+
+    static UINT32 DefHashLanguageMatchKey(_In_ PCWSTR language, _In_ PCWSTR languagesList, _In_ wchar_t listDelimiter)
+    {
+        UINT32 hash = 2166136261u;
+        hash = DefHashSubtag(hash, language, wcslen(language));
+        hash = DefHashSubtag(hash, &listDelimiter, 1);
+        return DefHashSubtag(hash, languagesList, wcslen(languagesList));
+    }
+
+    static BOOLEAN DefTryGetCachedLanguageMatch(
+        _In_ UINT32 hash,
+        _In_ PCWSTR language,
+        _In_ PCWSTR languagesList,
+        _In_ wchar_t listDelimiter,
+        _Out_ double* score)
+    {
+        BOOLEAN found = FALSE;
+        const DEF_LANGUAGE_MATCH_CACHE_ENTRY* pEntry = &g_defLanguageMatchCache[hash % DEF_LANGUAGE_MATCH_CACHE_SIZE];
+
+        _DefAcquireSRWLockShared(&g_defLanguageMatchCacheLock);
+        if ((pEntry->pLanguage != nullptr) && (pEntry->hash == hash) && (pEntry->listDelimiter == listDelimiter) &&
+            (wcscmp(pEntry->pLanguage, language) == 0) && (wcscmp(pEntry->pLanguagesList, languagesList) == 0))
+        {
+            *score = pEntry->score;
+            found = TRUE;
+        }
+        _DefReleaseSRWLockShared(&g_defLanguageMatchCacheLock);
+
+        return found;
+    }
+
+    static void DefCacheLanguageMatch(
+        _In_ UINT32 hash,
+        _In_ PCWSTR language,
+        _In_ PCWSTR languagesList,
+        _In_ wchar_t listDelimiter,
+        _In_ double score)
+    {
+        size_t cchLanguage = wcslen(language) + 1;
+        size_t cchList = wcslen(languagesList) + 1;
+
+        // Caching is best effort, so failures are ignored.
+        PWSTR pKey = _DefArray_Alloc(WCHAR, cchLanguage + cchList);
+        if (pKey == nullptr)
+        {
+            return;
+        }
+
+        memcpy(pKey, language, cchLanguage * sizeof(WCHAR));
+        memcpy(pKey + cchLanguage, languagesList, cchList * sizeof(WCHAR));
+
+        DEF_LANGUAGE_MATCH_CACHE_ENTRY* pEntry = &g_defLanguageMatchCache[hash % DEF_LANGUAGE_MATCH_CACHE_SIZE];
+
+        _DefAcquireSRWLockExclusive(&g_defLanguageMatchCacheLock);
+        PWSTR pOldKey = pEntry->pLanguage;
+        pEntry->hash = hash;
+        pEntry->listDelimiter = listDelimiter;
+        pEntry->pLanguage = pKey;
+        pEntry->pLanguagesList = pKey + cchLanguage;
+        pEntry->score = score;
+        _DefReleaseSRWLockExclusive(&g_defLanguageMatchCacheLock);
+
+        if (pOldKey != nullptr)
+        {
+            _DefFree(pOldKey);
+        }
+    }
+
+    HRESULT _DefGetDistanceOfClosestLanguageInList(
+        _In_ PCWSTR language,
+        _In_ PCWSTR languagesList,
+        _In_ wchar_t listDelimiter,
+        _Out_ double* closestDistance)
+    {
+        *closestDistance = -1.0;
+
+        if ((language == nullptr) || (languagesList == nullptr))
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT32 hash = DefHashLanguageMatchKey(language, languagesList, listDelimiter);
+        if (DefTryGetCachedLanguageMatch(hash, language, languagesList, listDelimiter, closestDistance))
+        {
+            return S_OK;
+        }
+
+        HRESULT hr = DefGetPlatformDistanceOfClosestLanguageInList(language, languagesList, listDelimiter, closestDistance);
+        if (SUCCEEDED(hr) && (*closestDistance < 0.0))
+        {
+            // no platform implementation
+            hr = _DefGetLanguageListMatchScore(language, languagesList, listDelimiter, closestDistance);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            DefCacheLanguageMatch(hash, language, languagesList, listDelimiter, *closestDistance);
+        }
+
+        return hr;
+    }
+
+#ifdef __cplusplus
+}
+#endif
@@ -212,10 +212,38 @@ public:
         return S_OK;
     }
 
-    ~DecisionInfoCache() {}
+    ~DecisionInfoCache()
+    {
+        // Every block ever published is in the newest table; older tables only hold a subset.
+        DecisionResultsTable* pTable = m_pDecisionResults;
+        if (pTable != nullptr)
+        {
+            for (int i = 0; i < pTable->numDecisions; i++)
+            {
+                if (pTable->blocks[i] != nullptr)
+                {
+                    Def_Free(pTable->blocks[i]);
+                }
+            }
+        }
+
+        while (pTable != nullptr)
+        {
+            DecisionResultsTable* pRetired = pTable->pRetired;
+            Def_Free(pTable);
+            pTable = pRetired;
+        }
+        m_pDecisionResults = nullptr;
+    }
 
     const IDecisionInfo* GetDecisionInfo() const { return m_pDecisions; }
 
+    // Cached results record the qualifiers they were computed from as a bit per qualifier name
+    // index, so a partial reset only drops the entries that could have changed.  Names past the
+    // last bit share it, and anything we can't attribute depends on everything.
+    static const int OverflowDependencyBit = 63;
+    static const UINT64 AllDependencies = ~0ULL;
+
     typedef struct _QualifierCacheEntry
     {
         UINT32 priority : 10;
@@ -223,6 +251,7 @@ public:
         UINT32 fallbackScore : 10;
         UINT32 bAttempted : 1;
         UINT32 pad1 : 1;
+        UINT64 dependencies;
     } QualifierCacheEntry;
 
     typedef struct _QualifierSetCacheEntry
@@ -235,9 +264,33 @@ public:
         UINT32 bestMatchPriority : 10;
         UINT32 bestMatchScore : 10;
         UINT32 pad : 7;
+        UINT64 dependencies;
     } QualifierSetCacheEntry;
 
-    static const UINT16 kDecisionAttemptedMask = 0x8000;
+    // A fixed-width encoding of a QualifierSetComparer that orders the same way under a plain
+    // lexicographic compare of (high, low).  high holds the set-wide match flags and the first
+    // two qualifiers, low the next three, each as one 21 bit digit.  Sets with more qualifiers
+    // than fit are marked incomplete and fall back to the comparer when their keys tie.
+    typedef struct _QualifierSetSortKey
+    {
+        UINT64 high;
+        UINT64 low;
+        bool valid;
+        bool complete;
+    } QualifierSetSortKey;
+
+    static int CompareSortKeys(_In_ const QualifierSetSortKey* pKey1, _In_ const QualifierSetSortKey* pKey2)
+    {
+        if (pKey1->high != pKey2->high)
+        {
+            return (pKey1->high > pKey2->high) ? 1 : -1;
+        }
+        if (pKey1->low != pKey2->low)
+        {
+            return (pKey1->low > pKey2->low) ? 1 : -1;
+        }
+        return 0;
+    }
 
     class QualifierSetComparer
     {
@@ -390,7 +443,40 @@ public:
 
         UINT16 GetNumberOfQualifiers() { return _nextFreeEntry; }
 
+        void GetSortKey(_Out_ QualifierSetSortKey* pKeyOut)
+        {
+            bool isMatch = IsMatch();
+            UINT64 flags = (isMatch ? 3 : (IsMatchOrDefault() ? 1 : 0));
+
+            pKeyOut->high = (flags << (2 * SortKeyDigitBits)) | (GetSortKeyDigit(0) << SortKeyDigitBits) | GetSortKeyDigit(1);
+            pKeyOut->low = (GetSortKeyDigit(2) << (2 * SortKeyDigitBits)) | (GetSortKeyDigit(3) << SortKeyDigitBits) | GetSortKeyDigit(4);
+            pKeyOut->valid = true;
+            pKeyOut->complete = (_nextFreeEntry <= SortKeyMaxEntries);
+        }
+
     private:
+        // Digits reproduce the per-qualifier rules of Compare: a match beats a missing qualifier,
+        // which beats a non-match.  Higher priority matches rank higher, higher priority
+        // non-matches rank lower, and equal priorities fall through to the match or fallback score.
+        static const int SortKeyDigitBits = 21;
+        static const UINT16 SortKeyMaxEntries = 5;
+        static const UINT64 SortKeyScoreRange = IQualifier::MaxFallbackScore + 1;
+        static const UINT64 SortKeyNeutralDigit = SortKeyScoreRange * SortKeyScoreRange;
+
+        UINT64 GetSortKeyDigit(UINT16 entry)
+        {
+            if (entry >= _nextFreeEntry)
+            {
+                return SortKeyNeutralDigit;
+            }
+
+            if (IsMatch(entry))
+            {
+                return SortKeyNeutralDigit + 1 + (GetPriority(entry) * SortKeyScoreRange) + GetMatchScore(entry);
+            }
+            return ((IQualifier::MaxFallbackScore - GetPriority(entry)) * SortKeyScoreRange) + GetFallbackScore(entry);
+        }
+
         bool IsMatch(UINT16 entry) { return (_entries[entry].matchScore > 0); }
 
         bool IsDefault(UINT16 entry) { return (_entries[entry].fallbackScore > 0); }
@@ -465,20 +551,63 @@ public:
         }
         m_qualifierSetCache.Reset();
 
-        UINT16* pCachedDecision = m_decisionCache.GetAll();
-        for (unsigned int i = 0; i < m_decisionCache.Count(); ++i)
+        // Invalidates every published decision result at once; readers compare against the generation.
+        InterlockedIncrement64(&m_decisionGeneration);
+    }
+
+    void Reset(_In_reads_(numQualifierNames) const Atom* pQualifierNames, _In_ int numQualifierNames)
+    {
+        UINT64 changed = 0;
+        for (int i = 0; i < numQualifierNames; i++)
         {
-            *(pCachedDecision + i) &= ~kDecisionAttemptedMask;
+            // A name from another pool would quietly turn this into a full reset.
+            DEF_ASSERT(pQualifierNames[i].GetPoolIndex() == m_dependencyPool);
+            changed |= GetDependencyMask(pQualifierNames[i]);
         }
-        m_decisionCache.Reset();
 
-        m_decisionPerSetInfo.Reset();
-    }
+        if (changed == AllDependencies)
+        {
+            return Reset();
+        }
 
-    void Reset(_In_ Atom)
-    {
-        // TODO: qualifier based reset instead of All.
-        return Reset();
+        AutoReaderWriterLock autoLock(&m_srwLock);
+
+        QualifierCacheEntry* pCachedQualifiers = m_qualifierCache.GetAll();
+        for (unsigned int i = 0; i < m_qualifierCache.Count(); ++i)
+        {
+            if ((pCachedQualifiers[i].dependencies & changed) != 0)
+            {
+                pCachedQualifiers[i].bAttempted = 0;
+            }
+        }
+
+        QualifierSetCacheEntry* pCachedQualifierSets = m_qualifierSetCache.GetAll();
+        for (unsigned int i = 0; i < m_qualifierSetCache.Count(); ++i)
+        {
+            if ((pCachedQualifierSets[i].dependencies & changed) != 0)
+            {
+                pCachedQualifierSets[i].attempted = 0;
+            }
+        }
+
+        // Decision results can't be dropped one at a time without racing lock-free readers, so move
+        // to a new generation and carry the unaffected results forward.  Block states only ever grow,
+        // so a reader can't mistake a carried block for one it saw before.
+        LONG64 oldGeneration = m_decisionGeneration;
+        LONG64 newGeneration = oldGeneration + 1;
+        DecisionResultsTable* pTable = m_pDecisionResults;
+        if (pTable != nullptr)
+        {
+            for (int i = 0; i < pTable->numDecisions; i++)
+            {
+                DecisionResultsBlock* pBlock = pTable->blocks[i];
+                if ((pBlock != nullptr) && (pBlock->state == (oldGeneration * 2)) && ((pBlock->dependencies & changed) == 0))
+                {
+                    WriteRelease64(&pBlock->state, newGeneration * 2);
+                }
+            }
+        }
+        InterlockedExchange64(&m_decisionGeneration, newGeneration);
     }
 
     HRESULT GetQualifierScores(_In_ const IQualifier* pQualifier, _Out_ UINT16* pScoreOut, _Out_ UINT16* pFallbackScoreOut)
@@ -510,6 +639,8 @@ public:
         RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (score < 0) || (score > IQualifier::MaxFallbackScore));
         RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (fallbackScore < 0) || (fallbackScore > IQualifier::MaxFallbackScore));
 
+        UINT64 dependencies = GetQualifierDependencies(pQualifier);
+
         AutoReaderWriterLock autoLock(&m_srwLock);
         if (index >= m_qualifierCache.Count())
         {
@@ -523,6 +654,7 @@ public:
         entry.priority = priority;
         entry.score = score;
         entry.fallbackScore = fallbackScore;
+        entry.dependencies = dependencies;
         RETURN_IF_FAILED(m_qualifierCache.Set(index, entry));
 
         return S_OK;
@@ -606,6 +738,15 @@ public:
         RETURN_HR_IF(
             HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (bestActualMatchScore < 0) || (bestActualMatchScore > IQualifier::MaxFallbackScore));
 
+        // Every qualifier in the set counts, including any that evaluation skipped; decision
+        // sorting can still look at them.
+        UINT64 dependencies = 0;
+        QualifierResult qualifier;
+        for (int i = 0; (i < pQualifierSet->GetNumQualifiers()) && (dependencies != AllDependencies); i++)
+        {
+            dependencies |= (SUCCEEDED(pQualifierSet->GetQualifier(i, &qualifier)) ? GetQualifierDependencies(&qualifier) : AllDependencies);
+        }
+
         AutoReaderWriterLock autoLock(&m_srwLock);
         if (index >= m_qualifierSetCache.Count())
         {
@@ -622,6 +763,7 @@ public:
         entry.requireComplexResolution = (requireComplexResolution ? 1 : 0);
         entry.bestMatchPriority = bestActualMatchPriority;
         entry.bestMatchScore = bestActualMatchScore;
+        entry.dependencies = dependencies;
 
         RETURN_IF_FAILED(m_qualifierSetCache.Set(index, entry));
 
@@ -634,42 +776,74 @@ public:
         UINT16 setIndexInPool;
     } DecisionPerSetInfo;
 
+    // Sorted results for one decision.  Blocks are filled under the resolver's exclusive lock but
+    // read without any lock, so state is a sequence number: twice the generation the results belong
+    // to, plus one while they are being written.  A reader that sees a stale or changing state treats
+    // the entry as a miss.  Blocks are never freed or resized until the cache is destroyed.
+    typedef struct _DecisionResultsBlock
+    {
+        volatile LONG64 state;
+        UINT64 dependencies; // union of the dependencies of every set in the decision
+        int numSets;
+        DecisionPerSetInfo sets[ANYSIZE_ARRAY];
+    } DecisionResultsBlock;
+
+    typedef struct _DecisionResultsTable
+    {
+        int numDecisions;
+        struct _DecisionResultsTable* pRetired; // smaller table this one replaced; readers may still hold it
+        DecisionResultsBlock* blocks[ANYSIZE_ARRAY];
+    } DecisionResultsTable;
+
+    // Wait-free: takes no lock, so cache hits never contend with each other or with a fill.
     HRESULT GetDecisionResults(
         _In_ const IDecision* pDecision,
         _In_ int numResults,
         _Out_writes_(numResults) int* pSetIndexesInDecisionOut,
-        _Out_writes_(numResults) int* pSetIndexesInPoolOut)
+        _Out_writes_(numResults) int* pSetIndexesInPoolOut) const
     {
         int index;
         RETURN_IF_FAILED(pDecision->GetIndex(&index));
 
-        UINT16 offset = 0;
-
-        AutoReaderWriterLock autoLock(&m_srwLock, true);
-        if ((index < 0) || (index >= m_decisionCache.Count()) || (!m_decisionCache.TryGet(index, &offset)) ||
-            ((offset & kDecisionAttemptedMask) == 0))
+        const DecisionResultsTable* pTable =
+            static_cast<const DecisionResultsTable*>(ReadPointerAcquire(reinterpret_cast<PVOID const volatile*>(&m_pDecisionResults)));
+        if ((pTable == nullptr) || (index < 0) || (index >= pTable->numDecisions))
         {
-            // out of range or not attempted
             return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
 
-        // mask off the bit that indicates that the decision was cached
-        offset &= ~kDecisionAttemptedMask;
-
-        int numDecisionResults = pDecision->GetNumQualifierSets();
-        numResults = min(numResults, numDecisionResults);
+        const DecisionResultsBlock* pBlock =
+            static_cast<const DecisionResultsBlock*>(ReadPointerAcquire(reinterpret_cast<PVOID const volatile*>(&pTable->blocks[index])));
+        if (pBlock == nullptr)
+        {
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
 
-        DEF_ASSERT((offset + numResults) <= m_decisionPerSetInfo.Count());
+        LONG64 state = ReadAcquire64(&pBlock->state);
+        if (state != (ReadAcquire64(&m_decisionGeneration) * 2))
+        {
+            // not attempted in this generation, or being written right now
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        }
 
-        const DecisionPerSetInfo* pSets = &m_decisionPerSetInfo.GetAll()[offset];
+        numResults = min(numResults, pBlock->numSets);
         for (int i = 0; (i < numResults); i++)
         {
-            pSetIndexesInDecisionOut[i] = pSets[i].setIndexInDecision;
-            pSetIndexesInPoolOut[i] = pSets[i].setIndexInPool;
+            pSetIndexesInDecisionOut[i] = pBlock->sets[i].setIndexInDecision;
+            pSetIndexesInPoolOut[i] = pBlock->sets[i].setIndexInPool;
+        }
+
+        // The copy must be complete before we confirm that no writer touched the block meanwhile.
+        MemoryBarrier();
+        if (ReadNoFence64(&pBlock->state) != state)
+        {
+            return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
         }
         return S_OK;
     }
 
+    // Comments out below lock held as OACR can't understand ReadWriterLock.
+    // _Requires_lock_held_(ResolverBase::m_srwLock)
     HRESULT
     BeginSetDecisionResults(_In_ const IDecision* pDecision, _Out_writes_(*pNumSetsOut) DecisionPerSetInfo** result, _Out_ int* pNumSetsOut)
     {
@@ -678,51 +852,60 @@ public:
 
         int index;
         RETURN_IF_FAILED(pDecision->GetIndex(&index));
-
-        AutoReaderWriterLock autoLock(&m_srwLock);
         DEF_ASSERT((index >= 0) && (index < m_pDecisions->GetNumDecisions()));
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), index < 0);
 
-        if (index >= m_decisionCache.Count())
-        {
-            // couldn't extend the cache
-            RETURN_IF_FAILED(m_decisionCache.SetExtent(m_pDecisions->GetNumDecisions()));
-        }
+        // If there are no qualifier sets, return with MRM_NO_MATCHING_CANDIDATE
+        int numSets = pDecision->GetNumQualifierSets();
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE), numSets == 0);
 
-        UINT16* pCachedDecision = &m_decisionCache.GetAll()[index];
+        RETURN_IF_FAILED(EnsureDecisionResultsTable(index));
 
-        // We have our entry in the decision cache, now we need to figure
-        // out where the qualifier set data will go.
-        int offset = m_decisionPerSetInfo.Count();
-        int numSets = pDecision->GetNumQualifierSets();
+        DecisionResultsBlock* pBlock = m_pDecisionResults->blocks[index];
+        if (pBlock == nullptr)
+        {
+            pBlock = static_cast<DecisionResultsBlock*>(
+                _DefBlob_AllocZeroed(offsetof(DecisionResultsBlock, sets) + (numSets * sizeof(DecisionPerSetInfo))));
+            RETURN_IF_NULL_ALLOC(pBlock);
+            pBlock->numSets = numSets;
 
-        // If there are no qualifier sets, return with MRM_NO_MATCHING_CANDIDATE
-        // If we can't extend, SetExtent reports the error.
-        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE), numSets == 0);
-        RETURN_IF_FAILED(m_decisionPerSetInfo.SetExtent(offset + numSets));
+            WritePointerRelease(reinterpret_cast<PVOID volatile*>(&m_pDecisionResults->blocks[index]), pBlock);
+        }
+        RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_INVALID_PRI_FILE), pBlock->numSets != numSets);
 
-        DecisionPerSetInfo* pSets = &m_decisionPerSetInfo.GetAll()[offset];
-        SecureZeroMemory(pSets, numSets * sizeof(DecisionPerSetInfo));
+        // Mark the block as being written before touching the results.  This needs a full
+        // barrier so the writes below can't become visible ahead of it.
+        InterlockedExchange64(&pBlock->state, (m_decisionGeneration * 2) + 1);
+
+        SecureZeroMemory(pBlock->sets, numSets * sizeof(DecisionPerSetInfo));
 
-        // Set the offset in the cached decisions, but don't set the attempted bit
-        // until EndDecisionResults
-        *pCachedDecision = static_cast<UINT16>(offset);
         *pNumSetsOut = numSets;
-        *result = pSets;
+        *result = pBlock->sets;
 
         return S_OK;
     }
 
+    // _Requires_lock_held_(ResolverBase::m_srwLock)
     HRESULT EndSetDecisionResults(_In_ const IDecision* pDecision)
     {
         int index;
         RETURN_IF_FAILED(pDecision->GetIndex(&index));
+        DEF_ASSERT((index >= 0) && (m_pDecisionResults != nullptr) && (index < m_pDecisionResults->numDecisions));
 
-        AutoReaderWriterLock autoLock(&m_srwLock);
-        DEF_ASSERT((index >= 0) && (index < m_pDecisions->GetNumDecisions()) && (index < m_decisionCache.Count()));
+        DecisionResultsBlock* pBlock = m_pDecisionResults->blocks[index];
+        RETURN_HR_IF_NULL(E_UNEXPECTED, pBlock);
 
-        UINT16* pCachedDecision = &m_decisionCache.GetAll()[index];
+        pBlock->dependencies = 0;
+        const QualifierSetCacheEntry* pSetEntries = m_qualifierSetCache.GetAll();
+        for (int i = 0; i < pBlock->numSets; i++)
+        {
+            int setIndex = pBlock->sets[i].setIndexInPool;
+            bool known = (setIndex < m_qualifierSetCache.Count()) && pSetEntries[setIndex].attempted;
+            pBlock->dependencies |= (known ? pSetEntries[setIndex].dependencies : AllDependencies);
+        }
 
-        (*pCachedDecision) |= kDecisionAttemptedMask;
+        // Publish the results for the current generation.
+        WriteRelease64(&pBlock->state, m_decisionGeneration * 2);
 
         return S_OK;
     }
@@ -730,7 +913,12 @@ public:
     // Comments out below lock held as OACR can't understand ReadWriterLock.
     // _Requires_lock_held_(ResolverBase::m_srwLock)
     // _Requires_lock_held_(ResolverBase::m_srwQualifierSetLock)
-    int CompareQualifierSetResults(_In_ int setIndexInPool1, _In_ int setIndexInPool2, _Inout_ const IResolver* pResolver)
+    int CompareQualifierSetResults(
+        _In_ int setIndexInPool1,
+        _In_ int setIndexInPool2,
+        _Inout_ const IResolver* pResolver,
+        _In_opt_ const QualifierSetSortKey* pKey1 = nullptr,
+        _In_opt_ const QualifierSetSortKey* pKey2 = nullptr)
     {
         if ((setIndexInPool1 < 0) || (setIndexInPool1 > m_qualifierSetCache.Count() - 1))
         {
@@ -768,7 +956,7 @@ public:
                 if (diff == 0)
                 {
                     diff = (pEntry1->requireComplexResolution == 1 || pEntry2->requireComplexResolution == 1) ?
-                               CompareQualifierSetResultComplex(setIndexInPool1, setIndexInPool2, pResolver) :
+                               CompareQualifierSetResultComplex(setIndexInPool1, setIndexInPool2, pResolver, pKey1, pKey2) :
                                CompareQualifierSetResultDetails(setIndexInPool1, setIndexInPool2, pResolver);
                 }
             }
@@ -785,7 +973,7 @@ public:
             else
             {
                 diff = (pEntry1->requireComplexResolution == 1 || pEntry2->requireComplexResolution == 1) ?
-                           CompareQualifierSetResultComplex(setIndexInPool1, setIndexInPool2, pResolver) :
+                           CompareQualifierSetResultComplex(setIndexInPool1, setIndexInPool2, pResolver, pKey1, pKey2) :
                            CompareQualifierSetResultDetails(setIndexInPool1, setIndexInPool2, pResolver);
             }
         }
@@ -801,6 +989,7 @@ public:
     {
         DecisionInfoCache* pCache;
         const IResolver* pResolver;
+        const QualifierSetSortKey* pKeys; // by index in decision, or null
     } _DecisionSortingInfo;
 
     // helper function for decision results
@@ -809,8 +998,13 @@ public:
         const _DecisionPerSetInfo* pResult1,
         const _DecisionPerSetInfo* pResult2)
     {
+        const QualifierSetSortKey* pKeys = pSortingContextInfo->pKeys;
         int diff = pSortingContextInfo->pCache->CompareQualifierSetResults(
-            pResult1->setIndexInPool, pResult2->setIndexInPool, pSortingContextInfo->pResolver);
+            pResult1->setIndexInPool,
+            pResult2->setIndexInPool,
+            pSortingContextInfo->pResolver,
+            (pKeys != nullptr) ? &pKeys[pResult1->setIndexInDecision] : nullptr,
+            (pKeys != nullptr) ? &pKeys[pResult2->setIndexInDecision] : nullptr);
         // If the two decision results compare identically, position in the decision is the final tie breaker.
         if (diff != 0)
         {
@@ -838,18 +1032,85 @@ protected:
 
     DynamicArray<QualifierCacheEntry> m_qualifierCache;
     DynamicArray<QualifierSetCacheEntry> m_qualifierSetCache;
-    DynamicArray<DecisionPerSetInfo> m_decisionPerSetInfo;
-    DynamicArray<UINT16> m_decisionCache;
+
+    DecisionResultsTable* volatile m_pDecisionResults;
+    volatile LONG64 m_decisionGeneration;
+    Atom::PoolIndex m_dependencyPool; // pool of the qualifier names in the masks
 
     DecisionInfoCache(_In_ const IDecisionInfo* pDecisions, _In_ const UnifiedEnvironment* pEnvironment) :
         m_pDecisions(pDecisions),
         m_pEnvironment(pEnvironment),
         m_qualifierCache(),
         m_qualifierSetCache(),
-        m_decisionPerSetInfo(),
-        m_decisionCache()
+        m_pDecisionResults(nullptr),
+        m_decisionGeneration(1), // zeroed blocks must never look valid
+        m_dependencyPool(Atom::NullPoolIndex)
     {
         ::InitializeSRWLock(&m_srwLock);
+
+        // Resolvers take qualifier names from the default environment's pool, as ProviderResolver does.
+        const IEnvironment* pDefaultEnvironment = ((pEnvironment != nullptr) ? pEnvironment->GetDefaultEnvironment() : nullptr);
+        if ((pDefaultEnvironment != nullptr) && (pDefaultEnvironment->GetQualifierNames() != nullptr))
+        {
+            m_dependencyPool = pDefaultEnvironment->GetQualifierNames()->GetPoolIndex();
+        }
+    }
+
+    UINT64 GetDependencyMask(_In_ Atom qualifierName) const
+    {
+        // Masks only make sense within the single pool of qualifier names.  A name from any
+        // other pool can't be mapped to a bit, so it depends on everything.
+        if ((m_dependencyPool == Atom::NullPoolIndex) || (qualifierName.GetPoolIndex() != m_dependencyPool))
+        {
+            return AllDependencies;
+        }
+
+        int bit = min(static_cast<int>(qualifierName.GetIndex()), OverflowDependencyBit);
+        return (1ULL << bit);
+    }
+
+    UINT64 GetQualifierDependencies(_In_ const IQualifier* pQualifier)
+    {
+        Atom attribute;
+        if (FAILED(pQualifier->GetOperand1Attribute(&attribute)))
+        {
+            return AllDependencies;
+        }
+        UINT64 dependencies = GetDependencyMask(attribute);
+
+        bool isLiteral = true;
+        if (!pQualifier->OperatorIsUnary() && SUCCEEDED(pQualifier->Operand2IsLiteral(&isLiteral)) && !isLiteral)
+        {
+            dependencies |= (SUCCEEDED(pQualifier->GetOperand2Attribute(&attribute)) ? GetDependencyMask(attribute) : AllDependencies);
+        }
+        return dependencies;
+    }
+
+    // _Requires_lock_held_(ResolverBase::m_srwLock)
+    HRESULT EnsureDecisionResultsTable(_In_ int index)
+    {
+        DecisionResultsTable* pOldTable = m_pDecisionResults;
+        if ((pOldTable != nullptr) && (index < pOldTable->numDecisions))
+        {
+            return S_OK;
+        }
+
+        // decision info may have grown since we were initialized
+        int numDecisions = max(m_pDecisions->GetNumDecisions(), index + 1);
+        DecisionResultsTable* pNewTable = static_cast<DecisionResultsTable*>(
+            _DefBlob_AllocZeroed(offsetof(DecisionResultsTable, blocks) + (numDecisions * sizeof(DecisionResultsBlock*))));
+        RETURN_IF_NULL_ALLOC(pNewTable);
+
+        pNewTable->numDecisions = numDecisions;
+        if (pOldTable != nullptr)
+        {
+            CopyMemory(pNewTable->blocks, pOldTable->blocks, pOldTable->numDecisions * sizeof(DecisionResultsBlock*));
+        }
+
+        // Lock-free readers may still be looking at the old table, so keep it until we're destroyed.
+        pNewTable->pRetired = pOldTable;
+        WritePointerRelease(reinterpret_cast<PVOID volatile*>(&m_pDecisionResults), pNewTable);
+        return S_OK;
     }
 
     int CompareQualifierSetResultDetails(_In_ int setIndexInPool1, _In_ int setIndexInPool2, _In_ const IResolver* pResolver)
@@ -994,7 +1255,43 @@ protected:
         return 0;
     }
 
-    int CompareQualifierSetResultComplex(_In_ int setIndexInPool1, _In_ int setIndexInPool2, _In_ const IResolver* resolver)
+    // Comments out below lock held as OACR can't understand ReadWriterLock.
+    // _Requires_lock_held_(ResolverBase::m_srwQualifierSetLock)
+    void BuildQualifierSetSortKey(_In_ int setIndexInPool, _Out_ QualifierSetSortKey* pKeyOut)
+    {
+        QualifierSetComparer comparer;
+        QualifierSetResult set;
+
+        pKeyOut->valid = false;
+        if (SUCCEEDED(m_pDecisions->GetQualifierSet(setIndexInPool, &set)) && SUCCEEDED(FillComparer(&set, &comparer)))
+        {
+            comparer.GetSortKey(pKeyOut);
+        }
+    }
+
+    HRESULT FillComparer(_In_ const QualifierSetResult* pSet, _Inout_ QualifierSetComparer* pComparer)
+    {
+        int q;
+        _QualifierCacheEntry* pQualifiers = m_qualifierCache.GetAll();
+
+        for (int i = 0; i < pSet->GetNumQualifiers(); i++)
+        {
+            if (FAILED(pSet->GetQualifierIndexInPool(i, &q)) || (q < 0) || (q > m_qualifierCache.Count() - 1))
+            {
+                return HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND);
+            }
+
+            pComparer->SetScore(pQualifiers[q].priority, pQualifiers[q].score, pQualifiers[q].fallbackScore);
+        }
+        return S_OK;
+    }
+
+    int CompareQualifierSetResultComplex(
+        _In_ int setIndexInPool1,
+        _In_ int setIndexInPool2,
+        _In_ const IResolver* resolver,
+        _In_opt_ const QualifierSetSortKey* pKey1 = nullptr,
+        _In_opt_ const QualifierSetSortKey* pKey2 = nullptr)
     {
         QualifierSetResult set1;
         QualifierSetResult set2;
@@ -1006,41 +1303,34 @@ protected:
 
         int q1;
         int q2;
-        _QualifierCacheEntry* pQualifiers = m_qualifierCache.GetAll();
-        _QualifierCacheEntry* pQ1;
-        _QualifierCacheEntry* pQ2;
-
-        QualifierSetComparer comparer1;
-        QualifierSetComparer comparer2;
+        int diff = 0;
 
-        for (int i = 0; i < set1.GetNumQualifiers(); i++)
+        // Precomputed keys settle most comparisons with two integer compares.
+        bool haveKeys = (pKey1 != nullptr) && (pKey2 != nullptr) && pKey1->valid && pKey2->valid;
+        if (haveKeys)
         {
-            if (FAILED(set1.GetQualifierIndexInPool(i, &q1)) || (q1 < 0) || (q1 > m_qualifierCache.Count() - 1))
+            diff = CompareSortKeys(pKey1, pKey2);
+            if (diff != 0)
             {
-                return 0;
+                return diff;
             }
-
-            pQ1 = &pQualifiers[q1];
-
-            comparer1.SetScore(pQ1->priority, pQ1->score, pQ1->fallbackScore);
         }
 
-        for (int i = 0; i < set2.GetNumQualifiers(); i++)
+        if (!haveKeys || !pKey1->complete || !pKey2->complete)
         {
-            if (FAILED(set2.GetQualifierIndexInPool(i, &q2)) || (q2 < 0) || (q2 > m_qualifierCache.Count() - 1))
+            QualifierSetComparer comparer1;
+            QualifierSetComparer comparer2;
+
+            if (FAILED(FillComparer(&set1, &comparer1)) || FAILED(FillComparer(&set2, &comparer2)))
             {
                 return 0;
             }
 
-            pQ2 = &pQualifiers[q2];
-
-            comparer2.SetScore(pQ2->priority, pQ2->score, pQ2->fallbackScore);
-        }
-
-        int diff = comparer1.Compare(&comparer2);
-        if (diff != 0)
-        {
-            return diff;
+            diff = comparer1.Compare(&comparer2);
+            if (diff != 0)
+            {
+                return diff;
+            }
         }
 
         // Everything matches. Qualifier type gets to break the tie.
@@ -1095,6 +1385,85 @@ private:
     SRWLOCK m_srwLock;
 };
 
+static void IncrementStatistic(_In_opt_ ResolverStatistics* pStatistics, _In_ LONG64 ResolverStatistics::*pCounter)
+{
+    // Counters only need to be atomic, not ordered with the cache they describe.
+    if (pStatistics != nullptr)
+    {
+        InterlockedIncrementNoFence64(&(pStatistics->*pCounter));
+    }
+}
+
+static LONG64 PerformanceTicksToNanoseconds(_In_ LONG64 ticks)
+{
+    static const LONG64 frequency = []() {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return value.QuadPart;
+    }();
+
+    // split so that the multiplication can't overflow
+    return ((ticks / frequency) * 1000000000) + (((ticks % frequency) * 1000000000) / frequency);
+}
+
+// Times an EvaluateDecision call or the wait for the resolver lock, if statistics are enabled.
+class ResolverBase::StatisticsTimer
+{
+public:
+    enum TimerKind
+    {
+        DecisionLatency,
+        LockWait
+    };
+
+    StatisticsTimer(_In_opt_ ResolverStatistics* pStatistics, _In_ TimerKind kind) : m_pStatistics(pStatistics), m_kind(kind)
+    {
+        if (m_pStatistics != nullptr)
+        {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            m_start = now.QuadPart;
+        }
+    }
+
+    ~StatisticsTimer() { Stop(); }
+
+    void Stop()
+    {
+        if (m_pStatistics == nullptr)
+        {
+            return;
+        }
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        LONG64 elapsed = PerformanceTicksToNanoseconds(now.QuadPart - m_start);
+
+        if (m_kind == LockWait)
+        {
+            InterlockedIncrementNoFence64(&m_pStatistics->lockAcquisitions);
+            InterlockedAddNoFence64(&m_pStatistics->lockWaitNanoseconds, elapsed);
+        }
+        else
+        {
+            int bucket = 0;
+            for (LONG64 microseconds = elapsed / 1000; (microseconds > 0) && (bucket < ResolverStatistics::NumLatencyBuckets - 1);
+                 microseconds >>= 1)
+            {
+                bucket++;
+            }
+            InterlockedIncrementNoFence64(&m_pStatistics->evaluateDecisionLatency[bucket]);
+        }
+
+        m_pStatistics = nullptr;
+    }
+
+private:
+    ResolverStatistics* m_pStatistics;
+    TimerKind m_kind;
+    LONG64 m_start{ 0 };
+};
+
 ResolverBase::ResolverBase(_In_ const UnifiedEnvironment* pEnvironment, _In_ const IDecisionInfo* pDecisions) :
     m_pEnvironment(pEnvironment), m_pDecisions(pDecisions), m_pCache(NULL)
 {
@@ -1103,7 +1472,16 @@ ResolverBase::ResolverBase(_In_ const UnifiedEnvironment* pEnvironment, _In_ con
     ::InitializeSRWLock(&m_srwQualifierLock);
 }
 
-ResolverBase::~ResolverBase() { delete m_pCache; }
+ResolverBase::~ResolverBase()
+{
+    delete m_pCache;
+
+    if (m_pStatistics != nullptr)
+    {
+        Def_Free(m_pStatistics);
+        m_pStatistics = nullptr;
+    }
+}
 
 HRESULT ResolverBase::Init()
 {
@@ -1112,19 +1490,78 @@ HRESULT ResolverBase::Init()
     return S_OK;
 }
 
+HRESULT ResolverBase::EnableStatistics(_In_ bool bEnable)
+{
+    if (bEnable && (m_pStatistics == nullptr))
+    {
+        ResolverStatistics* pStatistics = _DefAllocZeroed(ResolverStatistics);
+        RETURN_IF_NULL_ALLOC(pStatistics);
+
+        if (InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pStatistics), pStatistics, nullptr) != nullptr)
+        {
+            // another thread got there first
+            Def_Free(pStatistics);
+        }
+    }
+
+    m_bStatisticsEnabled = bEnable;
+    return S_OK;
+}
+
+HRESULT ResolverBase::GetStatistics(_Out_ ResolverStatistics* pStatisticsOut) const
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, pStatisticsOut);
+    *pStatisticsOut = {};
+
+    const ResolverStatistics* pStatistics = m_pStatistics;
+    if (pStatistics == nullptr)
+    {
+        return S_OK;
+    }
+
+    // The statistics are all counters, so copy them one at a time.
+    const LONG64* pSource = reinterpret_cast<const LONG64*>(pStatistics);
+    LONG64* pDest = reinterpret_cast<LONG64*>(pStatisticsOut);
+    for (size_t i = 0; i < sizeof(ResolverStatistics) / sizeof(LONG64); i++)
+    {
+        pDest[i] = ReadNoFence64(&pSource[i]);
+    }
+
+    return S_OK;
+}
+
+void ResolverBase::ResetStatistics()
+{
+    ResolverStatistics* pStatistics = m_pStatistics;
+    if (pStatistics != nullptr)
+    {
+        LONG64* pCounters = reinterpret_cast<LONG64*>(pStatistics);
+        for (size_t i = 0; i < sizeof(ResolverStatistics) / sizeof(LONG64); i++)
+        {
+            WriteNoFence64(&pCounters[i], 0);
+        }
+    }
+}
+
 void ResolverBase::Reset()
 {
+    IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::resets);
+
     // Frequent reset during evalueDecision can corrupt the cache.
     // Order is important here, m_srwLock -> m_srwQualifierSetLock -> m_srwQualifierLock.
     // We consider to have separate scope for respective m_srwLock and m_srwQualifierSetLock in future.
+    StatisticsTimer lockTimer(GetActiveStatistics(), StatisticsTimer::LockWait);
     AutoReaderWriterLock autoLock(&m_srwLock);
+    lockTimer.Stop();
     {
         AutoReaderWriterLock autoQualifierSetLock(&m_srwQualifierSetLock); // protect pResults object for potential race condition
         {
             AutoReaderWriterLock autoQualifierLock(&m_srwQualifierLock); // protect pResults object for potential race condit
             {
-                // the cache doesn't do anythnig interesting with per-qualifier reset yet so just reset the whole thing.
+                // Nothing says which qualifiers changed, so drop everything.  Reset(pQualifierNames, ...)
+                // invalidates selectively.
                 m_pCache->Reset();
+                InterlockedIncrement64(&m_generation);
             }
         }
     }
@@ -1135,22 +1572,32 @@ HRESULT ResolverBase::Reset(__in_ecount(numQualifierNames) Atom* pQualifierNames
     RETURN_HR_IF(
         E_INVALIDARG, (pQualifierNames == nullptr) || (numQualifierNames < 1) || (numQualifierNames > m_pDecisions->GetNumQualifiers()));
 
+    InvalidateCachedResults(pQualifierNames, numQualifierNames);
+
+    return S_OK;
+}
+
+void ResolverBase::InvalidateCachedResults(_In_reads_(numQualifierNames) const Atom* pQualifierNames, _In_ int numQualifierNames)
+{
+    IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::partialResets);
+
     // Frequent reset during evalueDecision can corrupt the cache.
     // Order is important here, m_srwLock -> m_srwQualifierSetLock -> m_srwQualifierLock.
     // We consider to have separate scope for respective m_srwLock and m_srwQualifierSetLock in future.
+    StatisticsTimer lockTimer(GetActiveStatistics(), StatisticsTimer::LockWait);
     AutoReaderWriterLock autoLock(&m_srwLock);
+    lockTimer.Stop();
     {
         AutoReaderWriterLock autoQualifierSetLock(&m_srwQualifierSetLock); // protect pResults object for potential race condition
         {
             AutoReaderWriterLock autoQualifierLock(&m_srwQualifierLock); // protect pResults object for potential race condit
             {
-                // the cache doesn't do anythnig interesting with per-qualifier reset yet so just reset the whole thing.
-                m_pCache->Reset();
+                // only drops cached results that depend on one of the named qualifiers
+                m_pCache->Reset(pQualifierNames, numQualifierNames);
+                InterlockedIncrement64(&m_generation);
             }
         }
     }
-
-    return S_OK;
 }
 
 HRESULT ResolverBase::EvaluateQualifier(_In_ const IQualifier* pQualifier, _Out_ double* pScoreOut, _Out_ double* pFallbackScoreOut) const
@@ -1170,13 +1617,26 @@ HRESULT ResolverBase::EvaluateQualifier(_In_ const IQualifier* pQualifier, _Out_
     // Have we seen this qualifier before?
     if (SUCCEEDED(m_pCache->GetQualifierScores(pQualifier, pScoreOut, pFallbackScoreOut)))
     {
+        IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::qualifierHits);
         return S_OK;
     }
 
+    IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::qualifierMisses);
+
     double score = 0.0;
     double fallbackScore;
     RETURN_IF_FAILED(pQualifier->GetFallbackScore(&fallbackScore));
 
+    // Copy-on-write overrides take the score of anything they don't override from their parent,
+    // which is usually a cache hit there.
+    const ResolverBase* pScoreSource = GetQualifierScoreSource(pQualifier);
+    if (pScoreSource != nullptr)
+    {
+        HRESULT hrSource = pScoreSource->EvaluateQualifier(pQualifier, pScoreOut, pFallbackScoreOut);
+        RETURN_IF_FAILED(m_pCache->SetQualifierScores(pQualifier, pQualifier->GetPriority(), *pScoreOut, *pFallbackScoreOut));
+        return hrSource;
+    }
+
     // Nope. Try to evaluate it.
     Atom qualifierName;
     const IBuildQualifierType* pType = NULL;
@@ -1227,9 +1687,12 @@ HRESULT ResolverBase::EvaluateQualifierSet(
     // Have we seen this qualifier set before
     if (SUCCEEDED(m_pCache->GetQualifierSetResults(pQualifierSet, pbIsMatchOut, pbIsDefaultOut, pbIsMatchOrDefaultOut, pScoreOut)))
     {
+        IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::qualifierSetHits);
         return S_OK;
     }
 
+    IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::qualifierSetMisses);
+
     // Nope.  Try to evaluate it.
     bool bIsMatch = true;
     bool bIsDefault = true;
@@ -1317,12 +1780,35 @@ HRESULT ResolverBase::EvaluateDecision(
     _Out_writes_(numResults) int* pResultIndexesOut,
     _Out_writes_(numResults) int* pResultSetIndexesOut) const
 {
+    StatisticsTimer latencyTimer(GetActiveStatistics(), StatisticsTimer::DecisionLatency);
+
+    // Cache hits don't take any lock, so threads sharing a resolver only serialize on a miss.
+    if (SUCCEEDED(m_pCache->GetDecisionResults(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut)))
+    {
+        IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::decisionHits);
+        return S_OK;
+    }
+
+    StatisticsTimer lockTimer(GetActiveStatistics(), StatisticsTimer::LockWait);
     AutoReaderWriterLock autoLock(&m_srwLock); // protect pResults object for potential race condition
+    lockTimer.Stop();
 
+    // Another thread might have filled the entry while we waited for the lock.
     if (SUCCEEDED(m_pCache->GetDecisionResults(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut)))
     {
+        IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::decisionHits);
         return S_OK;
     }
+
+    IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::decisionMisses);
+    RETURN_IF_FAILED(FillDecisionResults(pDecision));
+    RETURN_IF_FAILED(m_pCache->GetDecisionResults(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut));
+
+    return S_OK;
+}
+
+HRESULT ResolverBase::FillDecisionResults(_In_ const IDecision* pDecision) const
+{
     int numSets = 0;
     DecisionInfoCache::DecisionPerSetInfo* pResults;
     RETURN_IF_FAILED(m_pCache->BeginSetDecisionResults(pDecision, &pResults, &numSets));
@@ -1365,9 +1851,29 @@ HRESULT ResolverBase::EvaluateDecision(
 
     // Sort the results so that the matches are prioritized ahead of the fallbacks, ahead of the non-matches
     DEF_ASSERT(nextFailed + 1 == nextMatch);
-    DecisionInfoCache::_DecisionSortingInfo sortingContextInfo = {m_pCache, this};
-
     AutoReaderWriterLock autoQualifierSetLock(&m_srwQualifierSetLock);
+
+    // Sets that need the full comparer get a packed sort key up front, so the sort doesn't
+    // rebuild two comparers for every pair it looks at.
+    unique_deffree_ptr<DecisionInfoCache::QualifierSetSortKey> sortKeys;
+    for (int i = 0; i < numSets; i++)
+    {
+        if (SUCCEEDED(m_pCache->GetQualifierSetCacheEntry(pResults[i].setIndexInPool, &pEntry)) && pEntry->requireComplexResolution)
+        {
+            if (sortKeys.get() == nullptr)
+            {
+                sortKeys.reset(_DefArray_AllocZeroed(DecisionInfoCache::QualifierSetSortKey, numSets));
+                if (sortKeys.get() == nullptr)
+                {
+                    // not fatal, we'll just compare the slow way
+                    break;
+                }
+            }
+            m_pCache->BuildQualifierSetSortKey(pResults[i].setIndexInPool, &sortKeys.get()[pResults[i].setIndexInDecision]);
+        }
+    }
+
+    DecisionInfoCache::_DecisionSortingInfo sortingContextInfo = {m_pCache, this, sortKeys.get()};
     qsort_s(
         pResults,
         numSets,
@@ -1376,8 +1882,376 @@ HRESULT ResolverBase::EvaluateDecision(
         &sortingContextInfo);
     RETURN_IF_FAILED(m_pCache->EndSetDecisionResults(pDecision));
 
-    RETURN_IF_FAILED(m_pCache->GetDecisionResults(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut));
+    return S_OK;
+}
+
+void ResolverBase::EvaluateDecisions(_In_ int numDecisions, _Inout_updates_(numDecisions) DecisionEvaluation* pDecisions) const
+{
+    DecisionResult decision;
+    bool anyMissed = false;
+
+    // Serve everything we can from the cache first, without any lock.
+    for (int i = 0; i < numDecisions; i++)
+    {
+        pDecisions[i].hr = m_pDecisions->GetDecision(pDecisions[i].decisionIndex, &decision);
+        if (SUCCEEDED(pDecisions[i].hr))
+        {
+            pDecisions[i].hr = m_pCache->GetDecisionResults(&decision, 1, &pDecisions[i].resultIndex, &pDecisions[i].setIndexInPool);
+            anyMissed = anyMissed || FAILED(pDecisions[i].hr);
+            if (SUCCEEDED(pDecisions[i].hr))
+            {
+                IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::decisionHits);
+            }
+        }
+    }
+
+    if (!anyMissed)
+    {
+        return;
+    }
+
+    // Fill all of the misses under one acquisition of the lock.
+    StatisticsTimer lockTimer(GetActiveStatistics(), StatisticsTimer::LockWait);
+    AutoReaderWriterLock autoLock(&m_srwLock);
+    lockTimer.Stop();
+    for (int i = 0; i < numDecisions; i++)
+    {
+        if (pDecisions[i].hr != HRESULT_FROM_WIN32(ERROR_NOT_FOUND))
+        {
+            continue;
+        }
+
+        HRESULT hr = m_pDecisions->GetDecision(pDecisions[i].decisionIndex, &decision);
+        if (SUCCEEDED(hr) && FAILED(m_pCache->GetDecisionResults(&decision, 1, &pDecisions[i].resultIndex, &pDecisions[i].setIndexInPool)))
+        {
+            IncrementStatistic(GetActiveStatistics(), &ResolverStatistics::decisionMisses);
+            hr = FillDecisionResults(&decision);
+            if (SUCCEEDED(hr))
+            {
+                hr = m_pCache->GetDecisionResults(&decision, 1, &pDecisions[i].resultIndex, &pDecisions[i].setIndexInPool);
+            }
+        }
+        pDecisions[i].hr = hr;
+    }
+}
+
+typedef struct _BatchResolveEntry
+{
+    int decisionIndex;
+    int position;
+} BatchResolveEntry;
+
+static int __cdecl CompareBatchResolveEntries(_In_ void*, _In_ const void* pEntry1, _In_ const void* pEntry2)
+{
+    const BatchResolveEntry* p1 = static_cast<const BatchResolveEntry*>(pEntry1);
+    const BatchResolveEntry* p2 = static_cast<const BatchResolveEntry*>(pEntry2);
+
+    if (p1->decisionIndex != p2->decisionIndex)
+    {
+        return (p1->decisionIndex < p2->decisionIndex) ? -1 : 1;
+    }
+    return (p1->position < p2->position) ? -1 : ((p1->position > p2->position) ? 1 : 0);
+}
+
+HRESULT ResolverBase::ResolveResources(
+    _In_ const IResourceMapBase* pMap,
+    _In_ int numResources,
+    _In_reads_(numResources) const int* pResourceIndexes,
+    _Out_writes_(numResources) ResourceResolution* pResultsOut,
+    _Inout_updates_opt_(numResources) ResourceCandidateResult* pCandidatesOut) const
+{
+    RETURN_HR_IF(E_INVALIDARG, (pMap == nullptr) || (numResources < 0));
+    RETURN_HR_IF(E_INVALIDARG, (numResources > 0) && ((pResourceIndexes == nullptr) || (pResultsOut == nullptr)));
+
+    if (numResources == 0)
+    {
+        return S_OK;
+    }
+
+    unique_deffree_ptr<BatchResolveEntry> entries(_DefArray_AllocZeroed(BatchResolveEntry, numResources));
+    RETURN_IF_NULL_ALLOC(entries.get());
+
+    // Find the decision for every resource.  Anything outside our decision pool (e.g. the empty
+    // decision) can't be shared, so resolve those directly.
+    NamedResourceResult resource;
+    DecisionResult decision;
+    QualifierSetResult qualifierSet;
+    int numEntries = 0;
+    for (int i = 0; i < numResources; i++)
+    {
+        pResultsOut[i].resourceIndex = pResourceIndexes[i];
+        pResultsOut[i].candidateIndex = -1;
+
+        pResultsOut[i].hr = pMap->GetResourceByIndex(pResourceIndexes[i], &resource);
+        if (SUCCEEDED(pResultsOut[i].hr))
+        {
+            pResultsOut[i].hr = resource.GetDecision(&decision);
+        }
+
+        if (FAILED(pResultsOut[i].hr))
+        {
+            continue;
+        }
+
+        if ((decision.GetPool() == m_pDecisions) && (decision.GetIndex() >= 0))
+        {
+            entries.get()[numEntries].decisionIndex = decision.GetIndex();
+            entries.get()[numEntries].position = i;
+            numEntries++;
+        }
+        else
+        {
+            pResultsOut[i].hr = EvaluateDecision(&decision, &pResultsOut[i].candidateIndex, &qualifierSet);
+            if (SUCCEEDED(pResultsOut[i].hr))
+            {
+                bool isMatch, isDefault, isMatchOrDefault;
+                pResultsOut[i].hr = EvaluateQualifierSet(&qualifierSet, &isMatch, &isDefault, &isMatchOrDefault, nullptr);
+                if (SUCCEEDED(pResultsOut[i].hr) && !isMatch && !isDefault)
+                {
+                    pResultsOut[i].hr = HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE);
+                }
+            }
+        }
+    }
+
+    // Group resources by decision so each decision is evaluated once.
+    qsort_s(entries.get(), numEntries, sizeof(BatchResolveEntry), CompareBatchResolveEntries, nullptr);
+
+    int numDecisions = 0;
+    for (int i = 0; i < numEntries; i++)
+    {
+        if ((i == 0) || (entries.get()[i].decisionIndex != entries.get()[i - 1].decisionIndex))
+        {
+            numDecisions++;
+        }
+    }
+
+    unique_deffree_ptr<DecisionEvaluation> evaluations;
+    if (numDecisions > 0)
+    {
+        evaluations.reset(_DefArray_AllocZeroed(DecisionEvaluation, numDecisions));
+        RETURN_IF_NULL_ALLOC(evaluations.get());
+    }
+
+    for (int i = 0, next = 0; i < numEntries; i++)
+    {
+        if ((i == 0) || (entries.get()[i].decisionIndex != entries.get()[i - 1].decisionIndex))
+        {
+            evaluations.get()[next++].decisionIndex = entries.get()[i].decisionIndex;
+        }
+    }
+
+    EvaluateDecisions(numDecisions, evaluations.get());
+
+    // Check each winner for match or default once, then hand it to every resource that shares it.
+    DecisionEvaluation* pEvaluation = nullptr;
+    HRESULT hrDecision = S_OK;
+    for (int i = 0, next = 0; i < numEntries; i++)
+    {
+        if ((i == 0) || (entries.get()[i].decisionIndex != entries.get()[i - 1].decisionIndex))
+        {
+            pEvaluation = &evaluations.get()[next++];
+            hrDecision = pEvaluation->hr;
+            if (SUCCEEDED(hrDecision))
+            {
+                hrDecision = m_pDecisions->GetQualifierSet(pEvaluation->setIndexInPool, &qualifierSet);
+            }
+            if (SUCCEEDED(hrDecision))
+            {
+                bool isMatch, isDefault, isMatchOrDefault;
+                hrDecision = EvaluateQualifierSet(&qualifierSet, &isMatch, &isDefault, &isMatchOrDefault, nullptr);
+                if (SUCCEEDED(hrDecision) && !isMatch && !isDefault)
+                {
+                    hrDecision = HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE);
+                }
+            }
+        }
+
+        ResourceResolution* pResult = &pResultsOut[entries.get()[i].position];
+        pResult->candidateIndex = (SUCCEEDED(pEvaluation->hr) ? pEvaluation->resultIndex : -1);
+        pResult->hr = hrDecision;
+    }
+
+    if (pCandidatesOut != nullptr)
+    {
+        for (int i = 0; i < numResources; i++)
+        {
+            if ((pResultsOut[i].candidateIndex >= 0) && SUCCEEDED(pResultsOut[i].hr))
+            {
+                pResultsOut[i].hr = pMap->GetResourceByIndex(pResultsOut[i].resourceIndex, &resource);
+                if (SUCCEEDED(pResultsOut[i].hr))
+                {
+                    pResultsOut[i].hr = resource.GetCandidate(pResultsOut[i].candidateIndex, &pCandidatesOut[i]);
+                }
+            }
+        }
+    }
+
+    return S_OK;
+}
+
+HRESULT ResolverBase::ResolveResources(
+    _In_ const IResourceMapBase* pMap,
+    _In_ int numResources,
+    _In_reads_(numResources) const PCWSTR* pResourceNames,
+    _Out_writes_(numResources) ResourceResolution* pResultsOut,
+    _Inout_updates_opt_(numResources) ResourceCandidateResult* pCandidatesOut) const
+{
+    RETURN_HR_IF(E_INVALIDARG, (pMap == nullptr) || (numResources < 0));
+    RETURN_HR_IF(E_INVALIDARG, (numResources > 0) && ((pResourceNames == nullptr) || (pResultsOut == nullptr)));
+
+    if (numResources == 0)
+    {
+        return S_OK;
+    }
+
+    unique_deffree_ptr<int> indexes(_DefArray_AllocZeroed(int, numResources));
+    RETURN_IF_NULL_ALLOC(indexes.get());
+
+    NamedResourceResult resource;
+    for (int i = 0; i < numResources; i++)
+    {
+        HRESULT hr = (pResourceNames[i] != nullptr) ? pMap->GetResource(pResourceNames[i], &resource) : E_INVALIDARG;
+        indexes.get()[i] = (SUCCEEDED(hr) ? resource.GetResourceIndexInSchema() : -1);
+        pResultsOut[i].hr = hr;
+    }
+
+    // Keep the lookup failures; the index based resolve would only report a bad index.
+    unique_deffree_ptr<HRESULT> lookupResults(_DefArray_AllocZeroed(HRESULT, numResources));
+    RETURN_IF_NULL_ALLOC(lookupResults.get());
+    for (int i = 0; i < numResources; i++)
+    {
+        lookupResults.get()[i] = pResultsOut[i].hr;
+    }
+
+    RETURN_IF_FAILED(ResolveResources(pMap, numResources, indexes.get(), pResultsOut, pCandidatesOut));
+
+    for (int i = 0; i < numResources; i++)
+    {
+        if (FAILED(lookupResults.get()[i]))
+        {
+            pResultsOut[i].resourceIndex = -1;
+            pResultsOut[i].candidateIndex = -1;
+            pResultsOut[i].hr = lookupResults.get()[i];
+        }
+    }
+
+    return S_OK;
+}
+
+HRESULT ResolverBase::CreateResolutionSnapshot(_In_ const IResourceMapBase* pMap, _Outptr_ ResolutionSnapshot** result) const
+{
+    return ResolutionSnapshot::CreateInstance(this, pMap, result);
+}
+
+ResolutionSnapshot::ResolutionSnapshot(_In_ const IResolver* pResolver, _In_ const IResourceMapBase* pMap) :
+    m_pResolver(pResolver), m_pMap(pMap)
+{}
+
+ResolutionSnapshot::~ResolutionSnapshot()
+{
+    Def_Free(m_pCandidates);
+    m_pCandidates = nullptr;
+}
+
+HRESULT ResolutionSnapshot::CreateInstance(_In_ const IResolver* pResolver, _In_ const IResourceMapBase* pMap, _Outptr_ ResolutionSnapshot** result)
+{
+    *result = nullptr;
+    RETURN_HR_IF(E_INVALIDARG, (pResolver == nullptr) || (pMap == nullptr));
+
+    AutoDeletePtr<ResolutionSnapshot> pRtrn = new ResolutionSnapshot(pResolver, pMap);
+    RETURN_IF_NULL_ALLOC(pRtrn);
+    RETURN_IF_FAILED(pRtrn->Init());
+
+    *result = pRtrn.Detach();
+    return S_OK;
+}
+
+UINT64 ResolutionSnapshot::GetContextGeneration(_In_ const IResolver* pResolver)
+{
+    // Generations only ever grow, so the sum changes whenever any resolver in the chain is reset.
+    UINT64 generation = 0;
+    for (const IResolver* pCurrent = pResolver; pCurrent != nullptr; pCurrent = pCurrent->GetParent())
+    {
+        generation += pCurrent->GetGeneration();
+    }
+    return generation;
+}
+
+HRESULT ResolutionSnapshot::Init()
+{
+    // Read the generation first; if the context changes while we're building, the snapshot is simply stale.
+    m_generation = GetContextGeneration(m_pResolver);
+
+    m_numResources = m_pMap->GetNumResources();
+    if (m_numResources > 0)
+    {
+        m_pCandidates = _DefArray_AllocZeroed(int, m_numResources);
+        RETURN_IF_NULL_ALLOC(m_pCandidates);
+    }
+
+    // Many resources share a decision, so evaluate each decision at most once.  Entries are
+    // the winning index + 1, with 0 meaning "not evaluated yet".
+    const IDecisionInfo* pDecisions = m_pResolver->GetDecisions();
+    int numDecisions = pDecisions->GetNumDecisions();
+    unique_deffree_ptr<int> decisionResults;
+    if (numDecisions > 0)
+    {
+        decisionResults.reset(_DefArray_AllocZeroed(int, numDecisions));
+        RETURN_IF_NULL_ALLOC(decisionResults.get());
+    }
+
+    NamedResourceResult resource;
+    DecisionResult decision;
+    QualifierSetResult qualifierSet;
+    for (int i = 0; i < m_numResources; i++)
+    {
+        m_pCandidates[i] = NoCandidate;
+        if (FAILED(m_pMap->GetResourceByIndex(i, &resource)) || FAILED(resource.GetDecision(&decision)))
+        {
+            continue;
+        }
+
+        int decisionIndex = decision.GetIndex();
+        bool canMemoize = (decision.GetPool() == pDecisions) && (decisionIndex >= 0) && (decisionIndex < numDecisions);
+        if (canMemoize && (decisionResults.get()[decisionIndex] != 0))
+        {
+            m_pCandidates[i] = decisionResults.get()[decisionIndex] - 1;
+            continue;
+        }
+
+        // A winner that is neither a match nor a default can't be used, just as in GetResource.
+        int resultIndex;
+        int setIndexInPool;
+        bool isMatch, isDefault, isMatchOrDefault;
+        if (FAILED(m_pResolver->EvaluateDecision(&decision, 1, &resultIndex, &setIndexInPool)) ||
+            FAILED(decision.GetPool()->GetQualifierSet(setIndexInPool, &qualifierSet)) ||
+            FAILED(m_pResolver->EvaluateQualifierSet(&qualifierSet, &isMatch, &isDefault, &isMatchOrDefault, nullptr)) ||
+            (!isMatch && !isDefault))
+        {
+            resultIndex = NoCandidate;
+        }
+
+        m_pCandidates[i] = resultIndex;
+        if (canMemoize)
+        {
+            decisionResults.get()[decisionIndex] = resultIndex + 1;
+        }
+    }
+
+    return S_OK;
+}
+
+HRESULT ResolutionSnapshot::GetCandidateIndex(_In_ int resourceIndex, _Out_ int* pCandidateIndexOut) const
+{
+    *pCandidateIndexOut = NoCandidate;
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (resourceIndex < 0) || (resourceIndex >= m_numResources));
+    RETURN_HR_IF(E_DEF_NOT_READY, !IsCurrent());
 
+    int candidateIndex = m_pCandidates[resourceIndex];
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_MRM_NO_MATCH_OR_DEFAULT_CANDIDATE), candidateIndex == NoCandidate);
+
+    *pCandidateIndexOut = candidateIndex;
     return S_OK;
 }
 
@@ -1729,6 +2603,8 @@ HRESULT ProviderResolver::SetQualifier(_In_ Atom qualifier, _In_ PCWSTR pNewValu
     (void)Reset(&qualifier, 1);
 
     RETURN_IF_FAILED(m_pQualifiers->SetQualifierValue(qualifier, pNewValue, true));
+    // Drop anything evaluated against the old value between the reset and the new value becoming visible.
+    InvalidateCachedResults(&qualifier, 1);
 
     return S_OK;
 }
@@ -1834,6 +2710,13 @@ public:
         DEF_ASSERT((atom.GetPoolIndex() == m_pPool->GetPoolIndex()) && (atom.GetIndex() < m_cacheSize));
         DEF_ASSERT(atom.GetIndex() < 32); // don't overflow m_ownedProviders
 
+        // Most overrides never set a value, so the storage is only allocated on first use.
+        if (m_pCachedValues == NULL)
+        {
+            m_pCachedValues = new StringResult[m_cacheSize];
+            RETURN_IF_NULL_ALLOC(m_pCachedValues);
+        }
+
         if (bCopy)
         {
             RETURN_IF_FAILED(m_pCachedValues[atom.GetIndex()].SetCopy(pValue));
@@ -1867,13 +2750,7 @@ protected:
         ::InitializeSRWLock(&m_srwLock);
     }
 
-    HRESULT Init()
-    {
-        m_pCachedValues = new StringResult[m_cacheSize];
-        RETURN_IF_NULL_ALLOC(m_pCachedValues);
-
-        return S_OK;
-    }
+    HRESULT Init() { return S_OK; }
 };
 
 HRESULT OverrideResolver::CreateInstance(_In_ const IResolver* pParent, _Outptr_ OverrideResolver** result)
@@ -1909,6 +2786,22 @@ HRESULT OverrideResolver::CreateInstance(
     return S_OK;
 }
 
+HRESULT OverrideResolver::CreateCopyOnWriteInstance(_In_ const ResolverBase* pParent, _Outptr_ OverrideResolver** result)
+{
+    *result = nullptr;
+    RETURN_HR_IF_NULL(E_INVALIDARG, pParent);
+
+    // Starts out sharing everything with the parent; SetQualifier gives it a score cache of its own.
+    AutoDeletePtr<OverrideResolver> pRtrn = new OverrideResolver(pParent, false);
+    RETURN_IF_NULL_ALLOC(pRtrn);
+    pRtrn->m_pScoreSource = pParent;
+    RETURN_IF_FAILED(pRtrn->Init());
+
+    *result = pRtrn.Detach();
+
+    return S_OK;
+}
+
 OverrideResolver::OverrideResolver(_In_ const IResolver* pParent) :
     ResolverBase(pParent->GetEnvironment(), pParent->GetDecisions()),
     m_pParent(pParent),
@@ -2006,6 +2899,8 @@ HRESULT OverrideResolver::SetQualifier(_In_ Atom qualifier, _In_ PCWSTR pNewValu
     // Once Resolver has its unique value, it will have its own score cache.
     m_bHasScoreCache = true;
     RETURN_IF_FAILED(m_pQualifiers->SetQualifierValue(qualifier, pNewValue, true));
+    // Drop anything evaluated against the old value between the reset and the new value becoming visible.
+    InvalidateCachedResults(&qualifier, 1);
 
     return S_OK;
 }
@@ -2132,6 +3027,60 @@ HRESULT OverrideResolver::EvaluateDecision(
     return m_pParent->EvaluateDecision(pDecision, numResults, pResultIndexesOut, pResultSetIndexesOut);
 }
 
+void OverrideResolver::EvaluateDecisions(_In_ int numDecisions, _Inout_updates_(numDecisions) DecisionEvaluation* pDecisions) const
+{
+    if (m_bHasScoreCache)
+    {
+        return ResolverBase::EvaluateDecisions(numDecisions, pDecisions);
+    }
+
+    // We share the parent's results, so let it do the work one decision at a time; hits are lock-free.
+    DecisionResult decision;
+    for (int i = 0; i < numDecisions; i++)
+    {
+        pDecisions[i].hr = m_pDecisions->GetDecision(pDecisions[i].decisionIndex, &decision);
+        if (SUCCEEDED(pDecisions[i].hr))
+        {
+            pDecisions[i].hr = m_pParent->EvaluateDecision(&decision, 1, &pDecisions[i].resultIndex, &pDecisions[i].setIndexInPool);
+        }
+    }
+}
+
+const ResolverBase* OverrideResolver::GetQualifierScoreSource(_In_ const IQualifier* pQualifier) const
+{
+    if (m_pScoreSource == nullptr)
+    {
+        return nullptr;
+    }
+
+    // Only share scores that can't depend on a value we override.
+    auto isOverridden = [this](Atom attribute) {
+        return (attribute.GetPoolIndex() != m_pQualifiers->GetPoolIndex()) || IsQualifierValueOverriden(attribute);
+    };
+
+    Atom attribute;
+    if (FAILED(pQualifier->GetOperand1Attribute(&attribute)) || isOverridden(attribute))
+    {
+        return nullptr;
+    }
+
+    if (!pQualifier->OperatorIsUnary())
+    {
+        bool isLiteral = false;
+        if (FAILED(pQualifier->Operand2IsLiteral(&isLiteral)))
+        {
+            return nullptr;
+        }
+
+        if (!isLiteral && (FAILED(pQualifier->GetOperand2Attribute(&attribute)) || isOverridden(attribute)))
+        {
+            return nullptr;
+        }
+    }
+
+    return m_pScoreSource;
+}
+
 HRESULT OverrideResolver::EvaluateQualifierSet(
     _In_ const IQualifierSet* pQualifierSet,
     _Out_ bool* pbIsMatchOut,
@@ -2194,4 +3143,400 @@ HRESULT OverrideResolver::GetQualifierProvider(_In_ PCWSTR qualifierName, _Out_
     return m_pParent->GetQualifierProvider(qualifierName, provider);
 }
 
+MultiContextResolver::MultiContextResolver(_In_ const IResolver* pParent, _In_ int numContexts) :
+    m_pParent(pParent), m_numContexts(numContexts), m_valueClasses(), m_qualifierScoresShared()
+{
+    ::InitializeSRWLock(&m_srwLock);
+}
+
+MultiContextResolver::~MultiContextResolver()
+{
+    ResetSharedResults();
+
+    if (m_ppContexts != nullptr)
+    {
+        for (int i = 0; i < m_numContexts; i++)
+        {
+            delete m_ppContexts[i];
+        }
+        Def_Free(m_ppContexts);
+        m_ppContexts = nullptr;
+    }
+
+    delete[] m_pScratchValues;
+    m_pScratchValues = nullptr;
+    Def_Free(m_pScratchOrder);
+    m_pScratchOrder = nullptr;
+}
+
+HRESULT MultiContextResolver::CreateInstance(_In_ const IResolver* pParent, _In_ int numContexts, _Outptr_ MultiContextResolver** result)
+{
+    *result = nullptr;
+    RETURN_HR_IF_NULL(E_INVALIDARG, pParent);
+    RETURN_HR_IF(E_INVALIDARG, numContexts < 1);
+
+    AutoDeletePtr<MultiContextResolver> pRtrn = new MultiContextResolver(pParent, numContexts);
+    RETURN_IF_NULL_ALLOC(pRtrn);
+    RETURN_IF_FAILED(pRtrn->Init());
+
+    *result = pRtrn.Detach();
+    return S_OK;
+}
+
+HRESULT MultiContextResolver::Init()
+{
+    m_ppContexts = _DefArray_AllocZeroed(OverrideResolver*, m_numContexts);
+    RETURN_IF_NULL_ALLOC(m_ppContexts);
+
+    for (int i = 0; i < m_numContexts; i++)
+    {
+        RETURN_IF_FAILED(OverrideResolver::CreateInstance(m_pParent, &m_ppContexts[i]));
+    }
+
+    m_pScratchValues = new StringResult[m_numContexts];
+    RETURN_IF_NULL_ALLOC(m_pScratchValues);
+    m_pScratchOrder = _DefArray_AllocZeroed(int, m_numContexts);
+    RETURN_IF_NULL_ALLOC(m_pScratchOrder);
+
+    m_parentGeneration = ResolutionSnapshot::GetContextGeneration(m_pParent);
+    return S_OK;
+}
+
+const IResolver* MultiContextResolver::GetContext(_In_ int contextIndex) const
+{
+    return ((contextIndex >= 0) && (contextIndex < m_numContexts)) ? m_ppContexts[contextIndex] : nullptr;
+}
+
+HRESULT MultiContextResolver::SetQualifier(_In_ int contextIndex, _In_ PCWSTR pQualifierName, _In_ PCWSTR pNewValue)
+{
+    RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_RANGE_NOT_FOUND), (contextIndex < 0) || (contextIndex >= m_numContexts));
+
+    AutoReaderWriterLock autoLock(&m_srwLock);
+    RETURN_IF_FAILED(m_ppContexts[contextIndex]->SetQualifier(pQualifierName, pNewValue));
+    ResetSharedResults();
+
+    return S_OK;
+}
+
+void MultiContextResolver::ResetSharedResults() const
+{
+    // Clear the entries too; extending the arrays later doesn't zero them.
+    ValueClasses** ppClasses = m_valueClasses.GetAll();
+    for (UINT i = 0; i < m_valueClasses.Count(); i++)
+    {
+        Def_Free(ppClasses[i]);
+        ppClasses[i] = nullptr;
+    }
+    m_valueClasses.Reset();
+
+    if (m_qualifierScoresShared.Count() > 0)
+    {
+        ZeroMemory(m_qualifierScoresShared.GetAll(), m_qualifierScoresShared.Count() * sizeof(UINT8));
+    }
+    m_qualifierScoresShared.Reset();
+}
+
+HRESULT MultiContextResolver::GetValueClasses(_In_ Atom qualifierName, _Outptr_ const ValueClasses** result) const
+{
+    *result = nullptr;
+
+    ValueClasses* pClasses = nullptr;
+    if (m_valueClasses.TryGet(qualifierName.GetIndex(), &pClasses) && (pClasses != nullptr))
+    {
+        *result = pClasses;
+        return S_OK;
+    }
+
+    pClasses = static_cast<ValueClasses*>(_DefBlob_AllocZeroed(offsetof(ValueClasses, values) + (2 * m_numContexts * sizeof(int))));
+    RETURN_IF_NULL_ALLOC(pClasses);
+
+    int* pClassOfContext = pClasses->values;
+    int* pFirstOfClass = &pClasses->values[m_numContexts];
+    for (int i = 0; i < m_numContexts; i++)
+    {
+        // A context without a value is its own class of "no value".
+        StringResult* pValue = &m_pScratchValues[i];
+        if (FAILED(m_ppContexts[i]->GetQualifierValue(qualifierName, pValue)))
+        {
+            (void)pValue->SetRef(nullptr);
+        }
+
+        int c = 0;
+        for (; c < pClasses->numClasses; c++)
+        {
+            PCWSTR pOther = m_pScratchValues[pFirstOfClass[c]].GetRef();
+            if ((pValue->GetRef() == nullptr) ? (pOther == nullptr) :
+                                                 ((pOther != nullptr) && (DefString_Compare(pValue->GetRef(), pOther) == Def_Equal)))
+            {
+                break;
+            }
+        }
+
+        if (c == pClasses->numClasses)
+        {
+            pFirstOfClass[pClasses->numClasses++] = i;
+        }
+        pClassOfContext[i] = c;
+    }
+
+    HRESULT hr = m_valueClasses.ExtendAndSet(qualifierName.GetIndex(), pClasses);
+    if (FAILED(hr))
+    {
+        Def_Free(pClasses);
+        return hr;
+    }
+
+    *result = pClasses;
+    return S_OK;
+}
+
+HRESULT MultiContextResolver::ShareQualifierScores(_In_ const IQualifier* pQualifier, _In_ int qualifierIndexInPool) const
+{
+    UINT8 shared = 0;
+    if (m_qualifierScoresShared.TryGet(qualifierIndexInPool, &shared) && shared)
+    {
+        return S_OK;
+    }
+
+    Atom qualifierName;
+    const ValueClasses* pClasses;
+    RETURN_IF_FAILED(pQualifier->GetOperand1Attribute(&qualifierName));
+    RETURN_IF_FAILED(GetValueClasses(qualifierName, &pClasses));
+
+    // Score once per distinct value, in the first context that has it, then hand the
+    // score to every other context with the same value.
+    const int* pClassOfContext = pClasses->values;
+    const int* pFirstOfClass = &pClasses->values[m_numContexts];
+    for (int c = 0; c < pClasses->numClasses; c++)
+    {
+        const ResolverBase* pFirst = m_ppContexts[pFirstOfClass[c]];
+        UINT16 score;
+        UINT16 fallbackScore;
+        if (FAILED(pFirst->EvaluateQualifier(pQualifier, &score, &fallbackScore)))
+        {
+            // leave it to each context to evaluate for itself
+            continue;
+        }
+
+        for (int i = pFirstOfClass[c] + 1; i < m_numContexts; i++)
+        {
+            if (pClassOfContext[i] == c)
+            {
+                const ResolverBase* pContext = m_ppContexts[i];
+                RETURN_IF_FAILED(pContext->m_pCache->SetQualifierScores(pQualifier, pQualifier->GetPriority(), score, fallbackScore));
+            }
+        }
+    }
+
+    RETURN_IF_FAILED(m_qualifierScoresShared.ExtendAndSet(qualifierIndexInPool, 1));
+    return S_OK;
+}
+
+typedef struct _ContextSignatureInfo
+{
+    const int* const* ppClassOfContext; // one array per qualifier the decision depends on
+    int numQualifiers;
+} ContextSignatureInfo;
+
+// Compares two contexts by their value class for each qualifier a decision depends on.
+// Contexts that compare equal must produce the same ranking.
+static int CompareContextSignatures(_In_ const ContextSignatureInfo* pInfo, _In_ int context1, _In_ int context2)
+{
+    for (int i = 0; i < pInfo->numQualifiers; i++)
+    {
+        const int* pClassOfContext = pInfo->ppClassOfContext[i];
+        if (pClassOfContext[context1] != pClassOfContext[context2])
+        {
+            return (pClassOfContext[context1] < pClassOfContext[context2]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static int __cdecl ContextSignatureSorter(_In_ void* context, _In_ const void* pContext1, _In_ const void* pContext2)
+{
+    int context1 = *static_cast<const int*>(pContext1);
+    int context2 = *static_cast<const int*>(pContext2);
+
+    int diff = CompareContextSignatures(static_cast<const ContextSignatureInfo*>(context), context1, context2);
+    if (diff != 0)
+    {
+        return diff;
+    }
+    return (context1 < context2) ? -1 : ((context1 > context2) ? 1 : 0);
+}
+
+HRESULT MultiContextResolver::EvaluateDecision(
+    _In_ const IDecision* pDecision,
+    _Out_writes_(m_numContexts) int* pResultIndexesOut,
+    _Out_writes_(m_numContexts) int* pResultSetIndexesOut) const
+{
+    RETURN_HR_IF_NULL(E_INVALIDARG, pDecision);
+
+    AutoReaderWriterLock autoLock(&m_srwLock);
+
+    // Contexts inherit anything they don't override from the parent, so start over if it changed.
+    UINT64 parentGeneration = ResolutionSnapshot::GetContextGeneration(m_pParent);
+    if (parentGeneration != m_parentGeneration)
+    {
+        for (int i = 0; i < m_numContexts; i++)
+        {
+            m_ppContexts[i]->Reset();
+        }
+        ResetSharedResults();
+        m_parentGeneration = parentGeneration;
+    }
+
+    // Score every qualifier in the decision once per distinct value, and note which
+    // qualifiers the decision depends on.  If anything can't be attributed to a qualifier,
+    // fall back to ranking in every context.
+    DynamicArray<const int*> dependencies;
+    QualifierSetResult qualifierSet;
+    QualifierResult qualifier;
+    bool canShare = true;
+    for (int i = 0; (i < pDecision->GetNumQualifierSets()) && canShare; i++)
+    {
+        canShare = SUCCEEDED(pDecision->GetQualifierSet(i, &qualifierSet));
+        for (int j = 0; (j < qualifierSet.GetNumQualifiers()) && canShare; j++)
+        {
+            int indexInPool;
+            Atom qualifierName;
+            const ValueClasses* pClasses = nullptr;
+            bool operand2IsLiteral = true;
+            canShare = SUCCEEDED(qualifierSet.GetQualifier(j, &qualifier, &indexInPool)) &&
+                       (qualifier.OperatorIsUnary() || (SUCCEEDED(qualifier.Operand2IsLiteral(&operand2IsLiteral)) && operand2IsLiteral)) &&
+                       SUCCEEDED(qualifier.GetOperand1Attribute(&qualifierName)) && SUCCEEDED(GetValueClasses(qualifierName, &pClasses)) &&
+                       SUCCEEDED(ShareQualifierScores(&qualifier, indexInPool));
+
+            bool found = !canShare;
+            for (UINT k = 0; (k < dependencies.Count()) && !found; k++)
+            {
+                found = (dependencies.GetAll()[k] == pClasses->values);
+            }
+            if (!found)
+            {
+                RETURN_IF_FAILED(dependencies.Add(pClasses->values));
+            }
+        }
+    }
+
+    for (int i = 0; i < m_numContexts; i++)
+    {
+        m_pScratchOrder[i] = i;
+    }
+
+    if (!canShare)
+    {
+        for (int i = 0; i < m_numContexts; i++)
+        {
+            if (FAILED(m_ppContexts[i]->EvaluateDecision(pDecision, 1, &pResultIndexesOut[i], &pResultSetIndexesOut[i])))
+            {
+                pResultIndexesOut[i] = pResultSetIndexesOut[i] = -1;
+            }
+        }
+        return S_OK;
+    }
+
+    ContextSignatureInfo signatureInfo = {dependencies.GetAll(), static_cast<int>(dependencies.Count())};
+    qsort_s(m_pScratchOrder, m_numContexts, sizeof(int), ContextSignatureSorter, &signatureInfo);
+
+    // Rank once per run of contexts with identical values and copy the answer to the rest.
+    for (int start = 0; start < m_numContexts;)
+    {
+        int first = m_pScratchOrder[start];
+        int resultIndex;
+        int setIndexInPool;
+        if (FAILED(m_ppContexts[first]->EvaluateDecision(pDecision, 1, &resultIndex, &setIndexInPool)))
+        {
+            resultIndex = setIndexInPool = -1;
+        }
+
+        int end = start;
+        do
+        {
+            pResultIndexesOut[m_pScratchOrder[end]] = resultIndex;
+            pResultSetIndexesOut[m_pScratchOrder[end]] = setIndexInPool;
+            end++;
+        } while ((end < m_numContexts) && (CompareContextSignatures(&signatureInfo, first, m_pScratchOrder[end]) == 0));
+        start = end;
+    }
+
+    return S_OK;
+}
+
+HRESULT MultiContextResolver::ResolveResources(
+    _In_ const IResourceMapBase* pMap,
+    _In_ int numResources,
+    _In_reads_(numResources) const int* pResourceIndexes,
+    _Out_writes_(numResources* m_numContexts) int* pCandidateIndexesOut) const
+{
+    RETURN_HR_IF(E_INVALIDARG, (pMap == nullptr) || (numResources < 0));
+    RETURN_HR_IF(E_INVALIDARG, (numResources > 0) && ((pResourceIndexes == nullptr) || (pCandidateIndexesOut == nullptr)));
+
+    if (numResources == 0)
+    {
+        return S_OK;
+    }
+
+    unique_deffree_ptr<int> setIndexes(_DefArray_AllocZeroed(int, m_numContexts));
+    RETURN_IF_NULL_ALLOC(setIndexes.get());
+
+    // Many resources share a decision; remember the first row that holds each decision's results
+    // (+1, so 0 means "not evaluated yet").
+    const IDecisionInfo* pDecisions = m_pParent->GetDecisions();
+    int numDecisions = pDecisions->GetNumDecisions();
+    unique_deffree_ptr<int> decisionRows;
+    if (numDecisions > 0)
+    {
+        decisionRows.reset(_DefArray_AllocZeroed(int, numDecisions));
+        RETURN_IF_NULL_ALLOC(decisionRows.get());
+    }
+
+    NamedResourceResult resource;
+    DecisionResult decision;
+    QualifierSetResult qualifierSet;
+    for (int i = 0; i < numResources; i++)
+    {
+        int* pRow = &pCandidateIndexesOut[i * m_numContexts];
+        if (FAILED(pMap->GetResourceByIndex(pResourceIndexes[i], &resource)) || FAILED(resource.GetDecision(&decision)))
+        {
+            for (int j = 0; j < m_numContexts; j++)
+            {
+                pRow[j] = -1;
+            }
+            continue;
+        }
+
+        int decisionIndex = decision.GetIndex();
+        bool canMemoize = (decision.GetPool() == pDecisions) && (decisionIndex >= 0) && (decisionIndex < numDecisions);
+        if (canMemoize && (decisionRows.get()[decisionIndex] != 0))
+        {
+            CopyMemory(pRow, &pCandidateIndexesOut[(decisionRows.get()[decisionIndex] - 1) * m_numContexts], m_numContexts * sizeof(int));
+            continue;
+        }
+
+        RETURN_IF_FAILED(EvaluateDecision(&decision, pRow, setIndexes.get()));
+
+        // As with a single context, a winner that is neither a match nor a default can't be used.
+        for (int j = 0; j < m_numContexts; j++)
+        {
+            bool isMatch, isDefault, isMatchOrDefault;
+            if ((pRow[j] >= 0) &&
+                (FAILED(decision.GetPool()->GetQualifierSet(setIndexes.get()[j], &qualifierSet)) ||
+                 FAILED(m_ppContexts[j]->EvaluateQualifierSet(&qualifierSet, &isMatch, &isDefault, &isMatchOrDefault, nullptr)) ||
+                 (!isMatch && !isDefault)))
+            {
+                pRow[j] = -1;
+            }
+        }
+
+        if (canMemoize)
+        {
+            decisionRows.get()[decisionIndex] = i + 1;
+        }
+    }
+
+    return S_OK;
+}
+
 } // namespace Microsoft::Resources
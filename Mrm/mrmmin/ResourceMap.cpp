@@ -1197,6 +1197,14 @@ HRESULT ResourceMapSubtree::GetResourceNameBySchemaIndex(_In_ int indexInSchema,
     return HRESULT_FROM_WIN32(ERROR_MRM_NAMED_RESOURCE_NOT_FOUND);
 }
 
+HRESULT ResourceMapSubtree::FindDescendents(_In_ PCWSTR pPattern, _In_ IHierarchicalNamesVisitor* pVisitor) const
+{
+    RETURN_HR_IF(E_INVALIDARG, DefString_IsEmpty(pPattern));
+    RETURN_HR_IF_NULL(E_INVALIDARG, pVisitor);
+
+    return m_pSchema->FindNames(m_scopeIndex, pPattern, pVisitor);
+}
+
 // Gets the name of the resource relative to this scope
 HRESULT ResourceMapSubtree::GetDescendentResourceName(_In_ int index, _Inout_ StringResult* pNameOut) const
 {
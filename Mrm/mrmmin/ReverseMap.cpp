@@ -72,13 +72,52 @@ ReverseFileMap::~ReverseFileMap() { delete m_pNames; }
 
 const DEFFILE_SECTION_TYPEID ReverseFileMap::GetSectionTypeId() { return gReverseFileMapSectionType; }
 
+void ReverseFileMap::EnsurePathIndex() const
+{
+    // Only the first lookup pays for building the index.  If it can't be
+    // built, lookups keep walking the names tree.
+    if ((m_pNames->GetNumNames() >= MinNamesToIndex) && (InterlockedCompareExchange(&m_pathIndexRequested, 1, 0) == 0))
+    {
+        (void)m_pNames->EnablePathIndex();
+    }
+}
+
 bool ReverseFileMap::TryGetReverseMapCandidateIndex(__in PCWSTR pCandidateValue, __out int* pReverseMapIndexOut) const
 {
+    EnsurePathIndex();
+
     int scopeIndexOut;
     int nameIndexOut;
     return m_pNames->Contains(pCandidateValue, &scopeIndexOut, pReverseMapIndexOut, &nameIndexOut);
 }
 
+HRESULT ReverseFileMap::GetReverseMapCandidateIndexes(
+    _In_ int numCandidates,
+    _In_reads_(numCandidates) const PCWSTR* ppCandidateValues,
+    _Out_writes_(numCandidates) int* pReverseMapIndexesOut) const
+{
+    RETURN_HR_IF(E_INVALIDARG, numCandidates < 0);
+    RETURN_HR_IF(E_INVALIDARG, (numCandidates > 0) && ((ppCandidateValues == nullptr) || (pReverseMapIndexesOut == nullptr)));
+
+    EnsurePathIndex();
+
+    bool allFound = true;
+    for (int i = 0; i < numCandidates; i++)
+    {
+        int scopeIndex;
+        int nameIndex;
+        // Folders are in the names tree too, but only files are candidates
+        if ((ppCandidateValues[i] == nullptr) ||
+            !m_pNames->Contains(ppCandidateValues[i], &scopeIndex, &pReverseMapIndexesOut[i], &nameIndex) ||
+            (pReverseMapIndexesOut[i] < 0))
+        {
+            pReverseMapIndexesOut[i] = -1;
+            allFound = false;
+        }
+    }
+    return (allFound ? S_OK : S_FALSE);
+}
+
 HRESULT
 ReverseFileMap::GetCandidateInfo(_In_ int reverseMapIndex, _Out_ int* pQualifierSetIndexOut, _Out_ int* pNamedResourceIndexOut) const
 {
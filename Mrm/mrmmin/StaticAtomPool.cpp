@@ -45,6 +45,15 @@ HRESULT StaticAtomPool::CreateInstance(
     return S_OK;
 }
 
+StaticAtomPool::~StaticAtomPool()
+{
+    if (m_pLookupIndex != nullptr)
+    {
+        delete m_pLookupIndex;
+        m_pLookupIndex = nullptr;
+    }
+}
+
 bool StaticAtomPool::Contains(__in PCWSTR pString) const { return TryGetIndex(pString, NULL); }
 
 bool StaticAtomPool::Contains(__in Atom atom) const
@@ -113,6 +122,27 @@ bool StaticAtomPool::TryGetIndex(__in PCWSTR pString, __out_opt Atom::Index* pIn
         return false;
     }
 
+    const AtomHashIndex* pLookupIndex = AtomHashIndex::GetOrCreate(this, &m_pLookupIndex);
+    if (pLookupIndex != nullptr)
+    {
+        Atom::Hash hash = pLookupIndex->HashString(pString);
+        UINT32 slot = pLookupIndex->GetFirstSlot(hash);
+        Atom::Index i;
+        while (pLookupIndex->TryGetNextCandidate(hash, &slot, &i))
+        {
+            // The index only holds non-empty strings, so m_ppStrings[i] is valid here
+            if (DefString_CompareWithOptions(m_ppStrings[i], pString, m_compareOptions) == Def_Equal)
+            {
+                if (pIndexOut != NULL)
+                {
+                    *pIndexOut = i;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
     for (int i = 0; i < m_numStrings; i++)
     {
         if (DefString_CompareWithOptions(m_ppStrings[i], pString, m_compareOptions) == Def_Equal)
@@ -165,6 +165,94 @@ DefString_IsSuffixWithOptions(__in PCWSTR pSuffix, __in PCWSTR pString, __in DEF
 
 #define UNICODE_MAX_CODEPOINT 0x10FFFF
 
+#ifdef DEF_CPU_X86
+#include <immintrin.h>
+#endif
+
+// Narrows the longest prefix of pSrc made only of ASCII code units into pDest (if not null) and
+// returns its length. cchSrc must not include the null terminator.
+static size_t DefString_NarrowAsciiRunScalar(_In_reads_(cchSrc) PCWSTR pSrc, _In_ size_t cchSrc, _Out_writes_opt_(cchSrc) char* pDest)
+{
+    size_t i = 0;
+    while ((i < cchSrc) && (pSrc[i] <= ASCII_BOUNDARY))
+    {
+        if (pDest != nullptr)
+        {
+            pDest[i] = static_cast<char>(pSrc[i]);
+        }
+        i++;
+    }
+    return i;
+}
+
+#ifdef DEF_CPU_X86
+DEF_TARGET_SSE2
+static size_t DefString_NarrowAsciiRunSse2(_In_reads_(cchSrc) PCWSTR pSrc, _In_ size_t cchSrc, _Out_writes_opt_(cchSrc) char* pDest)
+{
+    const __m128i nonAsciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= cchSrc; i += 8)
+    {
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, nonAsciiMask), zero)) != 0xFFFF)
+        {
+            break;
+        }
+        if (pDest != nullptr)
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pDest + i), _mm_packus_epi16(units, units));
+        }
+    }
+
+    return i + DefString_NarrowAsciiRunScalar(pSrc + i, cchSrc - i, (pDest != nullptr) ? pDest + i : nullptr);
+}
+
+DEF_TARGET_AVX2
+static size_t DefString_NarrowAsciiRunAvx2(_In_reads_(cchSrc) PCWSTR pSrc, _In_ size_t cchSrc, _Out_writes_opt_(cchSrc) char* pDest)
+{
+    const __m256i nonAsciiMask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 16 <= cchSrc; i += 16)
+    {
+        __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i));
+        if (static_cast<UINT32>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(units, nonAsciiMask), zero))) != 0xFFFFFFFF)
+        {
+            break;
+        }
+        if (pDest != nullptr)
+        {
+            // packus works per 128-bit lane, so gather the low quadword of each lane into the low half.
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(units, units), 0xD8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + i), _mm256_castsi256_si128(packed));
+        }
+    }
+
+    return i + DefString_NarrowAsciiRunSse2(pSrc + i, cchSrc - i, (pDest != nullptr) ? pDest + i : nullptr);
+}
+#endif
+
+typedef size_t (*DefString_NarrowAsciiRunFunc)(PCWSTR, size_t, char*);
+
+static DefString_NarrowAsciiRunFunc DefString_GetNarrowAsciiRun()
+{
+#ifdef DEF_CPU_X86
+    DEF_CPU_FEATURES features = _DefGetCpuFeatures();
+    if (features & DEF_CPU_FEATURE_AVX2)
+    {
+        return DefString_NarrowAsciiRunAvx2;
+    }
+    if (features & DEF_CPU_FEATURE_SSE2)
+    {
+        return DefString_NarrowAsciiRunSse2;
+    }
+#endif
+    return DefString_NarrowAsciiRunScalar;
+}
+
 // Returns the encoding that results in the smallest needed buffer. Accounts for NULL terminator.
 // If ASCII is possible it picks ASCII over UTF8 because it is easier to decode.
 // If UTF8 and UTF16 produce the exact same size, it picks UTF16 because that is the encoding we use publicly.
@@ -173,51 +261,57 @@ DefString_IsSuffixWithOptions(__in PCWSTR pSuffix, __in PCWSTR pString, __in DEF
 // Why? Because we pass UTF-16 through without transformation (meaning invalid code points won't produce a break),
 // and we cannot block on invalid code points because we didn't do this in the past and want to avoid changing behavior.
 
-// This function is hand-rolled because it sits at a point in the stack where we cannot call many helpers.// This function is hand-rolled because it sits at a point in the stack where we cannot call many helpers,
-// and the helpers it can call (eg, RtlUTF8ToUnicodeN) are not available downlevel.
-DEFSTRING_ENCODING
-DefString_ChooseBestEncoding(_In_ PCWSTR pszStringUtf16)
+// Runs of ASCII are classified (and narrowed, when pDest is supplied) with the widest vector unit the
+// processor supports; everything else is encoded to UTF-8 by hand so this works without WideCharToMultiByte.
+// Once the UTF-8 form is known to be no smaller than the UTF-16 one the answer is UTF-16 regardless of the
+// rest of the string, so we stop there. That also guarantees that pDest never needs more than cbUtf16 bytes.
+// Since every remaining code unit needs at least one byte, the last such check also settles the final answer.
+static DEFSTRING_ENCODING DefString_ClassifyAndNarrow(
+    _In_reads_(cchString) PCWSTR pString,
+    _In_ size_t cchString,
+    _Out_writes_bytes_opt_((cchString + 1) * sizeof(WCHAR)) char* pDest,
+    _Out_ size_t* pcbUtf8)
 {
-    PCWSTR pszRemainingStringUtf16 = pszStringUtf16;
-    size_t cbStringUtf16;
+    static DefString_NarrowAsciiRunFunc const narrowAsciiRun = DefString_GetNarrowAsciiRun();
+
+    // + 1 to account for the NULL terminator.
+    const size_t cbStringUtf16 = (cchString + 1) * sizeof(WCHAR);
     size_t cbStringUtf8 = 1; // 1 to account for the single-byte NULL terminator.
     BOOL fAllAscii = TRUE;
+    size_t i = 0;
 
-    while (pszRemainingStringUtf16[0] != L'\0')
+    *pcbUtf8 = 0;
+
+    for (;;)
     {
+        size_t cchAscii = narrowAsciiRun(pString + i, cchString - i, (pDest != nullptr) ? pDest + cbStringUtf8 - 1 : nullptr);
+        i += cchAscii;
+        cbStringUtf8 += cchAscii;
 
-        UINT32 firstCodeUnitOfCurrentCharacter = (UINT32)pszRemainingStringUtf16[0];
+        if (i >= cchString)
+        {
+            break;
+        }
+
+        // Anything we reach here cannot be encoded as ASCII.
+        fAllAscii = FALSE;
+
+        UINT32 firstCodeUnitOfCurrentCharacter = (UINT32)pString[i];
+        UINT32 codePoint;
+        size_t cbCodePoint;
+        size_t cchCodePoint;
 
-        // See if it is in the basic multilingual plane.
         if (firstCodeUnitOfCurrentCharacter <= UTF16_BMP_FIRST_BATCH_END || firstCodeUnitOfCurrentCharacter >= UTF16_BMP_SECOND_BATCH_START)
         {
-            // It's a two byte UTF-16 character. Move string up one character.
-            pszRemainingStringUtf16++;
-
-            // Next we have to determine if it is a single, double, triple-byte UTF-8 character.
-            if (firstCodeUnitOfCurrentCharacter <= UTF8_ONE_BYTE_BOUNDARY)
-            {
-                // Single-byte UTF-8 strings are more efficiently encoded in ASCII, so leave fAllAscii as true;
-                cbStringUtf8++;
-            }
-            else if (firstCodeUnitOfCurrentCharacter <= UTF8_TWO_BYTE_BOUNDARY)
-            {
-                // We cannot encode characters above 127 as ASCII so disallow ASCII for the entire string.
-                fAllAscii = FALSE;
-                cbStringUtf8 += 2;
-            }
-            else
-            {
-                fAllAscii = FALSE;
-                cbStringUtf8 += 3;
-            }
+            codePoint = firstCodeUnitOfCurrentCharacter;
+            cchCodePoint = 1;
+            cbCodePoint = (codePoint <= UTF8_TWO_BYTE_BOUNDARY) ? 2 : 3;
         }
         else if (
             firstCodeUnitOfCurrentCharacter >= UTF_16_LEAD_SURROGATE_MIN_VALUE &&
-            firstCodeUnitOfCurrentCharacter <= UTF_16_LEAD_SURROGATE_MAX_VALUE)
+            firstCodeUnitOfCurrentCharacter <= UTF_16_LEAD_SURROGATE_MAX_VALUE && (i + 1 < cchString))
         {
-            // It's a four-byte UTF-8 and UTF-16 character.
-            UINT32 secondCodeUnitOfCurrentCharacter = (UINT32)pszRemainingStringUtf16[1];
+            UINT32 secondCodeUnitOfCurrentCharacter = (UINT32)pString[i + 1];
             if (secondCodeUnitOfCurrentCharacter < UTF_16_TRAIL_SURROGATE_MIN_VALUE ||
                 secondCodeUnitOfCurrentCharacter > UTF_16_TRAIL_SURROGATE_MAX_VALUE)
             {
@@ -225,36 +319,89 @@ DefString_ChooseBestEncoding(_In_ PCWSTR pszStringUtf16)
                 return DEFSTRING_ENCODING_UTF16;
             }
 
-            pszRemainingStringUtf16 += 2;
-
-            fAllAscii = FALSE;
-            cbStringUtf8 += 4;
+            codePoint = UTF_16_SUPPLEMENTARY_PLANES_START + ((firstCodeUnitOfCurrentCharacter - UTF_16_LEAD_SURROGATE_MIN_VALUE) << 10) +
+                        (secondCodeUnitOfCurrentCharacter - UTF_16_TRAIL_SURROGATE_MIN_VALUE);
+            cchCodePoint = 2;
+            cbCodePoint = 4;
         }
         else
         {
             // This is an invalid code point. Return UTF-16 to ensure the string is passed through the pipeline without processing.
             return DEFSTRING_ENCODING_UTF16;
         }
-    }
 
-    // + 1 to account for the NULL terminator.
-    cbStringUtf16 = (pszRemainingStringUtf16 - pszStringUtf16 + 1) * sizeof(pszStringUtf16[0]);
+        // Every code unit after this one needs at least one more byte of UTF-8.
+        if (cbStringUtf8 + cbCodePoint + (cchString - i - cchCodePoint) >= cbStringUtf16)
+        {
+            // UTF-8 can no longer win.
+            return DEFSTRING_ENCODING_UTF16;
+        }
 
-    if (fAllAscii)
-    {
+        if (pDest != nullptr)
+        {
+            BYTE* pOut = reinterpret_cast<BYTE*>(pDest + cbStringUtf8 - 1);
+            switch (cbCodePoint)
+            {
+            case 2:
+                pOut[0] = static_cast<BYTE>(0xC0 | (codePoint >> 6));
+                pOut[1] = static_cast<BYTE>(0x80 | (codePoint & 0x3F));
+                break;
+            case 3:
+                pOut[0] = static_cast<BYTE>(0xE0 | (codePoint >> 12));
+                pOut[1] = static_cast<BYTE>(0x80 | ((codePoint >> 6) & 0x3F));
+                pOut[2] = static_cast<BYTE>(0x80 | (codePoint & 0x3F));
+                break;
+            default:
+                pOut[0] = static_cast<BYTE>(0xF0 | (codePoint >> 18));
+                pOut[1] = static_cast<BYTE>(0x80 | ((codePoint >> 12) & 0x3F));
+                pOut[2] = static_cast<BYTE>(0x80 | ((codePoint >> 6) & 0x3F));
+                pOut[3] = static_cast<BYTE>(0x80 | (codePoint & 0x3F));
+                break;
+            }
+        }
 
-        return DEFSTRING_ENCODING_ASCII;
+        i += cchCodePoint;
+        cbStringUtf8 += cbCodePoint;
     }
-    else if (cbStringUtf16 <= cbStringUtf8)
+
+    if (pDest != nullptr)
     {
-        // If the strings are equal in size return UTF16 since it's easier to decode.
-        return DEFSTRING_ENCODING_UTF16;
+        pDest[cbStringUtf8 - 1] = '\0';
     }
-    else
-    {
+    *pcbUtf8 = cbStringUtf8;
+
+    // An all-ASCII string always fits; otherwise we only get here if UTF-8 is strictly smaller than UTF-16.
+    return fAllAscii ? DEFSTRING_ENCODING_ASCII : DEFSTRING_ENCODING_UTF8;
+}
+
+DEFSTRING_ENCODING
+DefString_ChooseBestEncoding(_In_ PCWSTR pszStringUtf16)
+{
+    size_t cbStringUtf8;
+    return DefString_ClassifyAndNarrow(pszStringUtf16, wcslen(pszStringUtf16), nullptr, &cbStringUtf8);
+}
+
+HRESULT
+DefString_ChooseBestEncodingAndNarrow(
+    _In_reads_(cchStringUtf16) PCWSTR pszStringUtf16,
+    _In_ size_t cchStringUtf16,
+    _Out_writes_bytes_to_(cbNarrowString, *pcbWrittenIncludingNull) char* pNarrowString,
+    _In_ size_t cbNarrowString,
+    _Out_ DEFSTRING_ENCODING* pEncoding,
+    _Out_ size_t* pcbWrittenIncludingNull)
+{
+    *pEncoding = DEFSTRING_ENCODING_UTF16;
+    *pcbWrittenIncludingNull = 0;
 
-        return DEFSTRING_ENCODING_UTF8;
+    size_t cbStringUtf16;
+    if ((cchStringUtf16 == SIZE_MAX) || FAILED(_DefSizeTMult(cchStringUtf16 + 1, sizeof(WCHAR), &cbStringUtf16)) ||
+        (cbNarrowString < cbStringUtf16))
+    {
+        return E_INVALIDARG;
     }
+
+    *pEncoding = DefString_ClassifyAndNarrow(pszStringUtf16, cchStringUtf16, pNarrowString, pcbWrittenIncludingNull);
+    return S_OK;
 }
 
 // Converts an ASCII encoded string into a UTF-16-encoded one.
@@ -35,6 +35,25 @@ namespace winrt::MrmLib::implementation
         const mrm::IResourceMapBase* map = nullptr;
         check_hresult(m_priFile->GetResourceMap(0, &map));
 
+        // Collect every resource name in one walk of the schema instead of
+        // rebuilding each name from its node up to the root.
+        struct ResourceNameCollector : mrm::IHierarchicalNamesVisitor
+        {
+            std::vector<hstring> names;
+
+            HRESULT VisitItem(int itemIndex, PCWSTR pName, int cchName) override
+            {
+                if ((itemIndex >= 0) && (static_cast<size_t>(itemIndex) < names.size()))
+                {
+                    names[itemIndex] = hstring(pName, cchName);
+                }
+                return S_OK;
+            }
+        } resourceNames;
+
+        resourceNames.names.resize(map->GetSchema()->GetNumItems());
+        check_hresult(map->GetSchema()->EnumerateNames(&resourceNames));
+
         mrm::NamedResourceResult namedResource;
         mrm::ResourceCandidateResult resCandidate;
 
@@ -42,15 +61,27 @@ namespace winrt::MrmLib::implementation
         for (int resIdx = 0; resIdx < map->GetNumResources(); resIdx++)
         {
             check_hresult(map->GetResourceByIndex(resIdx, &namedResource));
-            for (int candidateIdx = 0; candidateIdx < namedResource.GetNumCandidates(); candidateIdx++)
+
+            hstring name;
+            int indexInSchema = namedResource.GetResourceIndexInSchema();
+            if ((indexInSchema >= 0) && (static_cast<size_t>(indexInSchema) < resourceNames.names.size()))
             {
-                check_hresult(namedResource.GetCandidate(candidateIdx, &resCandidate));
+                name = resourceNames.names[indexInSchema];
+            }
 
+            if (name.empty())
+            {
                 mrm::StringResult str;
                 check_hresult(namedResource.GetResourceName(&str));
 
                 auto result = str.GetStringResult();
-                candidates.push_back(winrt::make<implementation::ResourceCandidate>(std::move(hstring(result->pRef, result->cchBuf - 1)), std::move(resCandidate), m_priFile->GetAtoms()));
+                name = hstring(result->pRef, result->cchBuf - 1);
+            }
+
+            for (int candidateIdx = 0; candidateIdx < namedResource.GetNumCandidates(); candidateIdx++)
+            {
+                check_hresult(namedResource.GetCandidate(candidateIdx, &resCandidate));
+                candidates.push_back(winrt::make<implementation::ResourceCandidate>(hstring(name), std::move(resCandidate), m_priFile->GetAtoms()));
             }
         }
 